@@ -28,6 +28,7 @@ augmentedStartingVariable(getStartingVariable()+"'") {
     AugmentedProductions startingProduction({startingProductionBody}, {EOS_MARKER});
     itemSet.insert({getAugmentedStartingVariable(), startingProduction});
     variables.insert(getAugmentedStartingVariable());
+    internedGrammar = InternedGrammar(*this);
 
     for(const auto &currentProductions : getProductionRules()) {
     std::vector<AugmentedProductionBody> bodies;
@@ -43,40 +44,37 @@ augmentedStartingVariable(getStartingVariable()+"'") {
 
 ItemSet AugmentedCFG::computeClosure(const ItemSet &givenItemSet) const {
     ItemSet result = givenItemSet;
+    // the lookaheads of every head as bitsets while the closure grows
+    std::map<std::string, SymbolSet> lookaheads;
+    for(const auto &currentProductions : result) {
+        lookaheads[currentProductions.first] = internedGrammar.toSymbolSet(currentProductions.second.lookaheads);
+    }
     bool changed = true;
     while(changed) {
         changed = false;
-        for (const auto &currentProductions: result) {
+        for (auto &currentProductions: result) {
+            const SymbolSet &headLookaheads = lookaheads.at(currentProductions.first);
+            if(headLookaheads.empty()) continue;
             for (const auto &currentBody: currentProductions.second.getBodies()) {
                 const std::string currentVariable = CFGUtils::getCurrentlyReadSymbol(currentBody);
-                    if (isVariable(currentVariable)) {
-                        const CFGProductionBodies &currentVariableBodies = getProductionBodies(currentVariable);
-                        for(const CFGProductionBody &currentVariableBody : currentVariableBodies) {
-                            const std::vector<std::string> &afterCurrentVariable = [&]() {
-                                const unsigned int &readingIndex = currentBody.getReadingIndex();
-                                const std::vector<std::string>& bodyContent =  currentBody.getContent();
-                                return std::vector<std::string>(bodyContent.begin()+readingIndex+1, bodyContent.end());
-                            }();
-                            std::set<std::vector<std::string>> concatenatedFirstElems;
-                            for(const std::string &currentLookahead : currentProductions.second.lookaheads) {
-                                std::vector<std::string> concatenatedFirstElem = afterCurrentVariable;
-                                concatenatedFirstElem.push_back(currentLookahead);
-                                concatenatedFirstElems.insert(concatenatedFirstElem);
-                            }
-                            for(const std::vector<std::string> &currentConcatElem : concatenatedFirstElems) {
-                                    for (const std::string &currentTerminal: computeFirstSet(currentConcatElem[0])) {
-                                        const AugmentedProductions &newProductions =
-                                                AugmentedProductions({AugmentedProductionBody(currentVariableBody)},
-                                                                     {currentTerminal});
-                                        changed = changed ||
-                                                  CFGUtils::addToItemSet(result, {currentVariable, newProductions});
-                                    }
-                            }
-                        }
-                    }
+                if (!isVariable(currentVariable)) continue;
+                // the lookaheads of the variable come from the symbol after it, or are the ones of the head if there is none
+                const unsigned int readingIndex = currentBody.getReadingIndex();
+                const SymbolSet &newLookaheads = readingIndex + 1 < currentBody.getContent().size()
+                        ? internedGrammar.getFirstSet(internedGrammar.getId(currentBody.getContent()[readingIndex + 1]))
+                        : headLookaheads;
+                if(newLookaheads.empty()) continue;
+                for(const CFGProductionBody &currentVariableBody : getProductionBodies(currentVariable)) {
+                    const AugmentedProductions newProductions({AugmentedProductionBody(currentVariableBody)});
+                    if(CFGUtils::addToItemSet(result, {currentVariable, newProductions})) changed = true;
+                }
+                if(lookaheads.try_emplace(currentVariable, internedGrammar.size()).first->second.unite(newLookaheads)) changed = true;
             }
         }
     }
+    for(auto &currentProductions : result) {
+        currentProductions.second.lookaheads = internedGrammar.toStrings(lookaheads.at(currentProductions.first));
+    }
     return result;
 }
 ItemSet AugmentedCFG::computeGoto(const ItemSet &givenItemSet, const std::string &givenSymbol) const {
@@ -37,6 +37,7 @@ CFG::CFG(const std::set<std::string> &variables_arg,
 
     std::string errorMessage;
     if(!isValid(errorMessage)) throw std::invalid_argument(errorMessage.c_str());
+    internedGrammar = InternedGrammar(*this);
 }
 CFG::CFG(const std::string &jsonPath){
     std::ifstream input(jsonPath);
@@ -56,6 +57,7 @@ CFG::CFG(const std::string &jsonPath){
 
     std::string errorMessage;
     if(!isValid(errorMessage)) throw std::invalid_argument(errorMessage.c_str());
+    internedGrammar = InternedGrammar(*this);
 }
 bool CFG::isValid(std::string &errorMessageRef) const {
     std::string errorMessage;
@@ -105,18 +107,9 @@ CFGProductionBodies CFG::getProductionBodies(const std::string &productionHead)
     return {};
 }
 std::set<std::string> CFG::computeFirstSet(const std::string &variable) const {
-    std::set<std::string> result;
     if(!isVariable(variable))
         return {variable};
-    for(const CFGProductionBody &currentBody : getProductionBodies(variable)) {
-        const std::set<std::string> &set = computeFirstSet(currentBody[0]);
-        if(set.find("") != set.end() && currentBody.size() > 1) {
-            const std::set<std::string> &nextSet = computeFirstSet(currentBody[1]);
-            result.insert(nextSet.begin(), nextSet.end());
-        }
-        result.insert(set.begin(), set.end());
-    }
-    return result;
+    return internedGrammar.toStrings(internedGrammar.getFirstSet(internedGrammar.getId(variable)));
 }
 
 std::map<std::string, std::set<std::string>> CFG::computeFirstSets() const {
@@ -126,3 +119,10 @@ std::map<std::string, std::set<std::string>> CFG::computeFirstSets() const {
     }
     return result;
 }
+std::map<std::string, std::set<std::string>> CFG::computeFollowSets() const {
+    std::map<std::string, std::set<std::string>> result;
+    for(const std::string &currentVariable : getVariables()) {
+        result[currentVariable] = internedGrammar.toStrings(internedGrammar.getFollowSet(internedGrammar.getId(currentVariable)));
+    }
+    return result;
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include "InternedGrammar.h"
 
 #define EOS_MARKER "<EOS>"
 #define ERR_MARKER "<ERR>"
@@ -25,6 +26,8 @@ protected:
     std::set<std::string> terminals;
     CFGProductionRules production_rules; // key: head : array of bodies
     std::string starting_variable;
+    // rebuilt whenever the symbols or productions change
+    InternedGrammar internedGrammar;
 
 public:
     CFG(const std::set<std::string> &variables_arg,
@@ -44,9 +47,12 @@ public:
     std::string getStartingVariable() const;
     CFGProductionBodies getProductionBodies(const std::string &productionHead) const;
 
+    const InternedGrammar& getInternedGrammar() const {return internedGrammar;}
+
     std::set<std::string> computeFirstSet(const std::string &variable) const;
 
     std::map<std::string, std::set<std::string>> computeFirstSets() const;
+    std::map<std::string, std::set<std::string>> computeFollowSets() const;
 };
 
 
@@ -0,0 +1,125 @@
+//
+
+#include "InternedGrammar.h"
+#include "CFG.h"
+#include <stdexcept>
+
+bool SymbolSet::insert(unsigned int symbol) {
+    const bool isNew = !contains(symbol);
+    words[symbol / 64] |= uint64_t(1) << (symbol % 64);
+    return isNew;
+}
+bool SymbolSet::unite(const SymbolSet &other) {
+    bool changed = false;
+    for(unsigned int i = 0; i < words.size(); i++) {
+        changed = changed || (other.words[i] & ~words[i]) != 0;
+        words[i] |= other.words[i];
+    }
+    return changed;
+}
+bool SymbolSet::empty() const {
+    for(const uint64_t word : words) {
+        if(word != 0) return false;
+    }
+    return true;
+}
+
+unsigned int InternedGrammar::intern(const std::string &symbol, bool isVariable) {
+    const auto found = ids.find(symbol);
+    if(found != ids.end()) return found->second;
+    ids.insert({symbol, symbols.size()});
+    symbols.push_back(symbol);
+    variables.push_back(isVariable);
+    return symbols.size() - 1;
+}
+
+InternedGrammar::InternedGrammar(const CFG &cfg) {
+    for(const std::string &symbol : cfg.getAllSymbols()) intern(symbol, cfg.isVariable(symbol));
+    grammarSymbolCount = symbols.size();
+    intern("", false);
+    intern(EOS_MARKER, false);
+
+    productions.resize(symbols.size());
+    for(const auto &currentRule : cfg.getProductionRules()) {
+        for(const CFGProductionBody &body : currentRule.second) {
+            std::vector<unsigned int> internedBody;
+            for(const std::string &symbol : body) internedBody.push_back(getId(symbol));
+            productions[getId(currentRule.first)].push_back(internedBody);
+        }
+    }
+    computeFirstSets();
+    computeFollowSets(getId(cfg.getStartingVariable()));
+    // the empty string is only added now, so it does not end up in FOLLOW sets
+    for(unsigned int symbol = 0; symbol < symbols.size(); symbol++) {
+        if(nullable[symbol]) firstSets[symbol].insert(getId(""));
+    }
+}
+
+void InternedGrammar::computeFirstSets() {
+    nullable.assign(symbols.size(), false);
+    nullable[getId("")] = true;
+    firstSets.assign(symbols.size(), SymbolSet(symbols.size()));
+    for(unsigned int symbol = 0; symbol < symbols.size(); symbol++) {
+        if(!variables[symbol] && symbol != getId("")) firstSets[symbol].insert(symbol);
+    }
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(unsigned int head = 0; head < symbols.size(); head++) {
+            for(const std::vector<unsigned int> &body : productions[head]) {
+                // everything a nullable prefix of the body can start with, and the symbol after it
+                bool isBodyNullable = true;
+                for(const unsigned int symbol : body) {
+                    if(firstSets[head].unite(firstSets[symbol])) changed = true;
+                    if(!nullable[symbol]) {
+                        isBodyNullable = false;
+                        break;
+                    }
+                }
+                if(isBodyNullable && !nullable[head]) {
+                    nullable[head] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void InternedGrammar::computeFollowSets(unsigned int startingVariable) {
+    followSets.assign(symbols.size(), SymbolSet(symbols.size()));
+    followSets[startingVariable].insert(getId(EOS_MARKER));
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(unsigned int head = 0; head < symbols.size(); head++) {
+            for(const std::vector<unsigned int> &body : productions[head]) {
+                // what can follow the symbol at the current position, going from the end of the body to its start
+                SymbolSet trailer = followSets[head];
+                for(auto symbol = body.rbegin(); symbol != body.rend(); symbol++) {
+                    if(variables[*symbol] && followSets[*symbol].unite(trailer)) changed = true;
+                    if(!nullable[*symbol]) trailer = firstSets[*symbol];
+                    else trailer.unite(firstSets[*symbol]);
+                }
+            }
+        }
+    }
+}
+
+unsigned int InternedGrammar::getId(const std::string &symbol) const {
+    const auto found = ids.find(symbol);
+    if(found == ids.end()) throw std::invalid_argument("Unknown grammar symbol '" + symbol + "'");
+    return found->second;
+}
+
+SymbolSet InternedGrammar::toSymbolSet(const std::set<std::string> &symbolNames) const {
+    SymbolSet set(symbols.size());
+    for(const std::string &symbol : symbolNames) set.insert(getId(symbol));
+    return set;
+}
+std::set<std::string> InternedGrammar::toStrings(const SymbolSet &set) const {
+    std::set<std::string> result;
+    for(unsigned int symbol = 0; symbol < symbols.size(); symbol++) {
+        if(set.contains(symbol)) result.insert(symbols[symbol]);
+    }
+    return result;
+}
@@ -0,0 +1,81 @@
+//
+
+#ifndef VOXELFUSION_INTERNEDGRAMMAR_H
+#define VOXELFUSION_INTERNEDGRAMMAR_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class CFG;
+
+/**
+ * @brief A set of the numbered symbols of a grammar, one bit per symbol
+ */
+class SymbolSet {
+    std::vector<uint64_t> words;
+public:
+    SymbolSet() = default;
+    explicit SymbolSet(unsigned int symbolCount) : words((symbolCount + 63) / 64) {}
+
+    [[nodiscard]] bool contains(unsigned int symbol) const {return (words[symbol / 64] >> (symbol % 64)) & 1u;}
+    /**
+     * @return Whether the symbol was not in the set yet
+     */
+    bool insert(unsigned int symbol);
+    void erase(unsigned int symbol) {words[symbol / 64] &= ~(uint64_t(1) << (symbol % 64));}
+    /**
+     * @return Whether any symbol of the other set was not in this one yet
+     */
+    bool unite(const SymbolSet &other);
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] const std::vector<uint64_t>& getWords() const {return words;}
+
+    bool operator==(const SymbolSet &other) const {return words == other.words;}
+};
+
+/**
+ * @brief The symbols of a CFG numbered in sorted order, followed by the empty string of epsilon bodies
+ * and the end of input marker, with the nullable symbols and the FIRST and FOLLOW sets of every symbol.
+ * The sets are computed once, by iterating over all productions until they stop growing
+ */
+class InternedGrammar {
+    std::vector<std::string> symbols;
+    std::map<std::string, unsigned int> ids;
+    std::vector<bool> variables;
+    unsigned int grammarSymbolCount = 0;
+    // by head
+    std::vector<std::vector<std::vector<unsigned int>>> productions;
+    std::vector<bool> nullable;
+    // contain the empty string for nullable symbols
+    std::vector<SymbolSet> firstSets;
+    std::vector<SymbolSet> followSets;
+
+    unsigned int intern(const std::string &symbol, bool isVariable);
+    void computeFirstSets();
+    void computeFollowSets(unsigned int startingVariable);
+public:
+    InternedGrammar() = default;
+    explicit InternedGrammar(const CFG &cfg);
+
+    [[nodiscard]] unsigned int size() const {return symbols.size();}
+    /**
+     * @return The number of variables and terminals, which come before the empty string and end of input marker
+     */
+    [[nodiscard]] unsigned int getGrammarSymbolCount() const {return grammarSymbolCount;}
+    [[nodiscard]] unsigned int getId(const std::string &symbol) const;
+    [[nodiscard]] const std::string& getSymbol(unsigned int id) const {return symbols[id];}
+    [[nodiscard]] bool isVariable(unsigned int id) const {return variables[id];}
+    [[nodiscard]] bool isNullable(unsigned int id) const {return nullable[id];}
+
+    [[nodiscard]] const SymbolSet& getFirstSet(unsigned int id) const {return firstSets[id];}
+    [[nodiscard]] const SymbolSet& getFollowSet(unsigned int id) const {return followSets[id];}
+
+    [[nodiscard]] SymbolSet toSymbolSet(const std::set<std::string> &symbolNames) const;
+    [[nodiscard]] std::set<std::string> toStrings(const SymbolSet &set) const;
+};
+
+
+#endif //VOXELFUSION_INTERNEDGRAMMAR_H
@@ -4,20 +4,16 @@
 #define VOXELFUSION_ACTION_H
 
 #include "CFG/AugmentedCFG.h"
-#include "LR1ParsingSpace.h"
+#include "SyntaxTree/SyntaxTree.h"
 
 #include "json.hpp"
 
-class LR1ParseTableEntry;
-
-// LR parsing actions using functors
+// LR parsing actions as the parse table is built, imported and exported, CompiledParseTable packs them for parsing
 class Action {
 public:
     virtual ~Action() = default;
     void print() const;
     virtual std::string getString() const = 0;
-    virtual void operator()(LR1ParsingSpace &parsingSpace,
-            const std::map<unsigned int, LR1ParseTableEntry> &parsingTable) const = 0;
     virtual nlohmann::json getJson() const = 0;
 };
 
@@ -25,8 +21,6 @@ class Reduce : public Action {
 public:
     const CFGProductionBody body;
     const std::string head;
-    void operator()(LR1ParsingSpace &parsingSpace,
-            const std::map<unsigned int, LR1ParseTableEntry> &parsingTable) const final;
     std::string getString() const final;
     nlohmann::json getJson() const final;
     explicit Reduce(const std::string &head, const CFGProductionBody &body) : head(head), body(body) {}
@@ -35,8 +29,6 @@ public:
 class Shift : public Action {
 public:
     const unsigned int index;
-    void operator()(LR1ParsingSpace &parsingSpace,
-            const std::map<unsigned int, LR1ParseTableEntry> &parsingTable) const final;
     std::string getString() const final;
     nlohmann::json getJson() const final;
     explicit Shift(const unsigned int &index) : index(index) {}
@@ -44,8 +36,6 @@ public:
 
 class Accept : public Action {
 public:
-    void operator()(LR1ParsingSpace &parsingSpace,
-            const std::map<unsigned int, LR1ParseTableEntry> &parsingTable) const final;
     std::string getString() const final;
     nlohmann::json getJson() const final;
 };
@@ -0,0 +1,137 @@
+//
+
+#include "CanonicalCollection.h"
+#include <unordered_map>
+
+bool CanonicalCollection::isEmpty(const uint64_t *bits, unsigned int words) {
+    for(unsigned int i = 0; i < words; i++) {
+        if(bits[i] != 0) return false;
+    }
+    return true;
+}
+bool CanonicalCollection::unite(uint64_t *bits, const uint64_t *other, unsigned int words) {
+    bool changed = false;
+    for(unsigned int i = 0; i < words; i++) {
+        changed = changed || (other[i] & ~bits[i]) != 0;
+        bits[i] |= other[i];
+    }
+    return changed;
+}
+
+size_t CanonicalCollection::BitsHash::operator()(const Bits &bits) const {
+    uint64_t hash = 14695981039346656037u;
+    for(const Bitset *bitset : {&bits.items, &bits.lookaheads}) {
+        for(const uint64_t word : *bitset) hash = (hash ^ word) * 1099511628211u;
+    }
+    return hash;
+}
+
+CanonicalCollection::CanonicalCollection(const AugmentedCFG &cfg) : cfg(cfg), grammar(cfg.getInternedGrammar()),
+symbolWords((grammar.size() + 63) / 64) {
+    CFGProductionRules rules = cfg.getProductionRules();
+    rules[cfg.getAugmentedStartingVariable()] = {{cfg.getStartingVariable()}};
+    startItems.resize(grammar.size());
+    for(const auto &currentRule : rules) {
+        const unsigned int head = grammar.getId(currentRule.first);
+        for(const CFGProductionBody &body : currentRule.second) {
+            const unsigned int production = bodies.size();
+            productionIds.insert({{currentRule.first, body}, production});
+            bodies.push_back(body);
+            firstItems.push_back(items.size());
+            startItems[head].push_back(items.size());
+            for(unsigned int i = 0; i <= body.size(); i++) {
+                items.push_back({head, production, i, i < body.size() ? (int) grammar.getId(body[i]) : -1});
+            }
+        }
+    }
+}
+
+CanonicalCollection::Bits CanonicalCollection::toBits(const ItemSet &itemSet) const {
+    Bits bits{Bitset((items.size() + 63) / 64), Bitset(grammar.size() * symbolWords)};
+    for(const auto &currentProductions : itemSet) {
+        for(const AugmentedProductionBody &body : currentProductions.second.bodies) {
+            setBit(bits.items, firstItems[productionIds.at({currentProductions.first, body.content})] + body.readingIndex);
+        }
+        const unsigned int head = grammar.getId(currentProductions.first);
+        for(const std::string &lookahead : currentProductions.second.lookaheads) {
+            setBit(bits.lookaheads, head * symbolWords * 64 + grammar.getId(lookahead));
+        }
+    }
+    return bits;
+}
+
+ItemSet CanonicalCollection::toItemSet(const Bits &bits) const {
+    ItemSet itemSet;
+    for(unsigned int i = 0; i < items.size(); i++) {
+        if(!testBit(bits.items, i)) continue;
+        const Item &item = items[i];
+        const auto found = itemSet.find(grammar.getSymbol(item.head));
+        if(found != itemSet.end()) {
+            found->second.bodies.emplace_back(bodies[item.production], item.readingIndex);
+            continue;
+        }
+        std::set<std::string> lookaheads;
+        for(unsigned int symbol = 0; symbol < grammar.size(); symbol++) {
+            if(testBit(bits.lookaheads, item.head * symbolWords * 64 + symbol)) lookaheads.insert(grammar.getSymbol(symbol));
+        }
+        itemSet.insert({grammar.getSymbol(item.head), AugmentedProductions({{bodies[item.production], item.readingIndex}}, lookaheads)});
+    }
+    return itemSet;
+}
+
+// the same closure as AugmentedCFG::computeClosure: the lookaheads of a variable read by an item come from the symbol
+// after it, or from the lookaheads of the item's head if it is the last one
+void CanonicalCollection::close(Bits &bits) const {
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(unsigned int i = 0; i < items.size(); i++) {
+            const Item &item = items[i];
+            if(item.readSymbol < 0 || !grammar.isVariable(item.readSymbol) || !testBit(bits.items, i)) continue;
+            const uint64_t *headLookaheads = &bits.lookaheads[item.head * symbolWords];
+            if(isEmpty(headLookaheads, symbolWords)) continue;
+            const CFGProductionBody &body = bodies[item.production];
+            const uint64_t *added = item.readingIndex + 1 < body.size()
+                    ? firstSet(items[i + 1].readSymbol) : headLookaheads;
+            if(isEmpty(added, symbolWords)) continue;
+            for(const unsigned int startItem : startItems[item.readSymbol]) {
+                if(testBit(bits.items, startItem)) continue;
+                setBit(bits.items, startItem);
+                changed = true;
+            }
+            if(unite(&bits.lookaheads[item.readSymbol * symbolWords], added, symbolWords)) changed = true;
+        }
+    }
+}
+
+CanonicalCollection::Bits CanonicalCollection::goTo(const Bits &bits, unsigned int symbol) const {
+    Bits result{Bitset(bits.items.size()), Bitset(bits.lookaheads.size())};
+    for(unsigned int i = 0; i < items.size(); i++) {
+        if(items[i].readSymbol != (int) symbol || !testBit(bits.items, i)) continue;
+        // the next item is the same production read one symbol further
+        setBit(result.items, i + 1);
+        const unsigned int head = items[i].head;
+        unite(&result.lookaheads[head * symbolWords], &bits.lookaheads[head * symbolWords], symbolWords);
+    }
+    return result;
+}
+
+void CanonicalCollection::build(std::vector<ItemSet> &itemSets,
+                                std::map<unsigned int, std::map<std::string, unsigned int>> &transitions) const {
+    std::vector<Bits> found{toBits(cfg.getItemSet())};
+    std::unordered_map<Bits, unsigned int, BitsHash> foundIndices{{found[0], 0}};
+    // every item set is expanded once, in the order they are found
+    for(unsigned int i = 0; i < found.size(); i++) {
+        for(unsigned int symbol = 0; symbol < grammar.getGrammarSymbolCount(); symbol++) {
+            Bits next = goTo(found[i], symbol);
+            if(isEmpty(next.items.data(), next.items.size())) continue;
+            close(next);
+            const auto inserted = foundIndices.insert({next, found.size()});
+            if(inserted.second) found.push_back(std::move(next));
+            transitions[i].insert({grammar.getSymbol(symbol), inserted.first->second});
+        }
+    }
+    itemSets.clear();
+    itemSets.reserve(found.size());
+    for(const Bits &bits : found) itemSets.push_back(toItemSet(bits));
+}
@@ -0,0 +1,70 @@
+//
+
+#ifndef VOXELFUSION_CANONICALCOLLECTION_H
+#define VOXELFUSION_CANONICALCOLLECTION_H
+
+#include "CFG/AugmentedCFG.h"
+
+#include <cstdint>
+#include <map>
+
+/**
+ * @brief Builds the canonical collection of LR(1) item sets of an augmented grammar with a worklist.
+ * Symbols are numbered by the interned grammar, items are numbered production after production and an item set is a bitset of its items
+ * with a bitset of lookaheads per variable, so equal item sets have equal bits and are found again by their hash
+ */
+class CanonicalCollection {
+protected:
+    typedef std::vector<uint64_t> Bitset;
+    struct Bits {
+        Bitset items;
+        // the lookaheads of every symbol that heads items, one after the other
+        Bitset lookaheads;
+        bool operator==(const Bits &other) const {return items == other.items && lookaheads == other.lookaheads;}
+    };
+    struct BitsHash {
+        size_t operator()(const Bits &bits) const;
+    };
+    struct Item {
+        unsigned int head;
+        unsigned int production;
+        unsigned int readingIndex;
+        // -1 once the whole body is read
+        int readSymbol;
+    };
+
+    static bool isEmpty(const uint64_t *bits, unsigned int words);
+    // returns true if any bit was new
+    static bool unite(uint64_t *bits, const uint64_t *other, unsigned int words);
+    static bool testBit(const Bitset &bits, unsigned int index) {return (bits[index / 64] >> (index % 64)) & 1u;}
+    static void setBit(Bitset &bits, unsigned int index) {bits[index / 64] |= uint64_t(1) << (index % 64);}
+
+    const AugmentedCFG &cfg;
+    // the symbols of the grammar come first, which are the ones item sets have transitions on
+    const InternedGrammar &grammar;
+    // the number of words in a bitset of symbols
+    unsigned int symbolWords = 0;
+    std::vector<CFGProductionBody> bodies;
+    std::map<std::pair<std::string, CFGProductionBody>, unsigned int> productionIds;
+    std::vector<unsigned int> firstItems;
+    std::vector<Item> items;
+    // by symbol, the first item of each of its productions
+    std::vector<std::vector<unsigned int>> startItems;
+
+    const uint64_t* firstSet(unsigned int symbol) const {return grammar.getFirstSet(symbol).getWords().data();}
+    [[nodiscard]] Bits toBits(const ItemSet &itemSet) const;
+    [[nodiscard]] ItemSet toItemSet(const Bits &bits) const;
+    void close(Bits &bits) const;
+    [[nodiscard]] Bits goTo(const Bits &bits, unsigned int symbol) const;
+public:
+    explicit CanonicalCollection(const AugmentedCFG &cfg);
+
+    /**
+     * @brief Finds every item set reachable from the one of the grammar, numbered in the order they are found
+     * with the transitions between them by symbol
+     */
+    void build(std::vector<ItemSet> &itemSets, std::map<unsigned int, std::map<std::string, unsigned int>> &transitions) const;
+};
+
+
+#endif //VOXELFUSION_CANONICALCOLLECTION_H
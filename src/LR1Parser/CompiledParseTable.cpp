@@ -0,0 +1,128 @@
+//
+
+#include "CompiledParseTable.h"
+#include "LR1Parser.h"
+
+#include <stdexcept>
+
+CompiledParseTable::CompiledParseTable(const LR1ParseTable &table) {
+    std::map<std::string, unsigned int> terminalIds, variableIds;
+    std::map<std::pair<std::string, CFGProductionBody>, unsigned int> productionIds;
+    const auto intern = [](std::map<std::string, unsigned int> &ids, std::vector<std::string> &names, const std::string &name) {
+        const auto [found, inserted] = ids.insert({name, (unsigned int) names.size()});
+        if(inserted) names.push_back(name);
+        return found->second;
+    };
+    for(const auto &[state, entry] : table) {
+        stateCount = std::max(stateCount, state + 1);
+        for(const auto &[terminal, action] : entry.actionMap) intern(terminalIds, terminals, terminal);
+        for(const auto &[variable, next] : entry.gotoMap) intern(variableIds, variables, variable);
+        for(const auto &[terminal, action] : entry.actionMap) {
+            if(const auto *reduce = dynamic_cast<const Reduce *>(action.get())) intern(variableIds, variables, reduce->head);
+        }
+    }
+    terminals.emplace_back();
+    indexTerminals(terminalIds);
+
+    actions.assign(stateCount * terminals.size(), Action_Error);
+    gotos.assign(stateCount * variables.size(), NoGoto);
+    for(const auto &[state, entry] : table) {
+        for(const auto &[terminal, action] : entry.actionMap) {
+            uint32_t &packed = actions[state * terminals.size() + terminalIds.at(terminal)];
+            if(const auto *shift = dynamic_cast<const Shift *>(action.get())) packed = shift->index << 2 | Action_Shift;
+            else if(const auto *reduce = dynamic_cast<const Reduce *>(action.get())) {
+                const auto [found, inserted] = productionIds.insert({{reduce->head, reduce->body}, (unsigned int) productions.size()});
+                if(inserted) productions.push_back({variableIds.at(reduce->head), (unsigned int) reduce->body.size()});
+                packed = found->second << 2 | Action_Reduce;
+            }
+            else packed = Action_Accept;
+        }
+        for(const auto &[variable, next] : entry.gotoMap) gotos[state * variables.size() + variableIds.at(variable)] = (int) next;
+    }
+}
+
+CompiledParseTable::CompiledParseTable(std::vector<std::string> terminals, std::vector<std::string> variables,
+                                       std::vector<uint32_t> actions, std::vector<int> gotos, std::vector<Production> productions)
+        : stateCount(actions.size() / terminals.size()), terminals(std::move(terminals)), variables(std::move(variables)),
+          actions(std::move(actions)), gotos(std::move(gotos)), productions(std::move(productions)) {
+    std::map<std::string, unsigned int> terminalIds;
+    for(unsigned int i = 0; i + 1 < this->terminals.size(); i++) terminalIds[this->terminals[i]] = i;
+    indexTerminals(terminalIds);
+}
+
+void CompiledParseTable::indexTerminals(const std::map<std::string, unsigned int> &terminalIds) {
+    terminalsByType.fill(-1);
+    for(const auto &[type, name] : TokenMapping::terminals) {
+        const auto found = terminalIds.find(name);
+        terminalsByType[type] = found != terminalIds.end() ? (int) found->second : (int) terminals.size() - 1;
+    }
+    for(const auto &[terminal, id] : terminalIds) terminalsByLexeme.insert({terminal, id});
+}
+
+void CompiledParseTable::writeSource(std::ostream &output, const std::string &grammarPath) const {
+    const auto writeArray = [&output](const std::string &declaration, const auto &values, const auto &writeValue) {
+        output << "    constexpr " << declaration << "[] = {";
+        for(size_t i = 0; i < values.size(); i++) {
+            output << (i % 16 == 0 ? "\n            " : " ");
+            writeValue(values[i]);
+            output << ',';
+        }
+        output << "\n    };\n";
+    };
+    const auto writeString = [&output](const std::string &name) {
+        output << '"';
+        for(const char c : name) {
+            if(c == '"' || c == '\\') output << '\\';
+            output << c;
+        }
+        output << '"';
+    };
+    const auto writeNumber = [&output](const auto &number) {output << number;};
+    output << "// generated from " << grammarPath << " at build time, do not edit\n\n"
+           << "#include \"LR1Parser/CompiledParseTable.h\"\n\n"
+           << "#include <iterator>\n\n"
+           << "namespace {\n";
+    writeArray("const char *terminalNames", terminals, writeString);
+    writeArray("const char *variableNames", variables, writeString);
+    writeArray("uint32_t packedActions", actions, writeNumber);
+    writeArray("int gotoStates", gotos, writeNumber);
+    writeArray("CompiledParseTable::Production productionShapes", productions, [&output](const Production &production) {
+        output << '{' << production.head << ", " << production.bodyLength << '}';
+    });
+    output << "}\n\n"
+           << "const CompiledParseTable& CompiledParseTable::tasm() {\n"
+           << "    static const CompiledParseTable table({std::begin(terminalNames), std::end(terminalNames)}, {std::begin(variableNames), std::end(variableNames)},\n"
+           << "                                          {std::begin(packedActions), std::end(packedActions)}, {std::begin(gotoStates), std::end(gotoStates)},\n"
+           << "                                          {std::begin(productionShapes), std::end(productionShapes)});\n"
+           << "    return table;\n"
+           << "}\n";
+}
+
+unsigned int CompiledParseTable::terminalOf(const TokenView &token) const {
+    if(terminalsByType[token.type] >= 0) return terminalsByType[token.type];
+    const auto found = terminalsByLexeme.find(token.lexeme);
+    return found != terminalsByLexeme.end() ? found->second : (unsigned int) terminals.size() - 1;
+}
+
+uint64_t CompiledParseTable::hash() const {
+    uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](const void *data, size_t size) {
+        for(size_t i = 0; i < size; i++) {
+            hash ^= static_cast<const unsigned char*>(data)[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for(const std::vector<std::string> *names : {&terminals, &variables}) {
+        const uint64_t count = names->size();
+        add(&count, sizeof(count));
+        // the terminating zeros keep names apart
+        for(const std::string &name : *names) add(name.c_str(), name.size() + 1);
+    }
+    add(actions.data(), actions.size() * sizeof(uint32_t));
+    add(gotos.data(), gotos.size() * sizeof(int));
+    for(const Production &production : productions) {
+        add(&production.head, sizeof(production.head));
+        add(&production.bodyLength, sizeof(production.bodyLength));
+    }
+    return hash;
+}
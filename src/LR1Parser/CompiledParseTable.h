@@ -0,0 +1,82 @@
+//
+
+#ifndef VOXELFUSION_COMPILEDPARSETABLE_H
+#define VOXELFUSION_COMPILEDPARSETABLE_H
+
+#include "Lexer/Lexer.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class LR1ParseTableEntry;
+typedef std::map<unsigned int, LR1ParseTableEntry> LR1ParseTable;
+
+/**
+ * @brief An LR parse table in a form that is cheap to look up while parsing:
+ * terminals and variables are numbered, every action is packed into one word of a flat state by terminal array,
+ * gotos are a flat state by variable array and productions are kept as their head and the length of their body
+ */
+class CompiledParseTable {
+public:
+    enum ActionKind : uint32_t {Action_Error, Action_Shift, Action_Reduce, Action_Accept};
+    struct Production {
+        unsigned int head;
+        unsigned int bodyLength;
+    };
+    static constexpr int NoGoto = -1;
+private:
+    unsigned int stateCount = 0;
+    // the last terminal stands for every lexeme the grammar does not know, it has no actions
+    std::vector<std::string> terminals;
+    std::vector<std::string> variables;
+    // terminals that are told apart by their lexeme, for the others by type
+    std::map<std::string, unsigned int, std::less<>> terminalsByLexeme;
+    std::array<int, Token_EOS + 1> terminalsByType{};
+    // the low two bits are the ActionKind, the others the next state or the production
+    std::vector<uint32_t> actions;
+    std::vector<int> gotos;
+    std::vector<Production> productions;
+
+    void indexTerminals(const std::map<std::string, unsigned int> &terminalIds);
+public:
+    CompiledParseTable() = default;
+    explicit CompiledParseTable(const LR1ParseTable &table);
+    /**
+     * @param terminals The names of the terminals, the last one being the empty name of unknown lexemes
+     */
+    CompiledParseTable(std::vector<std::string> terminals, std::vector<std::string> variables, std::vector<uint32_t> actions,
+                       std::vector<int> gotos, std::vector<Production> productions);
+
+    /**
+     * @brief The table of the TASM grammar, generated from src/CFG/input/Tasm.json at build time
+     */
+    static const CompiledParseTable& tasm();
+    /**
+     * @brief Writes a C++ source file that defines tasm() as this table
+     */
+    void writeSource(std::ostream &output, const std::string &grammarPath) const;
+
+    static ActionKind kindOf(uint32_t action) {return ActionKind(action & 3);}
+    static unsigned int operandOf(uint32_t action) {return action >> 2;}
+
+    [[nodiscard]] unsigned int terminalOf(const TokenView &token) const;
+    [[nodiscard]] uint32_t action(unsigned int state, unsigned int terminal) const {return actions[state * terminals.size() + terminal];}
+    [[nodiscard]] int goTo(unsigned int state, unsigned int variable) const {return gotos[state * variables.size() + variable];}
+    [[nodiscard]] const Production& production(unsigned int index) const {return productions[index];}
+    [[nodiscard]] const std::string& terminalName(unsigned int terminal) const {return terminals[terminal];}
+    [[nodiscard]] const std::string& variableName(unsigned int variable) const {return variables[variable];}
+    [[nodiscard]] unsigned int variableCount() const {return variables.size();}
+    [[nodiscard]] bool empty() const {return stateCount == 0;}
+    /**
+     * @brief The FNV-1a hash of the terminals, variables, actions, gotos and productions, equal tables have equal hashes
+     */
+    [[nodiscard]] uint64_t hash() const;
+};
+
+
+#endif //VOXELFUSION_COMPILEDPARSETABLE_H
@@ -0,0 +1,105 @@
+//
+
+#include "LALRCollection.h"
+#include <unordered_map>
+
+void LALRCollection::closeCore(Bits &core) const {
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(unsigned int i = 0; i < items.size(); i++) {
+            const Item &item = items[i];
+            if(item.readSymbol < 0 || !grammar.isVariable(item.readSymbol) || !testBit(core.items, i) ||
+               !testBit(core.lookaheads, item.head)) continue;
+            const bool isLast = item.readingIndex + 1 == bodies[item.production].size();
+            if(!isLast && isEmpty(firstSet(items[i + 1].readSymbol), symbolWords)) continue;
+            for(const unsigned int startItem : startItems[item.readSymbol]) {
+                if(testBit(core.items, startItem)) continue;
+                setBit(core.items, startItem);
+                changed = true;
+            }
+            if(!testBit(core.lookaheads, item.readSymbol)) {
+                setBit(core.lookaheads, item.readSymbol);
+                changed = true;
+            }
+        }
+    }
+}
+
+LALRCollection::Bits LALRCollection::goToCore(const Bits &core, unsigned int symbol) const {
+    Bits result{Bitset(core.items.size()), Bitset(core.lookaheads.size())};
+    for(unsigned int i = 0; i < items.size(); i++) {
+        if(items[i].readSymbol != (int) symbol || !testBit(core.items, i)) continue;
+        setBit(result.items, i + 1);
+        if(testBit(core.lookaheads, items[i].head)) setBit(result.lookaheads, items[i].head);
+    }
+    return result;
+}
+
+void LALRCollection::build(std::vector<ItemSet> &itemSets,
+                           std::map<unsigned int, std::map<std::string, unsigned int>> &transitions) const {
+    const Bits initial = toBits(cfg.getItemSet());
+    Bits initialCore{initial.items, Bitset(symbolWords)};
+    for(unsigned int symbol = 0; symbol < grammar.size(); symbol++) {
+        if(!isEmpty(&initial.lookaheads[symbol * symbolWords], symbolWords)) setBit(initialCore.lookaheads, symbol);
+    }
+
+    // the cores in the order the canonical collection first finds an item set of them
+    std::vector<Bits> cores{initialCore};
+    std::unordered_map<Bits, unsigned int, BitsHash> coreIndices{{initialCore, 0}};
+    std::vector<std::vector<int>> gotoStates;
+    for(unsigned int i = 0; i < cores.size(); i++) {
+        gotoStates.emplace_back(grammar.getGrammarSymbolCount(), -1);
+        for(unsigned int symbol = 0; symbol < grammar.getGrammarSymbolCount(); symbol++) {
+            Bits next = goToCore(cores[i], symbol);
+            if(isEmpty(next.items.data(), next.items.size())) continue;
+            closeCore(next);
+            const auto inserted = coreIndices.insert({next, cores.size()});
+            if(inserted.second) cores.push_back(std::move(next));
+            gotoStates[i][symbol] = (int) inserted.first->second;
+        }
+    }
+    // spread the lookaheads until every head has all of them, the same closure as AugmentedCFG::computeClosure
+    std::vector<Bitset> lookaheads(cores.size(), Bitset(initial.lookaheads.size()));
+    lookaheads[0] = initial.lookaheads;
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(unsigned int state = 0; state < cores.size(); state++) {
+            for(unsigned int i = 0; i < items.size(); i++) {
+                const Item &item = items[i];
+                if(item.readSymbol < 0 || !testBit(cores[state].items, i)) continue;
+                const uint64_t *headLookaheads = &lookaheads[state][item.head * symbolWords];
+                if(isEmpty(headLookaheads, symbolWords)) continue;
+                if((unsigned int) item.readSymbol < grammar.getGrammarSymbolCount()) {
+                    const unsigned int next = gotoStates[state][item.readSymbol];
+                    if(unite(&lookaheads[next][item.head * symbolWords], headLookaheads, symbolWords)) changed = true;
+                }
+                if(!grammar.isVariable(item.readSymbol)) continue;
+                const uint64_t *added = item.readingIndex + 1 < bodies[item.production].size()
+                        ? firstSet(items[i + 1].readSymbol) : headLookaheads;
+                if(unite(&lookaheads[state][item.readSymbol * symbolWords], added, symbolWords)) changed = true;
+            }
+        }
+    }
+
+    // cores with the same items are one item set, numbered in the order they are first found
+    std::unordered_map<Bits, unsigned int, BitsHash> itemSetIndices;
+    std::vector<unsigned int> itemSetOf;
+    std::vector<Bits> merged;
+    for(unsigned int state = 0; state < cores.size(); state++) {
+        const auto inserted = itemSetIndices.insert({{cores[state].items, {}}, static_cast<unsigned int>(merged.size())});
+        if(inserted.second) merged.push_back({cores[state].items, lookaheads[state]});
+        else unite(merged[inserted.first->second].lookaheads.data(), lookaheads[state].data(), lookaheads[state].size());
+        itemSetOf.push_back(inserted.first->second);
+    }
+    transitions.clear();
+    for(unsigned int state = 0; state < cores.size(); state++) {
+        for(unsigned int symbol = 0; symbol < grammar.getGrammarSymbolCount(); symbol++) {
+            if(gotoStates[state][symbol] >= 0) transitions[itemSetOf[state]][grammar.getSymbol(symbol)] = itemSetOf[gotoStates[state][symbol]];
+        }
+    }
+    itemSets.clear();
+    itemSets.reserve(merged.size());
+    for(const Bits &itemSet : merged) itemSets.push_back(toItemSet(itemSet));
+}
@@ -0,0 +1,29 @@
+//
+
+#ifndef VOXELFUSION_LALRCOLLECTION_H
+#define VOXELFUSION_LALRCOLLECTION_H
+
+#include "LR1Parser/CanonicalCollection.h"
+
+/**
+ * @brief Builds the LALR(1) item sets of an augmented grammar directly from their cores, without the canonical LR(1)
+ * collection they would be merged from. The lookaheads are then spread over the cores until nothing changes:
+ * they are generated by the FIRST set of the symbol after a variable and propagated along transitions and closures
+ */
+class LALRCollection : public CanonicalCollection {
+    // a core is the items of an item set with the heads that have lookaheads in place of the lookaheads, as only those
+    // add items in the closure. Cores with the same items are merged into one item set at the end, like LR(1) item sets are
+    void closeCore(Bits &core) const;
+    [[nodiscard]] Bits goToCore(const Bits &core, unsigned int symbol) const;
+public:
+    explicit LALRCollection(const AugmentedCFG &cfg) : CanonicalCollection(cfg) {}
+
+    /**
+     * @brief The item sets and transitions that merging the canonical LR(1) collection by core would give,
+     * numbered the same way
+     */
+    void build(std::vector<ItemSet> &itemSets, std::map<unsigned int, std::map<std::string, unsigned int>> &transitions) const;
+};
+
+
+#endif //VOXELFUSION_LALRCOLLECTION_H
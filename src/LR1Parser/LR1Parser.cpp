@@ -1,7 +1,9 @@
 //
 
 #include "LR1Parser.h"
-#include "LR1ParsingSpace.h"
+#include "CanonicalCollection.h"
+#include "utils/Instrumentation.h"
+#include <algorithm>
 #include <iostream>
 
 #include "lib/json.hpp"
@@ -62,30 +64,71 @@ void LR1Parser::importTable(const std::string &jsonTablePath) {
     catch(const std::exception &exception) {
         std::cerr << "Cannot import parsing table: " << exception.what() << std::endl;
     }
+    compiledTable = CompiledParseTable(parseTable);
 }
-std::shared_ptr<STNode> LR1Parser::parse(const std::vector<Token> &tokenizedInput) const {
-    LR1ParsingSpace parsingSpace(tokenizedInput);
+SyntaxTree LR1Parser::parse(const std::vector<Token> &tokenizedInput) const {
+    size_t tokenIndex = 0;
+    return parse([&tokenizedInput, &tokenIndex]() {
+        const Token &token = tokenizedInput[std::min(tokenIndex++, tokenizedInput.size() - 1)];
+        return TokenView{token.type, token.lexeme, token.line, token.column};
+    });
+}
+SyntaxTree LR1Parser::parse(TokenStream &tokens) const {
+    return parse([&tokens]() {return tokens.next();});
+}
+SyntaxTree LR1Parser::parse(const std::function<TokenView()> &nextToken) const {
+    // includes lexing the tokens as they are read
+    INSTRUMENT_SCOPE("parse");
+    std::vector<unsigned int> stateStack{0};
+    std::vector<unsigned int> nodeStack;
+    SyntaxTree tree;
+    // the label of every variable is only added to the tree once it heads a node
+    std::vector<int> variableLabels(compiledTable.variableCount(), -1);
+    TokenView lookahead = nextToken();
+    unsigned int terminal = compiledTable.terminalOf(lookahead);
 
-    while (!parsingSpace.accepted) {
-        const Token &currentToken = tokenizedInput[parsingSpace.tokenIndex];
-        unsigned int currentState = parsingSpace.stateStack.top();
+    while(true) {
+        const unsigned int currentState = stateStack.back();
+        const uint32_t action = compiledTable.action(currentState, terminal);
+        switch(CompiledParseTable::kindOf(action)) {
+            case CompiledParseTable::Action_Shift:
+                nodeStack.push_back(tree.addLeaf(
+                        Token(lookahead.type, std::string(lookahead.lexeme), lookahead.line, lookahead.column)).getIndex());
+                stateStack.push_back(CompiledParseTable::operandOf(action));
+                lookahead = nextToken();
+                terminal = compiledTable.terminalOf(lookahead);
+                break;
+            case CompiledParseTable::Action_Reduce: {
+                const CompiledParseTable::Production &production = compiledTable.production(CompiledParseTable::operandOf(action));
+                // the children are popped from the top of the stack, so they are stored last to first
+                const std::string &head = compiledTable.variableName(production.head);
+                if(variableLabels[production.head] < 0) variableLabels[production.head] = (int) tree.addLabel(head);
+                const SyntaxNode node = tree.addNode(variableLabels[production.head], nodeStack.rbegin(), nodeStack.rbegin() + production.bodyLength);
+                nodeStack.resize(nodeStack.size() - production.bodyLength);
+                stateStack.resize(stateStack.size() - production.bodyLength);
+                nodeStack.push_back(node.getIndex());
 
-        const std::string currentTerminal = [&]() -> std::string {
-            const auto& found = TokenMapping::terminals.find(currentToken.type);
-            if(found != TokenMapping::terminals.end()) return found->second;
-            return currentToken.lexeme;
-        }();
-            const LR1ParseTableEntry &entry = parseTable.at(currentState);
-            const auto& findAction = entry.actionMap.find(currentTerminal);
-            if(findAction != entry.actionMap.end()) {
-                (*(findAction->second))(parsingSpace, parseTable);
+                const int newState = compiledTable.goTo(stateStack.back(), production.head);
+                if(newState == CompiledParseTable::NoGoto) throw std::invalid_argument(
+                        "Cannot parse input: Cannot find goto("+std::to_string(stateStack.back())+","+head+")");
+                stateStack.push_back(newState);
+                break;
+            }
+            case CompiledParseTable::Action_Accept:
+                tree.setRoot({&tree, nodeStack.back()});
+                INSTRUMENT_COUNTER("syntax tree nodes", tree.size());
+                return tree;
+            case CompiledParseTable::Action_Error: {
+                const auto& found = TokenMapping::terminals.find(lookahead.type);
+                const std::string currentTerminal = found != TokenMapping::terminals.end() ? found->second : std::string(lookahead.lexeme);
+                throw std::invalid_argument(
+                        "Cannot parse given input : no entry for action("
+                        +std::to_string(currentState)+","+currentTerminal+")"
+                        +(lookahead.line > 0 ? " at line "+std::to_string(lookahead.line)
+                                               +", column "+std::to_string(lookahead.column) : ""));
             }
-            else throw std::invalid_argument(
-                    "Cannot parse given input : no entry for action("
-                    +std::to_string(currentState)+","+currentTerminal+")");
+        }
     }
-
-    return parsingSpace.nodeStack.top();
 }
 
 void LR1Parser::print() const {
@@ -158,37 +201,10 @@ void LR1Parser::createParseTable() {
     createShiftActions();
     createGotos();
     createReduceAndAcceptActions();
+    compiledTable = CompiledParseTable(parseTable);
 }
 void LR1Parser::createItemSets() {
-    itemSets.push_back(augmentedCfg.getItemSet());
-    bool changed = true;
-    while(changed) {
-        changed = false;
-        unsigned int i =0;
-        const std::vector<ItemSet> itemSetsCopy = itemSets;
-        for(const ItemSet &currentItemSet : itemSetsCopy) {
-            const std::set<std::string> &grammarSymbols = augmentedCfg.getAllSymbols();
-            for(const std::string &currentSymbol : grammarSymbols) {
-                const ItemSet &newItemSet = augmentedCfg.computeGoto(currentItemSet, currentSymbol);
-                bool foundInMap = itemSetTransitionMap.find(i) != itemSetTransitionMap.end();
-                if(foundInMap)
-                    foundInMap = itemSetTransitionMap.at(i).find(currentSymbol)
-                                 != itemSetTransitionMap.at(i).end();
-                if(!newItemSet.empty() && !foundInMap) {
-                    const auto found = std::find(itemSets.begin(), itemSets.end(), newItemSet);
-                    if(found == itemSets.end()) {
-                        itemSets.push_back(newItemSet);
-                        itemSetTransitionMap[i].insert({currentSymbol, itemSets.size()-1});
-                    }
-                    else {
-                        itemSetTransitionMap[i].insert({currentSymbol, found - itemSets.begin()});
-                    }
-                    changed = true;
-                }
-            }
-            i++;
-        }
-    }
+    CanonicalCollection(augmentedCfg).build(itemSets, itemSetTransitionMap);
 }
 
 LR1Parser::LR1Parser(const std::string &jsonPath) : augmentedCfg(AugmentedCFG(jsonPath)) {}
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 
 #include "LR1Parser/Action.h"
+#include "LR1Parser/CompiledParseTable.h"
+#include <functional>
 #include <memory>
 
 class LR1ParseTableEntry {
@@ -21,6 +23,8 @@ protected:
     std::vector<ItemSet> itemSets;
     std::map<unsigned int, std::map<std::string, unsigned int>> itemSetTransitionMap; // holds indices to item sets
     LR1ParseTable parseTable;
+    // the parse table as it is used to parse, rebuilt whenever the table is created or imported
+    CompiledParseTable compiledTable;
     const AugmentedCFG augmentedCfg;
 
     void createReduceAndAcceptActions();
@@ -30,8 +34,21 @@ protected:
 public:
     explicit LR1Parser(const std::string &CFGJsonPath);
     LR1Parser() = default;
+    /**
+     * @brief A parser that only has the compiled form of its table, like the TASM table built into the binary,
+     * so it can parse but has no table to print or export
+     */
+    explicit LR1Parser(const CompiledParseTable &compiledTable) : compiledTable(compiledTable) {}
 
-    std::shared_ptr<STNode> parse(const std::vector<Token> &tokenizedInput) const;
+    /**
+     * @brief The nodes of the tree refer to it by address, so it has to stay where it is while they are used
+     */
+    SyntaxTree parse(const std::vector<Token> &tokenizedInput) const;
+    /**
+     * @brief Parses the tokens as they are read, so the code never has to be tokenized as a whole
+     */
+    SyntaxTree parse(TokenStream &tokens) const;
+    SyntaxTree parse(const std::function<TokenView()> &nextToken) const;
 
     virtual ~LR1Parser() = default;
 
@@ -39,6 +56,8 @@ public:
     void createParseTable();
     void print() const;
 
+    const CompiledParseTable& getCompiledTable() const {return compiledTable;}
+
     void exportTable(const std::string &fileName) const;
     void importTable(const std::string &jsonTablePath);
 };
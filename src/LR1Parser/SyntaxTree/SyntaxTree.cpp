@@ -3,9 +3,51 @@
 #include "SyntaxTree.h"
 #include <fstream>
 
-std::string getLabelOfNode(const STNode &node) {
-    std::string label = node.label;
-    const auto &token = node.getToken();
+const std::string& SyntaxNode::getLabel() const {
+    const SyntaxTree::Node &node = tree->nodes[index];
+    return node.token >= 0 ? tree->tokens[node.token].lexeme : tree->labels[node.label];
+}
+const Token* SyntaxNode::getToken() const {
+    const int token = tree->nodes[index].token;
+    return token >= 0 ? &tree->tokens[token] : nullptr;
+}
+unsigned int SyntaxNode::getChildCount() const {
+    return tree->nodes[index].childCount;
+}
+SyntaxNode SyntaxNode::getChild(unsigned int child) const {
+    return {tree, tree->children[tree->nodes[index].firstChild + child]};
+}
+SyntaxNode::Children SyntaxNode::getChildren() const {
+    const SyntaxTree::Node &node = tree->nodes[index];
+    const unsigned int *first = tree->children.data() + node.firstChild;
+    return {{tree, first}, {tree, first + node.childCount}};
+}
+
+unsigned int SyntaxTree::addLabel(const std::string &label) {
+    const auto found = labelIds.find(label);
+    if(found != labelIds.end()) return found->second;
+    labelIds.insert({label, labels.size()});
+    labels.push_back(label);
+    return labels.size() - 1;
+}
+SyntaxNode SyntaxTree::addLeaf(Token token) {
+    tokens.push_back(std::move(token));
+    nodes.push_back({-1, (int) tokens.size() - 1, (unsigned int) children.size(), 0});
+    return {this, (unsigned int) nodes.size() - 1};
+}
+SyntaxNode SyntaxTree::addNode(const std::string &label, const std::vector<SyntaxNode> &nodeChildren) {
+    std::vector<unsigned int> indices;
+    for(const SyntaxNode &child : nodeChildren) indices.push_back(child.getIndex());
+    return addNode(addLabel(label), indices.begin(), indices.end());
+}
+void SyntaxTree::reserve(size_t nodeCount) {
+    nodes.reserve(nodeCount);
+    children.reserve(nodeCount);
+}
+
+std::string getLabelOfNode(const SyntaxNode &node) {
+    std::string label = node.getLabel();
+    const Token *token = node.getToken();
     if(token) {
         const auto &findTerminal = TokenMapping::terminals.find(token->type);
         std::string type;
@@ -16,38 +58,40 @@ std::string getLabelOfNode(const STNode &node) {
     return label;
 }
 
-void visualizeNode(const STNode &node, std::string &currentStr) {
-    static int nodeCounter = 0;
+// nodeCounter is the id of the node, counted per export so trees can be exported from several threads at once
+void visualizeNode(const SyntaxNode &node, std::string &currentStr, int &nodeCounter) {
     const std::string parentLabelStr = getLabelOfNode(node);
     const std::string parentId = std::to_string(nodeCounter);
 
     currentStr += parentId+"[label = \""+parentLabelStr+"\"]\n";
-    if(node.children.empty()) currentStr += parentId+"[fillcolor=\"lightgreen\"]\n";
+    if(!node.hasChildren()) currentStr += parentId+"[fillcolor=\"lightgreen\"]\n";
 
     nodeCounter++;
-    for(auto iter = node.children.rbegin(); iter != node.children.rend(); iter++) {
-        const std::shared_ptr<STNode>& currentChild = *iter;
-        const std::string childLabelStr = getLabelOfNode(*currentChild);
+    const SyntaxNode::Children children = node.getChildren();
+    for(auto iter = children.rbegin(); iter != children.rend(); iter++) {
+        const SyntaxNode currentChild = *iter;
+        const std::string childLabelStr = getLabelOfNode(currentChild);
 
         currentStr += std::to_string(nodeCounter)+"[label = \""+childLabelStr+"\"]\n";
         currentStr += parentId+"--"+std::to_string(nodeCounter)+"\n";
 
-        visualizeNode(*currentChild, currentStr);
+        visualizeNode(currentChild, currentStr, nodeCounter);
     }
 }
 std::string setNodeAttribute(const std::string &attr, const std::string &value ) {
     return "node ["+attr+"=\""+value+"\"]\n";
 }
-void STNode::exportVisualization(const std::string &fileName) const {
+void SyntaxTree::exportVisualization(const std::string &fileName) const {
     std::string resultStr = "Graph G {\nsplines=false;\n";
     resultStr += setNodeAttribute("style", "filled");
     resultStr += setNodeAttribute("fillcolor", "lightblue");
     resultStr += setNodeAttribute("shape", "box");
 
-    visualizeNode(*this, resultStr);
+    int nodeCounter = 0;
+    visualizeNode(getRoot(), resultStr, nodeCounter);
 
     resultStr += "\n}";
     std::ofstream output(fileName);
     output << resultStr;
     output.close();
-}
\ No newline at end of file
+}
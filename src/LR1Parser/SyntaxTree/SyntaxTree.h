@@ -3,26 +3,121 @@
 #ifndef VOXELFUSION_SYNTAXTREE_H
 #define VOXELFUSION_SYNTAXTREE_H
 
+#include <deque>
+#include <iterator>
+#include <map>
 #include <string>
-#include <memory>
 #include <vector>
 #include "Lexer/Lexer.h"
 
-class STNode {
+class SyntaxTree;
+
+/**
+ * @brief A node of a SyntaxTree. It refers to the tree by address and to its node by index, so it is cheap to copy and stays valid
+ * while nodes are added, for as long as the tree is neither destroyed nor moved
+ */
+class SyntaxNode {
+    const SyntaxTree *tree = nullptr;
+    unsigned int index = 0;
 public:
-    const std::shared_ptr<Token> token;
-    const std::string label;
-    const std::vector<std::shared_ptr<STNode>> children;
+    /**
+     * @brief Goes over the children of a node, which has to stay as it is while they are gone over
+     */
+    class ChildIterator {
+        const SyntaxTree *tree = nullptr;
+        const unsigned int *child = nullptr;
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = SyntaxNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = SyntaxNode;
+
+        ChildIterator() = default;
+        ChildIterator(const SyntaxTree *tree, const unsigned int *child) : tree(tree), child(child) {}
+        SyntaxNode operator*() const {return {tree, *child};}
+        ChildIterator& operator++() {child++; return *this;}
+        ChildIterator operator++(int) {ChildIterator previous = *this; child++; return previous;}
+        ChildIterator& operator--() {child--; return *this;}
+        ChildIterator operator--(int) {ChildIterator previous = *this; child--; return previous;}
+        bool operator==(const ChildIterator &other) const {return child == other.child;}
+        bool operator!=(const ChildIterator &other) const {return child != other.child;}
+    };
+    struct Children {
+        ChildIterator first, last;
+        [[nodiscard]] ChildIterator begin() const {return first;}
+        [[nodiscard]] ChildIterator end() const {return last;}
+        [[nodiscard]] std::reverse_iterator<ChildIterator> rbegin() const {return std::reverse_iterator<ChildIterator>(last);}
+        [[nodiscard]] std::reverse_iterator<ChildIterator> rend() const {return std::reverse_iterator<ChildIterator>(first);}
+    };
+
+    SyntaxNode() = default;
+    SyntaxNode(const SyntaxTree *tree, unsigned int index) : tree(tree), index(index) {}
 
-    ~STNode() = default;
+    // a default constructed node is no node
+    explicit operator bool() const {return tree != nullptr;}
+    [[nodiscard]] unsigned int getIndex() const {return index;}
 
-    STNode(const std::string &label, const std::vector<std::shared_ptr<STNode>> &children)
-    : label(label), children(children) {}
-    explicit STNode(const Token &token) : token(std::make_shared<Token>(token)), label(token.lexeme) {}
+    /**
+     * @return The variable of an inner node or the lexeme of a leaf
+     */
+    [[nodiscard]] const std::string& getLabel() const;
+    /**
+     * @return The token of a leaf, nullptr for an inner node
+     */
+    [[nodiscard]] const Token* getToken() const;
+    [[nodiscard]] bool hasChildren() const {return getChildCount() > 0;}
+    [[nodiscard]] unsigned int getChildCount() const;
+    // children are stored last to first, as the parser pops them off its stack
+    [[nodiscard]] SyntaxNode getChild(unsigned int child) const;
+    [[nodiscard]] Children getChildren() const;
+};
+
+/**
+ * @brief A syntax tree kept in a few contiguous arrays: the nodes, the indices of their children in ranges one after the other,
+ * and the tokens and labels they refer to by index, which are kept in deques so they do not move while the tree grows
+ */
+class SyntaxTree {
+    friend class SyntaxNode;
+    struct Node {
+        // -1 for leaves, which are labelled by their lexeme
+        int label;
+        // -1 for inner nodes
+        int token;
+        unsigned int firstChild;
+        unsigned int childCount;
+    };
+    std::vector<Node> nodes;
+    std::vector<unsigned int> children;
+    std::deque<Token> tokens;
+    std::deque<std::string> labels;
+    std::map<std::string, unsigned int> labelIds;
+    unsigned int root = 0;
+public:
+    /**
+     * @return The index of the label, the same for the same label
+     */
+    unsigned int addLabel(const std::string &label);
+    SyntaxNode addLeaf(Token token);
+    /**
+     * @param children Node indices, last child first
+     */
+    template<class Iterator>
+    SyntaxNode addNode(unsigned int label, Iterator firstChild, Iterator lastChild) {
+        const auto first = (unsigned int) children.size();
+        children.insert(children.end(), firstChild, lastChild);
+        nodes.push_back({(int) label, -1, first, (unsigned int) children.size() - first});
+        return {this, (unsigned int) nodes.size() - 1};
+    }
+    /**
+     * @param children Last child first
+     */
+    SyntaxNode addNode(const std::string &label, const std::vector<SyntaxNode> &children);
 
-    bool hasChildren() const {return !children.empty();}
-    std::vector<std::shared_ptr<STNode>> getChildren() const {return children;}
-    std::shared_ptr<Token> getToken() const {return token;}
+    void reserve(size_t nodeCount);
+    [[nodiscard]] size_t size() const {return nodes.size();}
+    [[nodiscard]] SyntaxNode getRoot() const {return {this, root};}
+    void setRoot(const SyntaxNode &node) {root = node.getIndex();}
 
     void exportVisualization(const std::string &fileName) const;
 };
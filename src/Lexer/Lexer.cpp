@@ -1,96 +1,177 @@
 //
 
 #include "Lexer.h"
+#include "utils/Instrumentation.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
 #include <iostream>
-#include <regex>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
 
+namespace {
+    enum CharacterClass : uint8_t {Character_Other, Character_Space, Character_Letter, Character_Digit, Character_Symbol};
 
+    /**
+     * @brief The tables of the DFA, built once from TokenMapping: the class of every character,
+     * a trie over the operators and punctuators and a perfect hash of the keywords
+     */
+    class ScannerTables {
+        struct SymbolState {
+            // -1 if the character does not continue any operator or punctuator
+            std::array<int, 256> next;
+            // the type of the operator or punctuator ending here, if any
+            int accepted = -1;
+            SymbolState() {next.fill(-1);}
+        };
+        std::array<CharacterClass, 256> classes{};
+        std::vector<SymbolState> symbolStates{1};
+        uint32_t keywordSeed = 0;
+        // the slot of a keyword is given by the top bits of its hash, which depend on all of its characters
+        uint32_t keywordShift = 0;
+        std::vector<std::string> keywordSlots;
 
-bool matchesRegex(const std::string &str, const std::string &regex) {
-    return std::regex_match(str, std::regex(regex));
-}
-
-Lexer::Lexer(const std::string &input) : input(input), position(0)  {
-    tokenizeInput();
-}
-
-void Lexer::advance() {
-    position++;
-}
-char Lexer::getCurrentChar() const {
-    return input[position];
-}
-void Lexer::skipWhitespace() {
-    while(std::isspace(getCurrentChar())) advance();
-}
-bool Lexer::reachedEnd() const {
-    return position > input.size()-1;
-}
-std::string Lexer::getNextString() {
-    skipWhitespace();
-    std::string result;
-    while(!reachedEnd() && !std::isspace(getCurrentChar())) {
-        result += getCurrentChar();
-        advance();
-    }
-    return result;
-}
-
-std::vector<std::string> getSortedNonLiterals(const TokenType &type) {
-    std::vector<std::string> nonLiterals = TokenMapping::nonLiterals.at(type);
-    std::sort(nonLiterals.begin(), nonLiterals.end(), [](const std::string &a, const std::string &b) -> bool {
-        return a.size() > b.size();
-    });
-    return nonLiterals;
-}
-
-std::vector<Token> Lexer::parseWord(const std::string &lexeme) const {
-    std::vector<Token> result;
-    if(!lexeme.empty()) {
-        for(const auto &currentKeyword : getSortedNonLiterals(Token_Keyword)) {
-            if(currentKeyword == lexeme) return {{Token_Keyword, lexeme}};
+        static uint32_t hash(const std::string_view &word, uint32_t seed) {
+            for(const char c : word) seed = (seed ^ (unsigned char) c) * 16777619u;
+            return seed;
         }
-        for(const auto &currentOperator : getSortedNonLiterals(Token_Operator)) {
-            const size_t index = lexeme.find(currentOperator);
-            if(index != std::string::npos) {
-                const std::string prefix = lexeme.substr(0, index);
-                const std::string suffix = lexeme.substr(
-                        index+currentOperator.size(), lexeme.size()-index-currentOperator.size());
-                for(const Token &currentPrefixToken : parseWord(prefix)) result.push_back(currentPrefixToken);
-                result.emplace_back(Token_Operator, currentOperator);
-                for(const Token &currentSuffixToken : parseWord(suffix)) result.push_back(currentSuffixToken);
-                return result;
+        void addSymbol(const std::string &symbol, TokenType type) {
+            int state = 0;
+            for(const char c : symbol) {
+                // adding a state can move the others, so the transition is looked up again
+                if(symbolStates[state].next[(unsigned char) c] < 0) {
+                    symbolStates.emplace_back();
+                    symbolStates[state].next[(unsigned char) c] = (int) symbolStates.size() - 1;
+                }
+                state = symbolStates[state].next[(unsigned char) c];
             }
+            symbolStates[state].accepted = type;
         }
-
-        for(const auto &currentPunctuator: getSortedNonLiterals(Token_Punctuator)) {
-            const size_t index = lexeme.find(currentPunctuator);
-            if(index != std::string::npos) {
-                const std::string prefix = lexeme.substr(0, index);
-                const std::string suffix = lexeme.substr(
-                        index+currentPunctuator.size(), lexeme.size()-index-currentPunctuator.size());
-                for(const Token &currentPrefixToken : parseWord(prefix)) result.push_back(currentPrefixToken);
-                result.emplace_back(Token_Punctuator, currentPunctuator);
-                for(const Token &currentSuffixToken : parseWord(suffix)) result.push_back(currentSuffixToken);
-                return result;
+        // looks for a seed that gives every keyword its own slot
+        void hashKeywords(const std::vector<std::string> &keywords) {
+            uint32_t slotCount = 1;
+            for(keywordShift = 32; slotCount < 4 * keywords.size(); keywordShift--) slotCount <<= 1;
+            for(keywordSeed = 2166136261u; keywordSeed != 2166136261u + (1u << 16); keywordSeed++) {
+                keywordSlots.assign(slotCount, "");
+                bool isPerfect = true;
+                for(const std::string &keyword : keywords) {
+                    std::string &slot = keywordSlots[hash(keyword, keywordSeed) >> keywordShift];
+                    if(!slot.empty()) {
+                        isPerfect = false;
+                        break;
+                    }
+                    slot = keyword;
+                }
+                if(isPerfect) return;
             }
+            throw std::runtime_error("No perfect hash found for the keywords");
         }
+        ScannerTables() {
+            for(const TokenType type : {Token_Operator, Token_Punctuator}) {
+                for(const std::string &symbol : TokenMapping::nonLiterals.at(type)) addSymbol(symbol, type);
+            }
+            for(int c = 0; c < 256; c++) {
+                // letters are the range 'A' to 'z' that identifiers are made of, except the punctuators '[' and ']' in it
+                if(std::isspace(c)) classes[c] = Character_Space;
+                else if(symbolStates[0].next[c] >= 0) classes[c] = Character_Symbol;
+                else if(std::isdigit(c)) classes[c] = Character_Digit;
+                else if(c >= 'A' && c <= 'z') classes[c] = Character_Letter;
+            }
+            hashKeywords(TokenMapping::nonLiterals.at(Token_Keyword));
+        }
+    public:
+        static const ScannerTables& get() {
+            static const ScannerTables tables;
+            return tables;
+        }
+        CharacterClass classOf(char c) const {return classes[(unsigned char) c];}
+        bool isKeyword(const std::string_view &word) const {
+            return keywordSlots[hash(word, keywordSeed) >> keywordShift] == word;
+        }
+        int nextSymbolState(int state, char c) const {return symbolStates[state].next[(unsigned char) c];}
+        int acceptedSymbol(int state) const {return symbolStates[state].accepted;}
+    };
+}
 
-        if(std::regex_match(lexeme, std::regex(TokenMapping::identifer.first))) return {{Token_Identifier, lexeme}};
+[[noreturn]] static void throwMalformed(const std::string_view &lexeme, unsigned int line, unsigned int column) {
+    throw std::invalid_argument("Cannot lex given input : no token starts with \"" + std::string(lexeme) + "\" at line "
+                                + std::to_string(line) + ", column " + std::to_string(column));
+}
+
+TokenStream::TokenStream(const std::string_view &input) : current(input.data()), end(input.data() + input.size()), lineStart(current) {}
 
-        for(const auto &currentLiteral : TokenMapping::literals) {
-            if(std::regex_match(lexeme, std::regex(currentLiteral.first))) return {{currentLiteral.second, lexeme}};
+TokenView TokenStream::next() {
+    const ScannerTables &tables = ScannerTables::get();
+    while(current != end) {
+        const char *const start = current;
+        const auto token = [&](TokenType type, const char *tokenEnd) {
+            current = tokenEnd;
+            return TokenView{type, std::string_view(start, tokenEnd - start), line, (unsigned int) (start - lineStart) + 1};
+        };
+        switch(tables.classOf(*current)) {
+            case Character_Letter:
+            case Character_Digit: {
+                const char *wordEnd = current;
+                while(wordEnd != end && (tables.classOf(*wordEnd) == Character_Letter || tables.classOf(*wordEnd) == Character_Digit)) {
+                    wordEnd++;
+                }
+                const std::string_view word(start, wordEnd - start);
+                if(tables.classOf(*start) == Character_Letter) return token(tables.isKeyword(word) ? Token_Keyword : Token_Identifier, wordEnd);
+                // integers have no leading zeros
+                if((word.size() == 1 || *start != '0') &&
+                   std::all_of(word.begin(), word.end(), [&tables](char c) {return tables.classOf(c) == Character_Digit;})) {
+                    return token(Token_Integer, wordEnd);
+                }
+                throwMalformed(word, line, (unsigned int) (start - lineStart) + 1);
+            }
+            case Character_Symbol: {
+                // maximal munch: remember the longest operator or punctuator seen so far
+                const char *acceptedEnd = nullptr;
+                int acceptedType = -1;
+                const char *symbolEnd = current;
+                for(int state = tables.nextSymbolState(0, *symbolEnd); state >= 0;
+                    state = symbolEnd != end ? tables.nextSymbolState(state, *symbolEnd) : -1) {
+                    symbolEnd++;
+                    if(tables.acceptedSymbol(state) >= 0) {
+                        acceptedEnd = symbolEnd;
+                        acceptedType = tables.acceptedSymbol(state);
+                    }
+                }
+                if(acceptedEnd != nullptr) return token((TokenType) acceptedType, acceptedEnd);
+                throwMalformed(std::string_view(start, 1), line, (unsigned int) (start - lineStart) + 1);
+            }
+            case Character_Other:
+                throwMalformed(std::string_view(start, 1), line, (unsigned int) (start - lineStart) + 1);
+            default:
+                if(*current == '\n') {
+                    line++;
+                    lineStart = current + 1;
+                }
+                current++;
         }
     }
-    return result;
+    return {Token_EOS, std::string_view(), line, (unsigned int) (current - lineStart) + 1};
 }
+
+Lexer::Lexer(const std::string &input) : input(input)  {
+    tokenizeInput();
+}
+Lexer::Lexer(const std::istream &input) : input(std::istreambuf_iterator<char>(input.rdbuf()), std::istreambuf_iterator<char>()) {
+    tokenizeInput();
+}
+
 void Lexer::tokenizeInput() {
-    do {
-        const std::string currentWord = getNextString();
-        const std::vector<Token> nextTokens = parseWord(currentWord);
-        for(const Token &currentToken : nextTokens) tokenizedInput.push_back(currentToken);
-    } while(!reachedEnd());
-    tokenizedInput.emplace_back(Token_EOS, "");
+    INSTRUMENT_SCOPE("lex");
+    // scripts have about one token every three characters
+    tokenizedInput.reserve(input.size() / 3);
+    TokenStream stream(input);
+    for(TokenView token = stream.next(); ; token = stream.next()) {
+        tokenizedInput.emplace_back(token.type, std::string(token.lexeme), token.line, token.column);
+        if(token.type == Token_EOS) break;
+    }
+    INSTRUMENT_COUNTER("tokens", tokenizedInput.size());
 }
 
 void Lexer::print() const {
@@ -99,6 +180,6 @@ void Lexer::print() const {
     }
     std::cout << std::endl;
 }
-std::vector<Token> Lexer::getTokenizedInput() const {
+const std::vector<Token>& Lexer::getTokenizedInput() const {
     return tokenizedInput;
-}
\ No newline at end of file
+}
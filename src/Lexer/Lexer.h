@@ -3,6 +3,7 @@
 #ifndef VOXELFUSION_LEXER_H
 #define VOXELFUSION_LEXER_H
 
+#include <string_view>
 #include <vector>
 #include "TokenType.h"
 
@@ -11,28 +12,60 @@ class Token {
 public:
     const TokenType type;
     std::string lexeme; // a string that can represent an identifier,
-    Token(const TokenType &type, const std::string &lexeme) : type(type), lexeme(lexeme) {}
+    // where the token starts in the code, counted from 1, or 0 if it was not read from code
+    unsigned int line;
+    unsigned int column;
+    Token(const TokenType &type, const std::string &lexeme, unsigned int line = 0, unsigned int column = 0)
+    : type(type), lexeme(lexeme), line(line), column(column) {}
 };
 
+/**
+ * @brief A token whose lexeme points into the code it was read from, so it is only valid as long as the code is
+ */
+struct TokenView {
+    TokenType type;
+    std::string_view lexeme;
+    unsigned int line;
+    unsigned int column;
+};
+
+/**
+ * @brief Reads the tokens of TASM code one at a time in a single pass of a DFA over its characters, always taking the longest token
+ * (so "==" is one operator instead of two "=").
+ * A run of letters and digits is a keyword, an identifier or an integer as a whole.
+ * The code is not copied, so it has to outlive the stream
+ */
+class TokenStream {
+    const char *current;
+    const char *const end;
+    const char *lineStart;
+    unsigned int line = 1;
+public:
+    explicit TokenStream(const std::string_view &input);
+
+    /**
+     * @return The next token, or Token_EOS once the code is read
+     * @throws std::invalid_argument With the line and column of a character that does not start a token
+     * or a run of letters and digits that is not one
+     */
+    TokenView next();
+};
+
+/**
+ * @brief Reads all tokens of TASM code at once, see TokenStream
+ * @throws std::invalid_argument If the code contains something that is not a token
+ */
 class Lexer {
 protected:
     std::string input;
-    unsigned int position;
     std::vector<Token> tokenizedInput;
 
-    char getCurrentChar() const;
-    bool reachedEnd() const;
-    std::vector<Token> parseWord(const std::string &lexeme) const;
-
-    void advance();
-    void skipWhitespace();
     void tokenizeInput();
-    std::string getNextString();
 public:
     explicit Lexer(const std::string &input);
     explicit Lexer(const std::istream &input);
 
-    std::vector<Token> getTokenizedInput() const;
+    const std::vector<Token>& getTokenizedInput() const;
     void print() const;
 };
 
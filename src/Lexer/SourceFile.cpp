@@ -0,0 +1,50 @@
+//
+
+#include "SourceFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+
+SourceFile::SourceFile(const std::string &path) {
+    std::ifstream input(path, std::ios::binary);
+    if(!input) throw std::runtime_error("Cannot open " + path);
+    contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    data = contents.data();
+    size = contents.size();
+}
+SourceFile::~SourceFile() = default;
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::SourceFile(const std::string &path) {
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if(descriptor < 0) throw std::runtime_error("Cannot open " + path);
+    struct stat status{};
+    if(fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        throw std::runtime_error("Cannot read " + path);
+    }
+    size = status.st_size;
+    // an empty file cannot be mapped, it stays an empty view
+    if(size > 0) {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(mapping == MAP_FAILED) {
+            close(descriptor);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+    // the mapping stays valid without the descriptor
+    close(descriptor);
+}
+SourceFile::~SourceFile() {
+    if(size > 0) munmap(const_cast<char *>(data), size);
+}
+#endif
@@ -0,0 +1,33 @@
+//
+
+#ifndef VOXELFUSION_SOURCEFILE_H
+#define VOXELFUSION_SOURCEFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief The code in a file, memory mapped so it can be lexed without reading it into a string first
+ */
+class SourceFile {
+    const char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    // without mmap the file is read instead
+    std::string contents;
+#endif
+public:
+    /**
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    explicit SourceFile(const std::string &path);
+    ~SourceFile();
+    SourceFile(const SourceFile &) = delete;
+    SourceFile& operator=(const SourceFile &) = delete;
+
+    [[nodiscard]] std::string_view getContents() const {return {data, size};}
+};
+
+
+#endif //VOXELFUSION_SOURCEFILE_H
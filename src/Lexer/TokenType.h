@@ -21,7 +21,7 @@ enum TokenType {
 };
 
 namespace TokenMapping {
-    // lexer will copy these vectors and sort them according to their character length (so it checks "==" first instead of "=")
+    // the lexer builds its DFA from these vectors and always takes the longest match (so it reads "==" instead of "=" twice)
     const std::unordered_map<TokenType, std::vector<std::string>> nonLiterals = {
         {Token_Keyword, {"if",
                          "reading",
@@ -35,16 +35,11 @@ namespace TokenMapping {
                          "until",
                          "current",
                          "left", "right", "up", "down", "forwards", "backwards",
-                         "CA", "for", "run", "in", "array", "random"}},
+                         "CA", "for", "run", "in", "array", "random",
+                         "box", "fill", "with", "copy", "from", "to", "shift"}},
         {Token_Operator,{"==", "=", "+=", "-=", "*=", "/=", ":=", "&="}},
         {Token_Punctuator, {"{","}",";", ",", "'", "[", "]"}}
     };
-    const std::pair<std::string, std::string> identifer {"^[A-z][A-z0-9]*$", "Identifier"};
-
-    const std::unordered_map<std::string, TokenType> literals = {
-            {"^0$|^[1-9][0-9]*$", Token_Integer},
-    };
-
     const std::unordered_map<TokenType, std::string> terminals = {
             {Token_Identifier, "Identifier"},
             {Token_Integer, "Integer"},
@@ -1,6 +1,11 @@
 //
 
 #include "FiniteControl.h"
+#include "utils/Instrumentation.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
 
 StatePointer findStartingState(const std::set<StatePointer> &states) {
     for(const auto & currentStatePtr : states) {
@@ -16,7 +21,10 @@ FiniteControl::FiniteControl(const std::set<StatePointer> &states,
            initialState(findStartingState(states)),
            currentState(initialState),
            transitions(transitions)
-{}
+{
+    INSTRUMENT_SCOPE("finite control");
+    indexPatternTransitions();
+}
 
 #include <iostream>
 FiniteControl::FiniteControl(const std::set<StatePointer> &states,
@@ -24,9 +32,98 @@ FiniteControl::FiniteControl(const std::set<StatePointer> &states,
         states(states),
         initialState(findStartingState(states)),
         currentState(initialState) {
+    INSTRUMENT_SCOPE("finite control");
     for(const auto & currentTransition : transitionsArg) {
         transitions[currentTransition.first.state->name].insert({currentTransition.first.replacedSymbols, currentTransition.second});
     }
+    indexPatternTransitions();
+}
+
+unsigned int countConstraints(const std::vector<std::string> &domain) {
+    unsigned int constraints = 0;
+    for(const std::string &symbol : domain) {
+        if(symbol != SYMBOL_ANY) constraints++;
+    }
+    return constraints;
+}
+void FiniteControl::indexPatternTransitions() {
+    for(const auto &[stateName, stateTransitions] : transitions) {
+        std::vector<StateTransitions::const_iterator> patterns;
+        for(auto iter = stateTransitions.begin(); iter != stateTransitions.end(); iter++) {
+            if(countConstraints(iter->first) < iter->first.size() ||
+               std::any_of(iter->first.begin(), iter->first.end(), TapeReference::isReference) ||
+               std::any_of(iter->first.begin(), iter->first.end(), NeighbourRead::isNeighbourRead)) {
+                patterns.push_back(iter);
+            }
+        }
+        // ties keep the order of the domains
+        std::stable_sort(patterns.begin(), patterns.end(), [](const auto &a, const auto &b) {
+            return countConstraints(a->first) > countConstraints(b->first);
+        });
+        auto &indexedPatterns = patternTransitions[stateName];
+        indexedPatterns.reserve(patterns.size());
+        for(const auto &pattern : patterns) {
+            const auto &[domain, image] = *pattern;
+            PatternTransition &indexed = indexedPatterns.emplace_back(PatternTransition{domain, image, {}});
+            for(unsigned int i = 0; i < domain.size(); i++) {
+                if(NeighbourRead::isNeighbourRead(domain[i])) indexed.neighbourReads.emplace_back(i, NeighbourRead::parse(domain[i]));
+            }
+        }
+    }
+}
+
+bool FiniteControl::matches(const std::vector<std::string> &domain, const std::vector<std::string> &currentSymbols) {
+    for(unsigned int i = 0; i < domain.size(); i++) {
+        const std::string &symbol = domain[i];
+        if(symbol == SYMBOL_ANY || NeighbourRead::isNeighbourRead(symbol)) continue;
+        if(TapeReference::isReference(symbol)) {
+            const bool isEqual = currentSymbols[i] == currentSymbols[std::stoul(symbol.substr(1))];
+            if(isEqual != (symbol[0] == SYMBOL_EQUAL_PREFIX)) return false;
+        }
+        else if(symbol != currentSymbols[i]) return false;
+    }
+    return true;
+}
+
+const std::string& FiniteControl::resolveReplacement(const std::string &replacementSymbol,
+                                                     const std::vector<std::string> &currentSymbols) {
+    if(!replacementSymbol.empty() && replacementSymbol[0] == SYMBOL_EQUAL_PREFIX) {
+        return currentSymbols[std::stoul(replacementSymbol.substr(1))];
+    }
+    return replacementSymbol;
+}
+
+const TransitionImage* FiniteControl::findTransition(const std::vector<std::string> &currentSymbols, const TMTapes &tapes) const {
+    const auto foundStateTransitions = transitions.find(currentState->name);
+    if(foundStateTransitions == transitions.end()) return nullptr;
+    const auto foundExactMatch = foundStateTransitions->second.find(currentSymbols);
+    // the world can hold symbols that look like tape references or neighbour reads, they are only data, so such domains are
+    // matched as patterns
+    if(foundExactMatch != foundStateTransitions->second.end() &&
+       std::none_of(foundExactMatch->first.begin(), foundExactMatch->first.end(), TapeReference::isReference) &&
+       std::none_of(foundExactMatch->first.begin(), foundExactMatch->first.end(), NeighbourRead::isNeighbourRead)) {
+        return &foundExactMatch->second;
+    }
+    const auto foundPatterns = patternTransitions.find(currentState->name);
+    if(foundPatterns == patternTransitions.end()) return nullptr;
+    for(const PatternTransition &pattern : foundPatterns->second) {
+        if(!matches(pattern.domain, currentSymbols)) continue;
+        if(std::all_of(pattern.neighbourReads.begin(), pattern.neighbourReads.end(), [&tapes](const auto &read) {
+            const auto &[tape, offset] = read;
+            return tape < tapes.size() && tapes[tape]->getSymbolAt(offset.front, offset.up, offset.right) == offset.symbol;
+        })) return &pattern.image;
+    }
+    return nullptr;
+}
+
+NeighbourRead::Offset NeighbourRead::parse(const std::string &symbol) {
+    Offset offset;
+    char separator;
+    std::istringstream stream(symbol.substr(1));
+    stream >> offset.front >> separator >> offset.up >> separator >> offset.right >> separator;
+    if(!stream || separator != ':') throw std::runtime_error("Malformed neighbour read: " + symbol);
+    offset.symbol = symbol.substr(symbol.find(':') + 1);
+    return offset;
 }
 
 bool TransitionDomain::operator<(const TransitionDomain &other) const {
@@ -38,7 +135,7 @@ bool TransitionDomain::operator<(const TransitionDomain &other) const {
 
 
 TransitionImage::TransitionImage(const StatePointer &state, const std::vector<std::string> &replacementSymbols,
-                                 const std::vector<TMTapeDirection> &directionsArg) :
+                                 const std::vector<TMTapeDirection> &directionsArg, const MacroPointer &macro) :
         state(state), replacementSymbols(replacementSymbols),
-        directions(directionsArg.begin(), directionsArg.end())
+        directions(directionsArg.begin(), directionsArg.end()), macro(macro)
 {}
\ No newline at end of file
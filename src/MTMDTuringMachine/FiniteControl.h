@@ -24,6 +24,56 @@ struct State {
 };
 typedef std::shared_ptr<const State> StatePointer;
 
+/*
+ * Tape references let a single transition relate the symbols read on different tapes:
+ * in a domain, "=i" only matches if the symbol equals the one read on tape i and "!i" only if it differs,
+ * in an image, "=i" writes the symbol that was read on tape i
+ * */
+#define SYMBOL_EQUAL_PREFIX '='
+#define SYMBOL_UNEQUAL_PREFIX '!'
+namespace TapeReference {
+    inline std::string equalTo(const unsigned int &tapeIndex) {return SYMBOL_EQUAL_PREFIX + std::to_string(tapeIndex);}
+    inline std::string unequalTo(const unsigned int &tapeIndex) {return SYMBOL_UNEQUAL_PREFIX + std::to_string(tapeIndex);}
+    inline std::string symbolOn(const unsigned int &tapeIndex) {return equalTo(tapeIndex);}
+    inline bool isReference(const std::string &symbol) {
+        return !symbol.empty() && (symbol[0] == SYMBOL_EQUAL_PREFIX || symbol[0] == SYMBOL_UNEQUAL_PREFIX);
+    }
+}
+
+/*
+ * Neighbour reads let a transition look at a cell near the head without moving it:
+ * in a domain, "@f,u,r:S" only matches if the cell f forwards, u up and r right of the head of its tape holds S
+ * */
+#define SYMBOL_NEIGHBOUR_PREFIX '@'
+namespace NeighbourRead {
+    struct Offset {
+        int front;
+        int up;
+        int right;
+        std::string symbol;
+    };
+    inline std::string at(int front, int up, int right, const std::string &symbol) {
+        return SYMBOL_NEIGHBOUR_PREFIX + std::to_string(front) + ',' + std::to_string(up) + ',' + std::to_string(right) + ':' + symbol;
+    }
+    inline bool isNeighbourRead(const std::string &symbol) {return !symbol.empty() && symbol[0] == SYMBOL_NEIGHBOUR_PREFIX;}
+    Offset parse(const std::string &symbol);
+}
+
+/**
+ * @brief Work that the machine does natively within a single transition instead of step by step through its finite control,
+ * it is run on all tapes after the symbols of the transition are written and the heads are moved
+ */
+class TMMacro {
+public:
+    virtual ~TMMacro() = default;
+    virtual void operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const = 0;
+    /**
+     * @brief The kind of macro and its operands, macros with the same key do the same
+     */
+    virtual std::string getKey() const = 0;
+};
+typedef std::shared_ptr<const TMMacro> MacroPointer;
+
 struct TransitionDomain {
     const StatePointer state;
     const std::vector<std::string> replacedSymbols;
@@ -40,18 +90,31 @@ struct TransitionImage {
     const StatePointer state;
     const std::vector<std::string> replacementSymbols;
     const std::vector<TMTapeProbabilisticDirection> directions;
+    // optional, taking the transition also runs it
+    const MacroPointer macro;
     TransitionImage(const StatePointer &state,
                     const std::vector<std::string> &replacementSymbols,
-                    const std::vector<TMTapeProbabilisticDirection> &directions) :
-            state(state), replacementSymbols(replacementSymbols), directions(directions) {}
+                    const std::vector<TMTapeProbabilisticDirection> &directions,
+                    const MacroPointer &macro = nullptr) :
+            state(state), replacementSymbols(replacementSymbols), directions(directions), macro(macro) {}
     TransitionImage(const StatePointer &state,
                     const std::vector<std::string> &replacementSymbols,
-                    const std::vector<TMTapeDirection> &directionsArg);
+                    const std::vector<TMTapeDirection> &directionsArg,
+                    const MacroPointer &macro = nullptr);
 };
 
 
 typedef std::map<std::vector<std::string>, TransitionImage> StateTransitions;
 class FiniteControl {
+    struct PatternTransition {
+        std::vector<std::string> domain;
+        TransitionImage image;
+        // parsed once, per tape
+        std::vector<std::pair<unsigned int, NeighbourRead::Offset>> neighbourReads;
+    };
+    // per state, the domains containing wildcards, tape references or neighbour reads, most specific first
+    std::unordered_map<std::string, std::vector<PatternTransition>> patternTransitions;
+    void indexPatternTransitions();
 public:
     const std::set<StatePointer> states;
     const StatePointer initialState;
@@ -62,6 +125,16 @@ public:
     FiniteControl(const std::set<StatePointer> &states, const std::map<TransitionDomain, TransitionImage> &transitions);
     FiniteControl(const std::set<StatePointer> &states, const std::unordered_map<std::string, std::map<std::vector<std::string>, TransitionImage>> &transitions);
     void setCurrentState(const StatePointer &newCurrentState) {currentState = newCurrentState;}
+
+    /**
+     * @brief Finds the transition of the current state that applies to the given symbols.
+     * An exact match is preferred, otherwise the matching domain with the fewest wildcards is taken.
+     * Domains with neighbour reads only match if the tapes are given
+     * @return The image of the transition or nullptr if there is none
+     */
+    const TransitionImage* findTransition(const std::vector<std::string> &currentSymbols, const TMTapes &tapes = {}) const;
+    static bool matches(const std::vector<std::string> &domain, const std::vector<std::string> &currentSymbols);
+    static const std::string& resolveReplacement(const std::string &replacementSymbol, const std::vector<std::string> &currentSymbols);
 };
 
 #endif //VOXELFUSION_FINITECONTROL_H
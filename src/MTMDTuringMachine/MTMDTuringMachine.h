@@ -18,6 +18,8 @@ protected:
     const std::set<std::string> inputAlphabet;
 
     std::tuple<TMTapeType*...> tapes;
+    // the same tapes, for neighbour reads and macros
+    const TMTapes tapeList;
     const unsigned int tapeCount;
 
     FiniteControl control;
@@ -26,6 +28,15 @@ protected:
     bool hasAccepted;
 
     void (*updateCallback) (const std::tuple<TMTapeType*...> &, const std::vector<unsigned int>);
+
+    template<class Tape>
+    static void writeAndMove(Tape &tape, const TransitionImage &image, const std::vector<std::string> &currentSymbols,
+                             const unsigned int &i, std::vector<unsigned int> &changedTapesIndex) {
+        const std::string &replacement = FiniteControl::resolveReplacement(image.replacementSymbols[i], currentSymbols);
+        if (currentSymbols[i] != replacement) changedTapesIndex.push_back(i);
+        tape.replaceCurrentSymbol(replacement);
+        tape.moveTapeHead(image.directions[i]());
+    }
 public:
     bool isHalted;
     MTMDTuringMachine(const std::set<std::string> &tapeAlphabet,
@@ -34,7 +45,8 @@ public:
                       const FiniteControl &control,
                       void (*updateCallback) (const std::tuple<TMTapeType*...> &, const std::vector<unsigned int>) = nullptr) :
             tapeAlphabet(tapeAlphabet), inputAlphabet(inputAlphabet),
-            tapes(tapes), tapeCount(sizeof...(TMTapeType)), control(control),
+            tapes(tapes), tapeList(std::apply([](auto *... currentTape) {return TMTapes{currentTape...};}, tapes)),
+            tapeCount(sizeof...(TMTapeType)), control(control),
             updateCallback(updateCallback),
             isHalted(false), hasAccepted(false){
         static_assert(std::conjunction<std::is_base_of<TMTape,TMTapeType>...>(), "TM must only be given tapes!");
@@ -44,43 +56,23 @@ public:
     void doTransition() {
         PRECONDITION(!isHalted);
         const std::vector<std::string> &currentSymbols = getCurrentTapeSymbols();
-        const auto foundStateTransitions = control.transitions.find(control.currentState->name);
-        if (foundStateTransitions != control.transitions.end()) {
-            const auto &domain = foundStateTransitions->second;
-            const auto &foundDomain = [&]() {
-                const auto foundExactMatch = domain.find(currentSymbols);
-                if (foundExactMatch != domain.end()) return foundExactMatch;
-                for (auto iter = domain.begin(); iter != domain.end(); iter++) {
-                    for (int i = 0; i < iter->first.size(); i++) {
-                        if (currentSymbols[i] != iter->first[i] && iter->first[i] != SYMBOL_ANY) break;
-                        if (i == iter->first.size() - 1) return iter;
-                    }
-                }
-                return domain.end();
-            }();
-            if (foundDomain != domain.end()) {
-                const TransitionImage &image = foundDomain->second;
-                control.setCurrentState(image.state);
-                unsigned int i = 0;
-                std::vector<unsigned int> changedTapesIndex;
-                std::apply([&](auto &&... currentTape) {
-                    (((currentTape->getCurrentSymbol() != image.replacementSymbols[i]) &&
-                      changedTapesIndex.emplace_back(i),
-                            currentTape->replaceCurrentSymbol(image.replacementSymbols[i]),
-                            currentTape->moveTapeHead(image.directions[i]()),
-                            i++
-                    ), ...);
-                }, tapes);
-                if (control.currentState->type != State_NonHalting) {
-                    isHalted = true;
-                    if (control.currentState->type == State_Accepting) hasAccepted = true;
-                }
-                if (updateCallback) updateCallback(tapes, changedTapesIndex);
-            } else isHalted = true;
+        const TransitionImage *image = control.findTransition(currentSymbols, tapeList);
+        if (image) {
+            control.setCurrentState(image->state);
+            unsigned int i = 0;
+            std::vector<unsigned int> changedTapesIndex;
+            std::apply([&](auto &&... currentTape) {
+                (writeAndMove(*currentTape, *image, currentSymbols, i++, changedTapesIndex), ...);
+            }, tapes);
+            if (image->macro) (*image->macro)(tapeList, changedTapesIndex);
+            if (control.currentState->type != State_NonHalting) {
+                isHalted = true;
+                if (control.currentState->type == State_Accepting) hasAccepted = true;
+            }
+            if (updateCallback) updateCallback(tapes, changedTapesIndex);
         } else isHalted = true;
     }
 
-
     [[nodiscard]] std::vector<std::string> getCurrentTapeSymbols() const {
         std::vector<std::string> currentSymbols;
         currentSymbols.reserve(tapeCount);
@@ -100,7 +92,7 @@ public:
             i++;
         }
     }
-    const FiniteControl& getFiniteControl(){
+    const FiniteControl& getFiniteControl() const {
         return control;
     }
 };
@@ -0,0 +1,56 @@
+//
+
+#include "TMExecution.h"
+#include "utils/Instrumentation.h"
+
+TMExecution::TMExecution(const std::set<std::string> &tapeAlphabet, const std::set<StatePointer> &states,
+                         const std::map<TransitionDomain, TransitionImage> &transitions, TMTape3D &world,
+                         void (*updateCallback) (const Tapes &, const std::vector<unsigned int>))
+        : machine(tapeAlphabet, tapeAlphabet, {&world, &variableTape, &temporaryTape, &historyTape}, FiniteControl(states, transitions),
+                  updateCallback) {}
+
+uint64_t TMExecution::step(uint64_t count) {
+    return advance(count, true, nullptr);
+}
+
+uint64_t TMExecution::advance(uint64_t maxSteps, bool whilePaused, const std::chrono::steady_clock::time_point *deadline) {
+    INSTRUMENT_SCOPE("simulate");
+    uint64_t steps = 0;
+    for(; steps < maxSteps && !machine.isHalted; steps++) {
+        const ExecutionStatus current = status.load(std::memory_order_relaxed);
+        if(current != Execution_Running && !(whilePaused && current == Execution_Paused)) break;
+        if(deadline && std::chrono::steady_clock::now() >= *deadline) break;
+        machine.doTransition();
+    }
+    stepCount += steps;
+    if(machine.isHalted) {
+        // a cancel from another thread in the meantime wins
+        ExecutionStatus expected = status;
+        while(expected != Execution_Cancelled && !status.compare_exchange_weak(expected, Execution_Halted));
+    }
+    return steps;
+}
+
+void TMExecution::pause() {
+    ExecutionStatus expected = Execution_Running;
+    status.compare_exchange_strong(expected, Execution_Paused);
+}
+
+void TMExecution::resume() {
+    ExecutionStatus expected = Execution_Paused;
+    status.compare_exchange_strong(expected, Execution_Running);
+}
+
+void TMExecution::cancel() {
+    ExecutionStatus expected = status;
+    while(expected != Execution_Halted && !status.compare_exchange_weak(expected, Execution_Cancelled));
+}
+
+bool TMExecution::isAccepted() const {
+    return isHalted() && machine.getFiniteControl().currentState->type == State_Accepting;
+}
+
+size_t TMExecution::getCellCount() const {
+    const Tapes tapes = machine.getTapes();
+    return std::get<0>(tapes)->getCellCount() + variableTape.getCellCount() + temporaryTape.getCellCount() + historyTape.getCellCount();
+}
@@ -0,0 +1,79 @@
+//
+
+#ifndef VOXELFUSION_TMEXECUTION_H
+#define VOXELFUSION_TMEXECUTION_H
+
+#include "MTMDTuringMachine.h"
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+enum ExecutionStatus {Execution_Running, Execution_Paused, Execution_Halted, Execution_Cancelled};
+
+/**
+ * @brief A generated program running on a world, advanced by its owner a number of steps or an amount of time at a time,
+ * so the simulation can be interleaved with other work such as drawing frames. The machine and its other tapes are kept
+ * between calls until it halts or is cancelled.
+ * Pausing and cancelling may be done from another thread while it runs, it stops after the step it is taking
+ */
+class TMExecution {
+public:
+    typedef std::tuple<TMTape3D*, TMTape1D*, TMTape1D*, TMTape3D*> Tapes;
+    typedef MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D> Machine;
+private:
+    TMTape1D variableTape;
+    TMTape1D temporaryTape;
+    TMTape3D historyTape;
+    Machine machine;
+    std::atomic<ExecutionStatus> status = Execution_Running;
+    uint64_t stepCount = 0;
+
+    uint64_t advance(uint64_t maxSteps, bool whilePaused, const std::chrono::steady_clock::time_point *deadline);
+public:
+    /**
+     * @param world The first tape, which has to outlive the execution
+     * @param updateCallback Called after every step with the tapes and the indices of those that changed
+     */
+    TMExecution(const std::set<std::string> &tapeAlphabet, const std::set<StatePointer> &states,
+                const std::map<TransitionDomain, TransitionImage> &transitions, TMTape3D &world,
+                void (*updateCallback) (const Tapes &, const std::vector<unsigned int>) = nullptr);
+    TMExecution(const TMExecution &) = delete;
+    TMExecution& operator=(const TMExecution &) = delete;
+
+    /**
+     * @brief Takes up to count steps, also while paused so a paused execution can be stepped through
+     * @return The number of steps taken, fewer if it halted or was cancelled
+     */
+    uint64_t step(uint64_t count = 1);
+    /**
+     * @brief Takes steps until the time is up or maxSteps are taken, nothing while paused
+     * @return The number of steps taken, the clock is read after every step because a step that grows a tape can be slow
+     */
+    template<class Rep, class Period>
+    uint64_t runFor(std::chrono::duration<Rep, Period> duration, uint64_t maxSteps = std::numeric_limits<uint64_t>::max()) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+        return advance(maxSteps, false, &deadline);
+    }
+
+    void pause();
+    void resume();
+    /**
+     * @brief Stops the execution for good, the tapes are left as they are
+     */
+    void cancel();
+
+    ExecutionStatus getStatus() const {return status;}
+    bool isPaused() const {return status == Execution_Paused;}
+    bool isHalted() const {return status == Execution_Halted;}
+    bool isFinished() const {return status == Execution_Halted || status == Execution_Cancelled;}
+    bool isAccepted() const;
+    uint64_t getStepCount() const {return stepCount;}
+    /**
+     * @brief The number of cells of all four tapes
+     */
+    size_t getCellCount() const;
+};
+
+
+#endif //VOXELFUSION_TMEXECUTION_H
@@ -34,6 +34,13 @@ const std::vector<std::shared_ptr<TMTape2D>> &TMTape3D::getCells() const{
     return cells;
 }
 
+TMTapeCell &TMTape3D::cellAt(int front, int up, int right) {
+    TMTape2D &currentPlane = (*this)[currentIndex];
+    const int headUp = currentPlane.currentIndex;
+    const int headRight = currentPlane[headUp].currentIndex;
+    return (*this)[currentIndex + front][headUp + up][headRight + right];
+}
+
 unsigned int TMTape1D::getElementSize() const {
     return cells.size();
 }
@@ -44,6 +51,20 @@ unsigned int TMTape3D::getElementSize() const {
     return TMTapeUtils::getGreatestSize(cells);
 }
 
+size_t TMTape1D::getCellCount() const {
+    return cells.size();
+}
+size_t TMTape2D::getCellCount() const {
+    size_t count = 0;
+    for(const auto &line : cells) count += line ? line->getCellCount() : 0;
+    return count;
+}
+size_t TMTape3D::getCellCount() const {
+    size_t count = 0;
+    for(const auto &plane : cells) count += plane ? plane->getCellCount() : 0;
+    return count;
+}
+
 void TMTape1D::replaceCurrentSymbol(const std::string &newSymbol) {
     if(newSymbol != SYMBOL_ANY) (*this)[currentIndex].symbol = newSymbol;
 }
@@ -64,6 +85,29 @@ std::string TMTape3D::getCurrentSymbol() const {
     return at(currentIndex).getCurrentSymbol();
 }
 
+std::string TMTape1D::getSymbolAt(int front, int up, int right) const {
+    const TMTapeCell *cell = front == 0 && up == 0 ? TMTapeUtils::findTapeElement(cells, currentIndex + right, zeroAnchor) : nullptr;
+    return cell ? cell->symbol : TMTapeCell().symbol;
+}
+std::string TMTape2D::getSymbolAt(int front, int up, int right) const {
+    const TMTape1D *row = TMTapeUtils::findTapeElement(cells, currentIndex, zeroAnchor);
+    const TMTape1D *neighbourRow = front == 0 ? TMTapeUtils::findTapeElement(cells, currentIndex + up, zeroAnchor) : nullptr;
+    if(!row || !neighbourRow) return TMTapeCell().symbol;
+    // the row of the head knows where the head is, the other rows are only synced when the head moves onto them
+    const TMTapeCell *cell = TMTapeUtils::findTapeElement(neighbourRow->cells, row->currentIndex + right, neighbourRow->zeroAnchor);
+    return cell ? cell->symbol : TMTapeCell().symbol;
+}
+std::string TMTape3D::getSymbolAt(int front, int up, int right) const {
+    const TMTape2D *plane = TMTapeUtils::findTapeElement(cells, currentIndex, zeroAnchor);
+    const TMTape1D *row = plane ? TMTapeUtils::findTapeElement(plane->cells, plane->currentIndex, plane->zeroAnchor) : nullptr;
+    const TMTape2D *neighbourPlane = TMTapeUtils::findTapeElement(cells, currentIndex + front, zeroAnchor);
+    if(!row || !neighbourPlane) return TMTapeCell().symbol;
+    const TMTape1D *neighbourRow = TMTapeUtils::findTapeElement(neighbourPlane->cells, plane->currentIndex + up, neighbourPlane->zeroAnchor);
+    if(!neighbourRow) return TMTapeCell().symbol;
+    const TMTapeCell *cell = TMTapeUtils::findTapeElement(neighbourRow->cells, row->currentIndex + right, neighbourRow->zeroAnchor);
+    return cell ? cell->symbol : TMTapeCell().symbol;
+}
+
 // the next three methods are ugly...
 bool TMTape1D::moveTapeHead(const TMTapeDirection &direction) {
     int add = 0;
@@ -172,8 +216,18 @@ TMTapeProbabilisticDirection::TMTapeProbabilisticDirection(const std::vector<TMT
     assert(directions.size() == probabilities.size());
                                                            }
 
+static std::mt19937 &directionGenerator() {
+    static std::mt19937 generator(std::random_device{}());
+    return generator;
+}
+
 TMTapeDirection TMTapeProbabilisticDirection::operator()() const {
-    std::mt19937 gen(std::random_device{}());
+    // nothing to draw, so deterministic moves leave the generator alone
+    if(directions.size() == 1) return directions[0];
     std::discrete_distribution<std::size_t> index{probabilities.begin(), probabilities.end()};
-    return directions[index(gen)];
+    return directions[index(directionGenerator())];
+}
+
+void TMTapeProbabilisticDirection::seed(unsigned int value) {
+    directionGenerator().seed(value);
 }
\ No newline at end of file
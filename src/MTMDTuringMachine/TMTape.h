@@ -28,6 +28,11 @@ public:
     : directions({direction}), probabilities({1.0f}) {}
 
     TMTapeDirection operator()() const;
+
+    /**
+     * @brief Reseeds the generator shared by all probabilistic directions, so runs can be reproduced
+     */
+    static void seed(unsigned int value);
 };
 
 
@@ -40,6 +45,15 @@ public:
     virtual bool moveTapeHead(const TMTapeDirection &direction) = 0;
     virtual void replaceCurrentSymbol(const std::string &newSymbol) = 0;
     virtual unsigned int getElementSize() const = 0;
+    /**
+     * @brief The number of cells the tape has grown to hold, over all of its dimensions
+     */
+    virtual size_t getCellCount() const = 0;
+    /**
+     * @brief The symbol at an offset (forwards, up, right) from the head, the head does not move and the tape does not grow,
+     * offsets along dimensions the tape does not have read blanks
+     */
+    virtual std::string getSymbolAt(int front, int up, int right) const = 0;
 
     int currentIndex;
     int zeroAnchor;
@@ -54,9 +68,11 @@ public:
     ~TMTape1D() final = default;
 
     std::string getCurrentSymbol() const final;
+    std::string getSymbolAt(int front, int up, int right) const final;
     bool moveTapeHead(const TMTapeDirection &direction) final;
     void replaceCurrentSymbol(const std::string &newSymbol) final;
     unsigned int getElementSize() const final;
+    size_t getCellCount() const final;
     void print() const;
 
     TMTapeCell& operator[](const signed int &index);
@@ -73,9 +89,11 @@ public:
     ~TMTape2D() final = default;
 
     std::string getCurrentSymbol() const final;
+    std::string getSymbolAt(int front, int up, int right) const final;
     bool moveTapeHead(const TMTapeDirection &direction) final;
     void replaceCurrentSymbol(const std::string &newSymbol) final;
     unsigned int getElementSize() const final;
+    size_t getCellCount() const final;
     void print() const;
 
 
@@ -93,9 +111,11 @@ public:
     ~TMTape3D() final = default;
 
     std::string getCurrentSymbol() const final;
+    std::string getSymbolAt(int front, int up, int right) const final;
     bool moveTapeHead(const TMTapeDirection &direction) final;
     void replaceCurrentSymbol(const std::string &newSymbol) final;
     unsigned int getElementSize() const final;
+    size_t getCellCount() const final;
 
     void print() const;
 
@@ -103,6 +123,11 @@ public:
     TMTape2D at(const signed int &index) const;
     const std::vector<std::shared_ptr<TMTape2D>>& getCells() const;
 
+    /**
+     * @brief The cell at an offset (forwards, up, right) from the head, the tape grows to contain it but the head does not move
+     */
+    TMTapeCell& cellAt(int front, int up, int right);
+
 };
 typedef std::vector<TMTape*> TMTapes;
 #endif //MTMDTURINGMACHINE_TMTAPE_H
@@ -21,6 +21,12 @@ namespace TMTapeUtils {
         }
         return *cells[index+zeroAnchor];
     }
+    // without copying or expanding, nullptr if the index is not on the tape yet
+    template<class TMTapeElement>
+    const TMTapeElement* findTapeElement(const std::vector<std::shared_ptr<TMTapeElement>> &cells, const int &index, const int &zeroAnchor) {
+        if(index + zeroAnchor < 0 || index + zeroAnchor >= (int) cells.size()) return nullptr;
+        return cells[index+zeroAnchor].get();
+    }
     template<class TMTapeElement>
     int getMaximumIndex(const std::vector<std::shared_ptr<TMTapeElement>> &cells, const int &zeroAnchor) {
         return cells.size()-zeroAnchor-1;
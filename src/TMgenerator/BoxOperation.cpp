@@ -0,0 +1,61 @@
+//
+
+#include "BoxOperation.h"
+
+#include <stdexcept>
+
+void BoxOperation::operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const {
+    const auto tape3D = [&tapes](unsigned int index) -> TMTape3D& {
+        auto *tape = dynamic_cast<TMTape3D*>(tapes.at(index));
+        if(!tape) throw std::runtime_error("Boxes only exist on three dimensional tapes");
+        return *tape;
+    };
+    TMTape3D &world = tape3D(operation == Box_Copy ? destinationTape : 0);
+    switch(operation){
+        case Box_Fill:{
+            for (int i = 0; i < x; ++i) {
+                for (int k = 0; k < z; ++k) {
+                    for (int j = 0; j < y; ++j) world.cellAt(i, k, j).symbol = symbol;
+                }
+            }
+            break;
+        }
+        case Box_Copy:{
+            TMTape3D &source = tape3D(sourceTape);
+            for (int i = 0; i < x; ++i) {
+                for (int k = 0; k < z; ++k) {
+                    for (int j = 0; j < y; ++j) world.cellAt(i, k, j).symbol = source.cellAt(i, k, j).symbol;
+                }
+            }
+            source.moveTapeHead(Stationary);
+            break;
+        }
+        case Box_Shift:{
+            const int front = direction == Front ? distance : direction == Back ? -distance : 0;
+            const int up = direction == Up ? distance : direction == Down ? -distance : 0;
+            const int right = direction == Right ? distance : direction == Left ? -distance : 0;
+            // the box is lifted off the tape before it is put down again, so overlapping shifts read the original symbols
+            std::vector<string> contents;
+            contents.reserve((size_t) x * y * z);
+            for (int i = 0; i < x; ++i) {
+                for (int k = 0; k < z; ++k) {
+                    for (int j = 0; j < y; ++j) {
+                        TMTapeCell &cell = world.cellAt(i, k, j);
+                        contents.push_back(std::move(cell.symbol));
+                        cell.symbol = "B";
+                    }
+                }
+            }
+            auto content = contents.begin();
+            for (int i = 0; i < x; ++i) {
+                for (int k = 0; k < z; ++k) {
+                    for (int j = 0; j < y; ++j) world.cellAt(front + i, up + k, right + j).symbol = std::move(*content++);
+                }
+            }
+            break;
+        }
+    }
+    // the planes and rows the box added get the position of the head like the ones that were already there
+    world.moveTapeHead(Stationary);
+    changedTapesIndex.push_back(operation == Box_Copy ? destinationTape : 0);
+}
@@ -0,0 +1,44 @@
+//
+
+#ifndef VOXELFUSION_BOXOPERATION_H
+#define VOXELFUSION_BOXOPERATION_H
+
+#include "../MTMDTuringMachine/FiniteControl.h"
+
+using std::string;
+
+enum BoxOperationType {Box_Fill, Box_Copy, Box_Shift};
+
+/**
+ * @brief Works on a box of x by y by z voxels of the three dimensional tapes in a single transition.
+ * The box starts under the head and extends forwards (x), right (y) and up (z), like a cellular automaton run,
+ * no head moves. Filling writes a symbol in every voxel of the world tape, copying copies the box under the head of one
+ * three dimensional tape to the box under the head of the other one, and shifting moves the contents of the box on the
+ * world tape a distance in a direction, leaving blanks behind
+ */
+class BoxOperation final : public TMMacro {
+public:
+    const BoxOperationType operation;
+    const int x, y, z;
+    // the symbol that fills the box
+    const string symbol;
+    const unsigned int sourceTape, destinationTape;
+    const TMTapeDirection direction;
+    const int distance;
+
+    BoxOperation(BoxOperationType operation, int x, int y, int z, const string &symbol = "",
+                 unsigned int sourceTape = 0, unsigned int destinationTape = 0,
+                 TMTapeDirection direction = Stationary, int distance = 0)
+            : operation(operation), x(x), y(y), z(z), symbol(symbol), sourceTape(sourceTape),
+              destinationTape(destinationTape), direction(direction), distance(distance) {}
+
+    void operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const final;
+    string getKey() const final {
+        return "box " + std::to_string(operation) + ' ' + std::to_string(x) + ' ' + std::to_string(y) + ' ' + std::to_string(z) + ' '
+               + symbol + ' ' + std::to_string(sourceTape) + ' ' + std::to_string(destinationTape) + ' ' + std::to_string(direction) + ' '
+               + std::to_string(distance);
+    }
+};
+
+
+#endif //VOXELFUSION_BOXOPERATION_H
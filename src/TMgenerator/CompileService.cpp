@@ -0,0 +1,62 @@
+//
+
+#include "CompileService.h"
+#include "CompiledProgramCache.h"
+#include "TMGenerator.h"
+#include "TasmOptimizer.h"
+#include "utils/Instrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+CompileService::CompileService(std::shared_ptr<const LR1Parser> parser, set<string> tapeAlphabet, bool readableStateNames,
+                               bool optimizeFiniteControl, bool allocateVariableSlots, bool nativeArithmetic,
+                               bool optimizeSyntaxTree, unsigned int threadCount)
+        : parser(std::move(parser)), tapeAlphabet(std::move(tapeAlphabet)), readableStateNames(readableStateNames),
+          optimizeFiniteControl(optimizeFiniteControl), allocateVariableSlots(allocateVariableSlots), nativeArithmetic(nativeArithmetic),
+          optimizeSyntaxTree(optimizeSyntaxTree),
+          threadCount(threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u)),
+          parseTableHash(this->parser->getCompiledTable().hash()) {}
+
+CompiledProgram CompileService::compile(const std::string_view &code) const {
+    return compile(code, threadCount);
+}
+
+CompiledProgram CompileService::compile(const std::string_view &code, unsigned int generatorThreadCount) const {
+    INSTRUMENT_SCOPE("compile");
+    CompiledProgram program{tapeAlphabet};
+    TokenStream tokens(code);
+    SyntaxTree tree = parser->parse(tokens);
+    if(optimizeSyntaxTree) TasmOptimizer().optimize(tree);
+    TMGenerator generator{program.tapeAlphabet, program.transitions, program.states, readableStateNames, optimizeFiniteControl,
+                          allocateVariableSlots, nativeArithmetic, generatorThreadCount};
+    generator.assembleTasm(tree.getRoot());
+    return program;
+}
+
+vector<CompiledProgram> CompileService::compile(const vector<std::string_view> &codes) const {
+    vector<CompiledProgram> programs(codes.size());
+    // the threads left over when there are fewer scripts than threads are shared by their generators
+    const unsigned int generatorThreadCount = codes.empty() ? 1 : std::max<unsigned int>(threadCount / codes.size(), 1);
+    std::atomic<size_t> nextCode = 0;
+    const auto work = [&](){
+        for(size_t code = nextCode++; code < codes.size(); code = nextCode++){
+            try{
+                programs[code] = compile(codes[code], generatorThreadCount);
+            }catch(...){
+                programs[code].exception = std::current_exception();
+            }
+        }
+    };
+    vector<std::thread> workers;
+    for(size_t i = 1; i < std::min<size_t>(threadCount, codes.size()); i++) workers.emplace_back(work);
+    work();
+    for(std::thread &worker : workers) worker.join();
+    return programs;
+}
+
+uint64_t CompileService::cacheKey(const std::string_view &code) const {
+    return CompiledProgramCache::key(code, readableStateNames, optimizeFiniteControl, allocateVariableSlots, nativeArithmetic,
+                                     optimizeSyntaxTree, parseTableHash);
+}
@@ -0,0 +1,72 @@
+//
+
+#ifndef VOXELFUSION_COMPILESERVICE_H
+#define VOXELFUSION_COMPILESERVICE_H
+
+#include "../LR1Parser/LR1Parser.h"
+#include "../MTMDTuringMachine/FiniteControl.h"
+
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <set>
+#include <string_view>
+#include <vector>
+
+using std::set, std::string, std::map, std::vector;
+
+/**
+ * @brief The finite control and tape alphabet generated from a TASM script
+ */
+struct CompiledProgram {
+    set<string> tapeAlphabet;
+    set<StatePointer> states;
+    map<TransitionDomain, TransitionImage> transitions;
+    // set instead of the rest if the script could not be compiled
+    std::exception_ptr exception;
+};
+
+/**
+ * @brief Compiles TASM scripts with one parser and one set of options that never change, so it can be shared by any number of threads.
+ * Every script is lexed, parsed and generated on its own, a batch is spread over a fixed number of worker threads
+ * and a single script is generated on all of them
+ */
+class CompileService {
+    const std::shared_ptr<const LR1Parser> parser;
+    const set<string> tapeAlphabet;
+    const bool readableStateNames;
+    const bool optimizeFiniteControl;
+    const bool allocateVariableSlots;
+    const bool nativeArithmetic;
+    const bool optimizeSyntaxTree;
+    const unsigned int threadCount;
+    // the parser can have a table other than the built-in one, which can parse the same code differently
+    const uint64_t parseTableHash;
+
+    [[nodiscard]] CompiledProgram compile(const std::string_view &code, unsigned int generatorThreadCount) const;
+public:
+    /**
+     * @param tapeAlphabet The symbols every tape alphabet starts with
+     * @param threadCount The number of threads a script is generated on, or that share the scripts of a batch, all cores by default
+     */
+    explicit CompileService(std::shared_ptr<const LR1Parser> parser, set<string> tapeAlphabet = {"B"}, bool readableStateNames = false,
+                            bool optimizeFiniteControl = false, bool allocateVariableSlots = false, bool nativeArithmetic = false,
+                            bool optimizeSyntaxTree = false, unsigned int threadCount = 0);
+
+    /**
+     * @throws std::invalid_argument If the script cannot be parsed, or std::runtime_error if it cannot be generated
+     */
+    [[nodiscard]] CompiledProgram compile(const std::string_view &code) const;
+    /**
+     * @return The programs in the order of the scripts, a script that cannot be compiled has the exception instead
+     */
+    [[nodiscard]] vector<CompiledProgram> compile(const vector<std::string_view> &codes) const;
+    /**
+     * @return The key of the program compiled from the code with the options of this service in a CompiledProgramCache
+     */
+    [[nodiscard]] uint64_t cacheKey(const std::string_view &code) const;
+};
+
+
+#endif //VOXELFUSION_COMPILESERVICE_H
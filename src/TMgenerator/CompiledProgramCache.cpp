@@ -0,0 +1,248 @@
+//
+
+#include "CompiledProgramCache.h"
+#include "NativeArithmetic.h"
+#include "BoxOperation.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+using std::vector;
+
+// bump whenever the generator or the file layout changes what a key stands for
+static const uint32_t CacheVersion = 8;
+static const char CacheMagic[4] = {'V', 'F', 'T', 'M'};
+static const uint8_t NoMacro = 0xFF;
+static const uint8_t SweepBoxMacro = 0xFE;
+static const uint8_t BoxOperationMacro = 0xFD;
+
+namespace {
+    class Writer {
+        std::ofstream &output;
+        std::unordered_map<string, uint32_t> stringIds;
+    public:
+        explicit Writer(std::ofstream &output) : output(output) {}
+        template<class T>
+        void number(T value) {output.write(reinterpret_cast<const char *>(&value), sizeof(T));}
+        void symbols(const set<string> &strings) {
+            // every symbol is written once, the transitions refer to them by index
+            number<uint32_t>(strings.size());
+            for(const string &symbol : strings) {
+                stringIds.emplace(symbol, stringIds.size());
+                number<uint32_t>(symbol.size());
+                output.write(symbol.data(), (std::streamsize) symbol.size());
+            }
+        }
+        void symbol(const string &symbol) {number(stringIds.at(symbol));}
+    };
+
+    class Reader {
+        std::ifstream &input;
+        vector<string> strings;
+    public:
+        explicit Reader(std::ifstream &input) : input(input) {}
+        template<class T>
+        T number() {
+            T value{};
+            if(!input.read(reinterpret_cast<char *>(&value), sizeof(T))) throw std::runtime_error("cached program is truncated");
+            return value;
+        }
+        const vector<string> &symbols() {
+            const auto count = number<uint32_t>();
+            for(uint32_t i = 0; i < count; i++) {
+                string symbol(number<uint32_t>(), '\0');
+                if(!input.read(symbol.data(), (std::streamsize) symbol.size())) throw std::runtime_error("cached program is truncated");
+                strings.push_back(symbol);
+            }
+            return strings;
+        }
+        const string &symbol() {return strings.at(number<uint32_t>());}
+    };
+}
+
+CompiledProgramCache::CompiledProgramCache(const std::filesystem::path &directory) : directory(directory) {}
+
+std::filesystem::path CompiledProgramCache::pathOf(uint64_t key) const {
+    std::stringstream name;
+    name << std::hex << key << ".tmc";
+    return directory / name.str();
+}
+
+uint64_t CompiledProgramCache::key(const std::string_view &code, bool readableStateNames, bool optimizeFiniteControl,
+                                   bool allocateVariableSlots, bool nativeArithmetic, bool optimizeSyntaxTree,
+                                   uint64_t parseTableHash) {
+    std::stringstream options;
+    options << CacheVersion << ' ' << BINARY_VALUE_WIDTH << ' ' << readableStateNames << optimizeFiniteControl
+            << allocateVariableSlots << nativeArithmetic << optimizeSyntaxTree << ' ' << parseTableHash << '\n';
+    uint64_t hash = 14695981039346656037ull;
+    const string optionsString = options.str();
+    for(const std::string_view &part : {std::string_view(optionsString), code}) {
+        for(const char c : part) {
+            hash ^= (unsigned char) c;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+void CompiledProgramCache::store(uint64_t key, const set<string> &tapeAlphabet, const set<StatePointer> &states,
+                                 const map<TransitionDomain, TransitionImage> &transitions) const {
+    set<string> strings = tapeAlphabet;
+    std::unordered_map<StatePointer, uint32_t> stateIds;
+    for(const StatePointer &state : states) {
+        stateIds.emplace(state, stateIds.size());
+        strings.insert(state->name);
+    }
+    for(const auto &[domain, image] : transitions) {
+        strings.insert(domain.replacedSymbols.begin(), domain.replacedSymbols.end());
+        strings.insert(image.replacementSymbols.begin(), image.replacementSymbols.end());
+        if(!image.macro || std::dynamic_pointer_cast<const SweepBox>(image.macro)) continue;
+        if(const auto box = std::dynamic_pointer_cast<const BoxOperation>(image.macro)) {
+            strings.insert(box->symbol);
+            continue;
+        }
+        const auto native = std::dynamic_pointer_cast<const NativeArithmetic>(image.macro);
+        // other macros can not be rebuilt from a file
+        if(!native) return;
+        strings.insert(native->operand);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    const std::filesystem::path path = pathOf(key);
+    const std::filesystem::path temporaryPath = path.string() + ".tmp";
+    std::ofstream output(temporaryPath, std::ios::binary);
+    if(!output) {
+        std::cerr << "Could not write the compiled program to " << temporaryPath << std::endl;
+        return;
+    }
+    Writer writer(output);
+    output.write(CacheMagic, sizeof(CacheMagic));
+    writer.number(CacheVersion);
+    writer.number(key);
+    writer.symbols(strings);
+    writer.number<uint32_t>(tapeAlphabet.size());
+    for(const string &symbol : tapeAlphabet) writer.symbol(symbol);
+    writer.number<uint32_t>(states.size());
+    for(const StatePointer &state : states) {
+        writer.symbol(state->name);
+        writer.number<uint8_t>(state->type);
+        writer.number<uint8_t>(state->isInitial);
+    }
+    writer.number<uint32_t>(transitions.size());
+    for(const auto &[domain, image] : transitions) {
+        writer.number(stateIds.at(domain.state));
+        writer.number(stateIds.at(image.state));
+        writer.number<uint8_t>(domain.replacedSymbols.size());
+        for(const string &symbol : domain.replacedSymbols) writer.symbol(symbol);
+        for(const string &symbol : image.replacementSymbols) writer.symbol(symbol);
+        for(const TMTapeProbabilisticDirection &direction : image.directions) {
+            writer.number<uint8_t>(direction.directions.size());
+            for(unsigned int i = 0; i < direction.directions.size(); i++) {
+                writer.number<char>(direction.directions[i]);
+                writer.number(direction.probabilities[i]);
+            }
+        }
+        const auto native = std::dynamic_pointer_cast<const NativeArithmetic>(image.macro);
+        const auto sweep = std::dynamic_pointer_cast<const SweepBox>(image.macro);
+        const auto box = std::dynamic_pointer_cast<const BoxOperation>(image.macro);
+        writer.number<uint8_t>(native ? native->operation : sweep ? SweepBoxMacro : box ? BoxOperationMacro : NoMacro);
+        if(native) {
+            writer.symbol(native->operand);
+            writer.number<int32_t>(native->width);
+        }
+        if(sweep) {
+            for(const int size : {sweep->x, sweep->y, sweep->z}) writer.number<int32_t>(size);
+            writer.number<uint8_t>(sweep->tapesToMove.size());
+            for(const unsigned int tape : sweep->tapesToMove) writer.number<uint8_t>(tape);
+        }
+        if(box) {
+            writer.number<uint8_t>(box->operation);
+            for(const int size : {box->x, box->y, box->z}) writer.number<int32_t>(size);
+            writer.symbol(box->symbol);
+            writer.number<uint8_t>(box->sourceTape);
+            writer.number<uint8_t>(box->destinationTape);
+            writer.number<char>(box->direction);
+            writer.number<int32_t>(box->distance);
+        }
+    }
+    output.close();
+    // a run that is interrupted never leaves half a program behind
+    if(output) std::filesystem::rename(temporaryPath, path, error);
+    else std::filesystem::remove(temporaryPath, error);
+}
+
+bool CompiledProgramCache::load(uint64_t key, set<string> &tapeAlphabet, set<StatePointer> &states,
+                                map<TransitionDomain, TransitionImage> &transitions) const {
+    std::ifstream input(pathOf(key), std::ios::binary);
+    if(!input) return false;
+    try {
+        Reader reader(input);
+        char magic[sizeof(CacheMagic)];
+        if(!input.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), CacheMagic)) return false;
+        if(reader.number<uint32_t>() != CacheVersion || reader.number<uint64_t>() != key) return false;
+        reader.symbols();
+        set<string> loadedAlphabet;
+        for(auto count = reader.number<uint32_t>(); count > 0; count--) loadedAlphabet.insert(reader.symbol());
+        vector<StatePointer> loadedStates(reader.number<uint32_t>());
+        for(StatePointer &state : loadedStates) {
+            const string &name = reader.symbol();
+            const auto type = (StateType) reader.number<uint8_t>();
+            const bool isInitial = reader.number<uint8_t>();
+            state = std::make_shared<const State>(name, isInitial, type);
+        }
+        map<TransitionDomain, TransitionImage> loadedTransitions;
+        for(auto count = reader.number<uint32_t>(); count > 0; count--) {
+            const StatePointer &from = loadedStates.at(reader.number<uint32_t>());
+            const StatePointer &to = loadedStates.at(reader.number<uint32_t>());
+            vector<string> replacedSymbols(reader.number<uint8_t>());
+            vector<string> replacementSymbols(replacedSymbols.size());
+            for(string &symbol : replacedSymbols) symbol = reader.symbol();
+            for(string &symbol : replacementSymbols) symbol = reader.symbol();
+            vector<TMTapeProbabilisticDirection> directions;
+            for(unsigned int i = 0; i < replacedSymbols.size(); i++) {
+                vector<TMTapeDirection> tapeDirections(reader.number<uint8_t>());
+                vector<float> probabilities(tapeDirections.size());
+                for(unsigned int j = 0; j < tapeDirections.size(); j++) {
+                    tapeDirections[j] = (TMTapeDirection) reader.number<char>();
+                    probabilities[j] = reader.number<float>();
+                }
+                directions.emplace_back(tapeDirections, probabilities);
+            }
+            MacroPointer macro;
+            const auto operation = reader.number<uint8_t>();
+            if(operation == SweepBoxMacro) {
+                const auto x = reader.number<int32_t>();
+                const auto y = reader.number<int32_t>();
+                const auto z = reader.number<int32_t>();
+                vector<unsigned int> tapesToMove(reader.number<uint8_t>());
+                for(unsigned int &tape : tapesToMove) tape = reader.number<uint8_t>();
+                macro = std::make_shared<const SweepBox>(x, y, z, tapesToMove);
+            }else if(operation == BoxOperationMacro) {
+                const auto boxOperation = (BoxOperationType) reader.number<uint8_t>();
+                const auto x = reader.number<int32_t>();
+                const auto y = reader.number<int32_t>();
+                const auto z = reader.number<int32_t>();
+                const string &symbol = reader.symbol();
+                const auto sourceTape = reader.number<uint8_t>();
+                const auto destinationTape = reader.number<uint8_t>();
+                const auto direction = (TMTapeDirection) reader.number<char>();
+                macro = std::make_shared<const BoxOperation>(boxOperation, x, y, z, symbol, sourceTape, destinationTape,
+                                                             direction, reader.number<int32_t>());
+            }else if(operation != NoMacro) {
+                const string &operand = reader.symbol();
+                macro = std::make_shared<const NativeArithmetic>((NativeOperation) operation, operand, reader.number<int32_t>());
+            }
+            loadedTransitions.emplace(TransitionDomain(from, replacedSymbols), TransitionImage(to, replacementSymbols, directions, macro));
+        }
+        tapeAlphabet.insert(loadedAlphabet.begin(), loadedAlphabet.end());
+        states.insert(loadedStates.begin(), loadedStates.end());
+        transitions.insert(loadedTransitions.begin(), loadedTransitions.end());
+        return true;
+    } catch(const std::exception &exception) {
+        std::cerr << "Ignoring the cached program " << pathOf(key) << ": " << exception.what() << std::endl;
+        return false;
+    }
+}
@@ -0,0 +1,44 @@
+//
+
+#ifndef VOXELFUSION_COMPILEDPROGRAMCACHE_H
+#define VOXELFUSION_COMPILEDPROGRAMCACHE_H
+
+#include "../MTMDTuringMachine/FiniteControl.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string_view>
+
+using std::set, std::string, std::map;
+
+/**
+ * @brief Keeps the finite controls generated from TASM scripts in compact binary files,
+ * so a script that did not change since its last run does not have to be lexed, parsed and generated again
+ */
+class CompiledProgramCache {
+    const std::filesystem::path directory;
+
+    [[nodiscard]] std::filesystem::path pathOf(uint64_t key) const;
+public:
+    explicit CompiledProgramCache(const std::filesystem::path &directory = ".tasmcache");
+
+    /**
+     * @brief Identifies a compilation by the FNV-1a hash of the source code and every option that changes the output
+     * @param parseTableHash The hash of the parse table the code is parsed with, see CompiledParseTable::hash()
+     */
+    static uint64_t key(const std::string_view &code, bool readableStateNames, bool optimizeFiniteControl,
+                        bool allocateVariableSlots, bool nativeArithmetic, bool optimizeSyntaxTree, uint64_t parseTableHash);
+
+    /**
+     * @return Whether the program was found, the containers are only filled if it was
+     */
+    bool load(uint64_t key, set<string> &tapeAlphabet, set<StatePointer> &states,
+              map<TransitionDomain, TransitionImage> &transitions) const;
+    void store(uint64_t key, const set<string> &tapeAlphabet, const set<StatePointer> &states,
+               const map<TransitionDomain, TransitionImage> &transitions) const;
+};
+
+
+#endif //VOXELFUSION_COMPILEDPROGRAMCACHE_H
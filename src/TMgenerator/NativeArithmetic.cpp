@@ -0,0 +1,191 @@
+//
+
+#include "NativeArithmetic.h"
+
+#include <algorithm>
+#include <array>
+
+static_assert(BINARY_VALUE_WIDTH <= 64, "native arithmetic keeps values in 64 bits");
+
+static uint64_t readValue(TMTape &tape, int width) {
+    uint64_t value = 0;
+    for (int i = 0; i < width; ++i) {
+        if(tape.getCurrentSymbol() == "1") value |= uint64_t(1) << i;
+        tape.moveTapeHead(Right);
+    }
+    return value;
+}
+
+static void writeValue(TMTape &tape, uint64_t value, int width, std::vector<unsigned int> &changedTapesIndex) {
+    bool changed = false;
+    for (int i = 0; i < width; ++i) {
+        const string bit = (value >> i) & 1 ? "1" : "0";
+        if(tape.getCurrentSymbol() != bit){
+            tape.replaceCurrentSymbol(bit);
+            changed = true;
+        }
+        tape.moveTapeHead(Right);
+    }
+    if(changed) changedTapesIndex.push_back(1);
+}
+
+static void moveHead(TMTape &tape, int offset) {
+    for (int i = 0; i < std::abs(offset); ++i) tape.moveTapeHead(offset > 0 ? Right : Left);
+}
+
+void NativeArithmetic::operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const {
+    TMTape &variables = *tapes.at(1);
+    TMTape &scratch = *tapes.at(2);
+    uint64_t immediate = 0;
+    for (unsigned int i = 0; i < operand.size(); ++i) {
+        if(operand[i] == '1') immediate |= uint64_t(1) << i;
+    }
+    switch(operation){
+        case Native_Addition:
+        case Native_And:{
+            const uint64_t value = readValue(variables, BINARY_VALUE_WIDTH);
+            moveHead(variables, -BINARY_VALUE_WIDTH);
+            writeValue(variables, operation == Native_Addition ? value + immediate : value & immediate, BINARY_VALUE_WIDTH, changedTapesIndex);
+            break;
+        }
+        case Native_Compare:
+        case Native_CompareReturning:{
+            // the head stops on the first bit that differs, like the subroutine
+            int matched = 0;
+            while(matched < BINARY_VALUE_WIDTH && variables.getCurrentSymbol() == string(1, operand[matched])){
+                variables.moveTapeHead(Right);
+                matched++;
+            }
+            const bool equal = matched == BINARY_VALUE_WIDTH;
+            if(!equal && operation == Native_CompareReturning) moveHead(variables, -matched);
+            // the finite control branches on the outcome, which is left under the head of the third tape
+            scratch.replaceCurrentSymbol(equal ? "1" : "0");
+            changedTapesIndex.push_back(2);
+            break;
+        }
+        case Native_TapeAddition:
+        case Native_TapeSubtraction:{
+            const uint64_t value = readValue(variables, BINARY_VALUE_WIDTH);
+            const uint64_t term = readValue(scratch, BINARY_VALUE_WIDTH);
+            moveHead(variables, -BINARY_VALUE_WIDTH);
+            writeValue(variables, operation == Native_TapeAddition ? value + term : value - term, BINARY_VALUE_WIDTH, changedTapesIndex);
+            break;
+        }
+        case Native_Multiplication:{
+            // the multiplier is in the system variable, which the repeated additions count down to 0
+            const uint64_t multiplicand = readValue(variables, BINARY_VALUE_WIDTH);
+            // relative to the start of the variable tape
+            int valueStart = -BINARY_VALUE_WIDTH;
+            while(variables.getCurrentSymbol() != "VTB"){
+                variables.moveTapeHead(Left);
+                valueStart++;
+            }
+            variables.moveTapeHead(Right);
+            const uint64_t multiplier = readValue(variables, BINARY_VALUE_WIDTH);
+            moveHead(variables, -BINARY_VALUE_WIDTH);
+            writeValue(variables, 0, BINARY_VALUE_WIDTH, changedTapesIndex);
+            moveHead(variables, valueStart - BINARY_VALUE_WIDTH - 1);
+            writeValue(variables, multiplicand * multiplier, BINARY_VALUE_WIDTH, changedTapesIndex);
+            // the subroutine ends right after finding the counter at 0 and erasing its copy of the multiplicand
+            moveHead(variables, 2 - valueStart);
+            moveHead(scratch, -2);
+            break;
+        }
+        case Native_Division:{
+            // the divisor is in the system variable, which is left holding its magnitude
+            const uint64_t mask = (uint64_t(2) << (BINARY_VALUE_WIDTH - 1)) - 1;
+            const auto negative = [](uint64_t value){return (value >> (BINARY_VALUE_WIDTH - 1)) & 1;};
+            const auto magnitude = [&](uint64_t value){return negative(value) ? -value & mask : value;};
+            const uint64_t dividend = readValue(variables, BINARY_VALUE_WIDTH);
+            int valueStart = -BINARY_VALUE_WIDTH;
+            while(variables.getCurrentSymbol() != "VTB"){
+                variables.moveTapeHead(Left);
+                valueStart++;
+            }
+            variables.moveTapeHead(Right);
+            const uint64_t divisor = readValue(variables, BINARY_VALUE_WIDTH);
+            moveHead(variables, -BINARY_VALUE_WIDTH);
+            writeValue(variables, magnitude(divisor), BINARY_VALUE_WIDTH, changedTapesIndex);
+            // dividing by 0 gives all ones, like the long division does
+            const uint64_t quotient = magnitude(divisor) ? magnitude(dividend) / magnitude(divisor) : mask;
+            const bool negated = magnitude(divisor) && negative(dividend) != negative(divisor);
+            moveHead(variables, valueStart - BINARY_VALUE_WIDTH - 1);
+            writeValue(variables, negated ? -quotient : quotient, BINARY_VALUE_WIDTH, changedTapesIndex);
+            // the subroutine copies the dividend to the third tape, lays the W + 1 cell remainder window over it and writes
+            // the W quotient bits after that, it leaves the tape blank with the head right after where the quotient was
+            moveHead(scratch, 2 * BINARY_VALUE_WIDTH + 1);
+            break;
+        }
+        case Native_Random:{
+            // draws exactly like the probabilistic transitions of the subroutine
+            const TMTapeProbabilisticDirection coin{{Stationary, Right}, {0.5, 0.5}};
+            uint64_t value = 0;
+            for (int i = 0; i < width; ++i) {
+                if(coin() == Right) value |= uint64_t(1) << i;
+            }
+            writeValue(variables, value, width, changedTapesIndex);
+            break;
+        }
+    }
+}
+
+void SweepBox::operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const {
+    TMTape &variables = *tapes.at(1);
+    const auto moveTapes = [&](TMTapeDirection direction, int times){
+        for(int i = 0; i < times; ++i){
+            for(unsigned int tape : tapesToMove) tapes.at(tape)->moveTapeHead(direction);
+        }
+    };
+    // positions are relative to the start of the variable tape, the counters are looked up from there like the generated machine does
+    int headPosition = 0;
+    while(variables.getCurrentSymbol() != "VTB"){
+        variables.moveTapeHead(Left);
+        headPosition++;
+    }
+    const std::array<string, 3> counterNames = {"Xcounter", "Ycounter", "Zcounter"};
+    std::array<int, 3> valuePositions = {-1, -1, -1};
+    int position = 0;
+    for(; variables.getCurrentSymbol() != "VTE"; position++){
+        for(unsigned int i = 0; i < counterNames.size(); ++i){
+            if(valuePositions[i] < 0 && variables.getCurrentSymbol() == counterNames[i]) valuePositions[i] = position + 1;
+        }
+        variables.moveTapeHead(Right);
+    }
+    if(std::find(valuePositions.begin(), valuePositions.end(), -1) != valuePositions.end()){
+        throw std::runtime_error("The sweep counters are not on the variable tape");
+    }
+    std::array<uint64_t, 3> counters{};
+    for(unsigned int i = 0; i < counters.size(); ++i){
+        moveHead(variables, valuePositions[i] - position);
+        counters[i] = readValue(variables, BINARY_VALUE_WIDTH);
+        position = valuePositions[i] + BINARY_VALUE_WIDTH;
+    }
+
+    // the same moves as the counter machine makes, so the tapes grow the same way
+    bool nextVoxel = true;
+    moveTapes(Front, 1);
+    if(++counters[0] == (uint64_t) x){
+        moveTapes(Right, 1);
+        moveTapes(Back, x);
+        counters[0] = 0;
+        if(++counters[1] == (uint64_t) y){
+            moveTapes(Up, 1);
+            moveTapes(Left, y);
+            counters[1] = 0;
+            if(++counters[2] == (uint64_t) z){
+                moveTapes(Down, z);
+                counters[2] = 0;
+                nextVoxel = false;
+            }
+        }
+    }
+
+    for(unsigned int i = 0; i < counters.size(); ++i){
+        moveHead(variables, valuePositions[i] - position);
+        writeValue(variables, counters[i], BINARY_VALUE_WIDTH, changedTapesIndex);
+        position = valuePositions[i] + BINARY_VALUE_WIDTH;
+    }
+    moveHead(variables, headPosition - position);
+    tapes.at(2)->replaceCurrentSymbol(nextVoxel ? "1" : "0");
+    changedTapesIndex.push_back(2);
+}
@@ -0,0 +1,59 @@
+//
+
+#ifndef VOXELFUSION_NATIVEARITHMETIC_H
+#define VOXELFUSION_NATIVEARITHMETIC_H
+
+#include "../MTMDTuringMachine/FiniteControl.h"
+
+#include <cstdint>
+
+using std::string;
+
+enum NativeOperation {
+    Native_Addition, Native_And, Native_Compare, Native_CompareReturning,
+    Native_TapeAddition, Native_TapeSubtraction, Native_Multiplication, Native_Random,
+    Native_Division
+};
+
+/**
+ * @brief Does the work of one of the bit-serial integer subroutines of the generator in a single transition.
+ * Values are BINARY_VALUE_WIDTH wide two's complement fields on the variable tape (least significant bit first),
+ * the heads start where the subroutine starts and every tape is left exactly as the subroutine leaves it
+ */
+class NativeArithmetic final : public TMMacro {
+public:
+    const NativeOperation operation;
+    // the immediate operand as the generator writes it
+    const string operand;
+    // the amount of random bits
+    const int width;
+
+    explicit NativeArithmetic(NativeOperation operation, const string &operand = "", int width = BINARY_VALUE_WIDTH)
+            : operation(operation), operand(operand), width(width) {}
+
+    void operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const final;
+    string getKey() const final {return "native " + std::to_string(operation) + ' ' + operand + ' ' + std::to_string(width);}
+};
+
+/**
+ * @brief Moves the given tapes to the next voxel of an x by y by z box in raster order (front first, then right, then up),
+ * counting in the Xcounter, Ycounter and Zcounter variables. After the last voxel the tapes are moved back to the first one.
+ * Whether there is a next voxel is left under the head of the third tape, the head of the variable tape ends where it started
+ */
+class SweepBox final : public TMMacro {
+public:
+    const int x, y, z;
+    const std::vector<unsigned int> tapesToMove;
+
+    SweepBox(int x, int y, int z, const std::vector<unsigned int> &tapesToMove) : x(x), y(y), z(z), tapesToMove(tapesToMove) {}
+
+    void operator()(const TMTapes &tapes, std::vector<unsigned int> &changedTapesIndex) const final;
+    string getKey() const final {
+        string key = "sweep " + std::to_string(x) + ' ' + std::to_string(y) + ' ' + std::to_string(z);
+        for(unsigned int tape : tapesToMove) key += ' ' + std::to_string(tape);
+        return key;
+    }
+};
+
+
+#endif //VOXELFUSION_NATIVEARITHMETIC_H
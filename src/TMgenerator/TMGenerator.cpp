@@ -1,14 +1,25 @@
 #include <bitset>
 #include "TMGenerator.h"
+#include "TMOptimizer.h"
+#include "NativeArithmetic.h"
+#include "BoxOperation.h"
+#include "utils/Instrumentation.h"
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
 
-using std::to_string, std::cout, std::cerr, std::endl, std::runtime_error;
+using std::to_string, std::cout, std::cerr, std::endl, std::runtime_error, std::make_shared;
 
 TMGenerator::TMGenerator(set<string> &tapeAlphabet, map<TransitionDomain, TransitionImage> &transitions,
-                         set<StatePointer> &states, bool readableStateNames) : tapeAlphabet(tapeAlphabet),
+                         set<StatePointer> &states, bool readableStateNames, bool optimizeFiniteControl,
+                         bool allocateVariableSlots, bool nativeArithmetic, unsigned int threadCount) : tapeAlphabet(tapeAlphabet),
                                                                   transitions(transitions), states(states),
-                                                                  postponedTransitionBuffer(list<PostponedTransition>()),
-                                                                          readableStateNames(readableStateNames) {}
+                                                                          readableStateNames(readableStateNames),
+                                                                          optimizeFiniteControl(optimizeFiniteControl),
+                                                                          allocateVariableSlots(allocateVariableSlots),
+                                                                          nativeArithmetic(nativeArithmetic),
+                                                                          threadCount(std::max(threadCount, 1u)) {}
 
 void TMGenerator::registerRegularNewline(StatePointer &state) {
     currentLineBeginState = state;
@@ -22,24 +33,24 @@ StatePointer TMGenerator::getNextLineStartState() {
 
     return currentLineBeginState;
 }
-TMTapeDirection TMGenerator::parseDirection(const shared_ptr<STNode> &root) {
+TMTapeDirection TMGenerator::parseDirection(SyntaxNode root) {
     //<Direction> -> e.g. right
-    if(root->label != "<Direction>"){
+    if(root.getLabel() != "<Direction>"){
         throw runtime_error("This AST node does not contain a Direction");
     }
-    char directionAlias = root->children[0]->token->lexeme[0] - 32; //lowercase to uppercase, please forgive me
+    char directionAlias = root.getChild(0).getToken()->lexeme[0] - 32; //lowercase to uppercase, please forgive me
     return (TMTapeDirection)directionAlias;
 }
 
-int TMGenerator::parseInteger(const shared_ptr<STNode> &root) {
-    if(root->token->type != TokenType::Token_Integer){
+int TMGenerator::parseInteger(SyntaxNode root) {
+    if(root.getToken()->type != TokenType::Token_Integer){
         throw runtime_error("This AST node does not contain an Integer");
     }
-    return std::stoi(root->token->lexeme);
+    return std::stoi(root.getToken()->lexeme);
 }
 
-string TMGenerator::parseSymbolLiteral(const shared_ptr<STNode> &root) {
-    return root->children[1]->token->lexeme;
+string TMGenerator::parseSymbolLiteral(SyntaxNode root) {
+    return root.getChild(1).getToken()->lexeme;
 }
 
 template<std::size_t N>
@@ -61,7 +72,8 @@ string TMGenerator::IntegerAsBitString(int in, bool flipped) {
     return bitset.to_string();
 }
 
-void TMGenerator::assembleTasm(const shared_ptr<STNode> root) {
+void TMGenerator::assembleTasm(SyntaxNode root) {
+    INSTRUMENT_SCOPE("generate");
     StatePointer initializationState1 = make_shared<const State>(to_string(-3), true);
     states.insert(initializationState1);
     StatePointer initializationState2 = make_shared<const State>(to_string(-2), false);
@@ -74,6 +86,12 @@ void TMGenerator::assembleTasm(const shared_ptr<STNode> root) {
     lineStartStates[1] = currentLineBeginState;
 
     alphabetExplorer(root);
+    // transitions use these prefixes for tape references and neighbour reads, a symbol starting with one could not be told apart from them
+    for(const string &symbol : tapeAlphabet){
+        if(TapeReference::isReference(symbol) || NeighbourRead::isNeighbourRead(symbol)){
+            throw runtime_error("The tape symbol " + symbol + " starts with a prefix reserved for tape references and neighbour reads");
+        }
+    }
     tapeAlphabet.insert(VariableTapeStart);
     tapeAlphabet.insert(VariableTapeEnd);
     tapeAlphabet.insert("0");
@@ -92,7 +110,8 @@ void TMGenerator::assembleTasm(const shared_ptr<STNode> root) {
 
     vector<StatePointer> writeValueStates = {initializationState2};
     for (int i = 0; i < BINARY_VALUE_WIDTH - 1; ++i) {
-        StatePointer writeValueState = make_shared<const State>("sysvar"+to_string(i), true);
+        StatePointer writeValueState = make_shared<const State>("sysvar"+to_string(i), false);
+        states.insert(writeValueState);
         writeValueStates.push_back(writeValueState);
     }
     //add start symbol
@@ -113,83 +132,98 @@ void TMGenerator::assembleTasm(const shared_ptr<STNode> root) {
            TransitionDomain(*std::next(writeValueStates.end(), -1), {SYMBOL_ANY, "B", "B", SYMBOL_ANY}),
            TransitionImage(initializationState3, {SYMBOL_ANY, "0", "B", SYMBOL_ANY}, {Stationary, Right, Stationary, Stationary})
    });
+    StatePointer writeTapeEnd = initializationState3;
+    neighbourExplorer(root, false);
+    if(allocateVariableSlots){
+        set<string> arrayNames;
+        slotExplorer(root, arrayNames);
+        std::erase_if(slotNames, [this, &arrayNames](const string &name) {
+            return arrayNames.count(name) > 0 || (NeighbourOffsets.count(name) && !storedNeighbours.count(name));
+        });
+        writeTapeEnd = writeVariableSlots(initializationState3);
+        // the head ends up left of the tape end
+        variableHeadPosition = BINARY_VALUE_WIDTH + (int) slotNames.size() * (BINARY_VALUE_WIDTH + 1);
+    }
     //add end symbol
     transitions.insert({
-           TransitionDomain(initializationState3, {SYMBOL_ANY, "B", "B", SYMBOL_ANY}),
+           TransitionDomain(writeTapeEnd, {SYMBOL_ANY, "B", "B", SYMBOL_ANY}),
            TransitionImage(currentLineBeginState, {SYMBOL_ANY, VariableTapeEnd, "B", SYMBOL_ANY}, {Stationary, Left, Stationary, Stationary})
    });
 
-    explorer(root);
+    if(threadCount == 1 || !parallelExplorer(root)) explorer(root);
+    for(const auto &[jump, position, lineNumber] : pendingJumps){
+        variableHeadPosition = position;
+        const auto found = lineHeadPositions.find(lineNumber);
+        postponedTransitionBuffer.emplace_back(normalizeVariableHead(jump, found == lineHeadPositions.end() ? variableHeadHome : found->second), lineNumber);
+    }
 
     // for transitions that need to happen regardless of the symbols read, add them only when we know all possible symbols
     // also, forward goto's!
-    for(const PostponedTransition& transition: postponedTransitionBuffer){
-        StatePointer start = transition.startState == nullptr ? lineStartStates.at(transition.startLine) : transition.startState;
-        StatePointer end = transition.endState == nullptr ? lineStartStates.at(transition.endLine) : transition.endState;
-        set<string> relevantSymbols;
-        if(transition.onlyTheseSymbols){
-            relevantSymbols = transition.leftOutSymbols;
-        }else{
-            // all tape symbols except the left out symbols
-            std::set_difference(tapeAlphabet.begin(), tapeAlphabet.end(), transition.leftOutSymbols.begin(),
-                                transition.leftOutSymbols.end(), std::inserter(relevantSymbols, relevantSymbols.end()));
-        }
-        for (const string& symbol: relevantSymbols) {
-            string replacedBy = transition.toWrite.empty() ? symbol : transition.toWrite;
-            vector<string> replacedSymbols{SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY};
-            vector<string> replacementSymbols{SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY};
-            replacedSymbols.insert(next(replacedSymbols.begin(), transition.tape), symbol);
-            replacementSymbols.insert(next(replacementSymbols.begin(), transition.tape), replacedBy);
-            transitions.insert({
-                                       TransitionDomain(start, replacedSymbols),
-                                       TransitionImage(end, replacementSymbols, transition.directions)
-                               });
-        }
+    postponedTransitionBuffer.build(tapeAlphabet, lineStartStates, transitions, threadCount);
+    INSTRUMENT_COUNTER("generated states", states.size());
+    INSTRUMENT_COUNTER("generated transitions", transitions.size());
+    if(optimizeFiniteControl){
+        const size_t generatedStates = states.size();
+        const size_t generatedTransitions = transitions.size();
+        TMOptimizer(transitions, states).optimize();
+        cout << "Generated a Finite Control with " << states.size() << " states and " << transitions.size() << " transitions"
+             << " (" << generatedStates << " states and " << generatedTransitions << " transitions before optimisation)" << endl;
     }
-    cout << "Generated a Finite Control with " << states.size() << " states and " << transitions.size() << " transitions" << endl;
+    else cout << "Generated a Finite Control with " << states.size() << " states and " << transitions.size() << " transitions" << endl;
+    INSTRUMENT_COUNTER("states", states.size());
+    INSTRUMENT_COUNTER("transitions", transitions.size());
 }
-void TMGenerator::explorer(const shared_ptr<STNode> &root) {
-    string l = root->label;
+void TMGenerator::explorer(SyntaxNode root) {
+    string l = root.getLabel();
     if(l == "<StatementList>"){
-        if(root->children.size() == 2){
-            explorer(root->children[1]);
+        if(root.getChildCount() == 2){
+            explorer(root.getChild(1));
         }
-        explorer(root->children[0]);
+        explorer(root.getChild(0));
     }else if(l == "<Statement>"){
-        explorer(root->children[0]);
+        explorer(root.getChild(0));
     }else{
+        if(jumpTargetLines.count(currentLineNumber)){
+            if(allocateVariableSlots){
+                // every way into this line leaves the variable tape head at the first variable it needs
+                const int linePosition = firstSlotAccessed(root).value_or(variableHeadPosition.value_or(variableHeadHome));
+                currentLineBeginState = normalizeVariableHead(currentLineBeginState, linePosition);
+                lineStartStates[currentLineNumber] = currentLineBeginState;
+                lineHeadPositions[currentLineNumber] = linePosition;
+            }else variableHeadPosition.reset();
+        }
         if(l == "<TapeMove>"){
             StatePointer first = currentLineBeginState;
             StatePointer destination = getNextLineStartState();
-            TMTapeDirection direction = parseDirection(root->children[1]);
+            TMTapeDirection direction = parseDirection(root.getChild(1));
             tapeMove(direction, first, destination, 0);
         }
         else if(l == "<TapeWrite>"){
             StatePointer first = currentLineBeginState;
             StatePointer destination = getNextLineStartState();
-            string symbolName = parseSymbolLiteral(root->children[1]);
+            string symbolName = parseSymbolLiteral(root.getChild(1));
             postponedTransitionBuffer.emplace_back(first, destination);
             postponedTransitionBuffer.back().toWrite = symbolName;
         }
         else if(l == "<Jump>"){
             StatePointer first = currentLineBeginState;
-            int destinationLineNumber = parseInteger(root->children[1]);
-            postponedTransitionBuffer.emplace_back(first, destinationLineNumber);
+            int destinationLineNumber = parseInteger(root.getChild(1));
+            jumpToLine(first, destinationLineNumber);
             //next line prep
             StatePointer successor = getNextLineStartState();
         }
         else if(l == "<ReadCondition>"){
             StatePointer first = currentLineBeginState;
             StatePointer standardDestination = getNextLineStartState();
-            string symbolName = parseSymbolLiteral(root->children[3]);
+            string symbolName = parseSymbolLiteral(root.getChild(3));
             postponedTransitionBuffer.emplace_back(first, standardDestination, set<string>{symbolName});
-            int conditionalDestinationLineNumber = parseInteger(root->children[1]);
-            postponedTransitionBuffer.emplace_back(first, conditionalDestinationLineNumber, set<string>{symbolName}, true);
+            int conditionalDestinationLineNumber = parseInteger(root.getChild(1));
+            jumpToLine(first, conditionalDestinationLineNumber, set<string>{symbolName}, true);
         }
         else if(l == "<ConditionalMove>"){
             StatePointer first = currentLineBeginState;
-            TMTapeDirection direction = parseDirection(root->children.at(3));
-            auto symbols = parseIdentifierList(root->children.at(1));
+            TMTapeDirection direction = parseDirection(root.getChild(3));
+            auto symbols = parseIdentifierList(root.getChild(1));
             postponedTransitionBuffer.emplace_back(first, first, symbols);
             postponedTransitionBuffer.back().directions[0] = direction;
             StatePointer conditionalDestination = getNextLineStartState();
@@ -203,14 +237,14 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
         }
         else if(l == "<ImmediateSymbolValueAssignment>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[3]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
             StatePointer destination = getNextLineStartState();
             currentIntoVariable(variableName, first, destination, 0, variableContainingIndex);
         }
         else if(l == "<SymbolValueAssignment>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[3]);
-            string variableValue = parseSymbolLiteral(root->children[1]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
+            string variableValue = parseSymbolLiteral(root.getChild(1));
             StatePointer destination = getNextLineStartState();
             StatePointer writer = MoveToVariableValue(first, variableName, variableContainingIndex);
             // option 1: variable name found: overwrite current value, whatever it is
@@ -237,61 +271,83 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
                 postponedTransitionBuffer.back().toWrite = VariableTapeEnd;
                 postponedTransitionBuffer.emplace_back(writeValue, destination, set<string>{VariableTapeEnd}, true);
                 postponedTransitionBuffer.back().tape = 1;
+                placeVariableHead(variableName, variableContainingIndex, 1);
+        }
+        else if(l == "<SymbolVariableCondition>" && readsNeighbourInPlace(root, insideAutomaton)){
+            StatePointer first = currentLineBeginState;
+            const auto &[front, up, right] = NeighbourOffsets.at(parseVariableLocationContainer(root.getChild(5)).first);
+            string variableValue = parseSymbolLiteral(root.getChild(3));
+            int conditionalDestinationLineNumber = parseInteger(root.getChild(1));
+            StatePointer standardDestination = getNextLineStartState();
+            // the neighbour read is more specific than the fallback, so it is tried first
+            transitions.insert({
+                   TransitionDomain(first, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                   TransitionImage(standardDestination, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}, {Stationary, Stationary, Stationary, Stationary})
+           });
+            PostponedTransition &neighbourMatches = jumpToLine(first, conditionalDestinationLineNumber,
+                                                               set<string>{NeighbourRead::at(front, up, right, variableValue)}, true);
+            neighbourMatches.tape = 3;
+            neighbourMatches.toWrite = SYMBOL_ANY;
         }
         else if(l == "<SymbolVariableCondition>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[5]);
-            string variableValue = parseSymbolLiteral(root->children[3]);
-            int conditionalDestinationLineNumber = parseInteger(root->children[1]);
-            //search for the tape begin marker
-            StatePointer goLeft = makeState();
-            postponedTransitionBuffer.emplace_back(first, goLeft);
-            postponedTransitionBuffer.emplace_back(goLeft, goLeft, set<string>{VariableTapeStart});
-            postponedTransitionBuffer.back().directions[1] = Left;
-            postponedTransitionBuffer.back().tape = 1;
-            //move right until variable name or tape end found
-            StatePointer goRight = makeState();
-            postponedTransitionBuffer.emplace_back(goLeft, goRight, set<string>{VariableTapeStart}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.emplace_back(goRight, goRight, set<string>{variableName, VariableTapeEnd});
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(5));
+            string variableValue = parseSymbolLiteral(root.getChild(3));
+            int conditionalDestinationLineNumber = parseInteger(root.getChild(1));
+            StatePointer observe;
+            if(allocateVariableSlots){
+                observe = MoveToVariableValue(first, variableName, variableContainingIndex);
+            }else{
+                //search for the tape begin marker
+                StatePointer goLeft = makeState();
+                postponedTransitionBuffer.emplace_back(first, goLeft);
+                postponedTransitionBuffer.emplace_back(goLeft, goLeft, set<string>{VariableTapeStart});
+                postponedTransitionBuffer.back().directions[1] = Left;
+                postponedTransitionBuffer.back().tape = 1;
+                //move right until variable name or tape end found
+                StatePointer goRight = makeState();
+                postponedTransitionBuffer.emplace_back(goLeft, goRight, set<string>{VariableTapeStart}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
+                postponedTransitionBuffer.emplace_back(goRight, goRight, set<string>{variableName, VariableTapeEnd});
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
 
-            // move to look at the value
-            StatePointer observe = makeState();
-            postponedTransitionBuffer.emplace_back(goRight, observe);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
+                // move to look at the value
+                observe = makeState();
+                postponedTransitionBuffer.emplace_back(goRight, observe);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
+            }
             //regular condition logic
             StatePointer standardDestination = getNextLineStartState();
             postponedTransitionBuffer.emplace_back(observe, standardDestination, set<string>{variableValue});
             postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.emplace_back(observe, conditionalDestinationLineNumber, set<string>{variableValue}, true);
-            postponedTransitionBuffer.back().tape = 1;
+            jumpToLine(observe, conditionalDestinationLineNumber, set<string>{variableValue}, true).tape = 1;
+            placeVariableHead(variableName, variableContainingIndex, 0);
 
         }else if(l == "<IntegerValueAssignment>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[3]);
-            int assignedValue = parseInteger(root->children[1]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
+            int assignedValue = parseInteger(root.getChild(1));
             std::string binaryAssignedValue = IntegerAsBitString(assignedValue);
             StatePointer destination = getNextLineStartState();
             integerAssignment(variableName, binaryAssignedValue, first, destination, variableContainingIndex);
         }
         else if(l == "<IntegerVariableCondition>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[5]);
-            int comparedValue = parseInteger(root->children[3]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(5));
+            int comparedValue = parseInteger(root.getChild(3));
             std::string binaryComparedValue = IntegerAsBitString(comparedValue);
             StatePointer standardDestination = getNextLineStartState();
-            int conditionalDestinationLineNumber = parseInteger(root->children[1]);
+            int conditionalDestinationLineNumber = parseInteger(root.getChild(1));
             IntegerCompare(variableName, binaryComparedValue, standardDestination,
                            conditionalDestinationLineNumber, first, nullptr, variableContainingIndex);
         }
         else if(l == "<ImmediateAddition>" || l == "<ImmediateSubtraction>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[3]);
-            int addedValue = parseInteger(root->children[1]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
+            int addedValue = parseInteger(root.getChild(1));
             std::string binaryAddedValue = IntegerAsBitString(addedValue, l == "<ImmediateSubtraction>");
             StatePointer destination = getNextLineStartState();
             immediateAddition(variableName, binaryAddedValue, first, destination, variableContainingIndex);
@@ -299,8 +355,8 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
         else if(l == "<BinaryAddition>" || l == "<BinarySubtraction>"){
             StatePointer first = currentLineBeginState;
             //seek second variable and copy to third tape
-            auto [assignedVariableName, assignedVariableContainingIndex] = parseVariableLocationContainer(root->children[3]);
-            auto [readVariableName, readVariableContainingIndex] = parseVariableLocationContainer(root->children[1]);
+            auto [assignedVariableName, assignedVariableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
+            auto [readVariableName, readVariableContainingIndex] = parseVariableLocationContainer(root.getChild(1));
             StatePointer destination = getNextLineStartState();
             StatePointer goRight = MoveToVariableValue(first, readVariableName, readVariableContainingIndex);
             StatePointer firstWriterState;
@@ -357,17 +413,20 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
             postponedTransitionBuffer.back().toWrite = "B";
 
             postponedTransitionBuffer.emplace_back(eraser, destination, set<string>{"B"}, true);
+            postponedTransitionBuffer.back().tape = 2;
+            placeVariableHead(assignedVariableName, assignedVariableContainingIndex, BINARY_VALUE_WIDTH);
         }
         else if(l == "<BinaryVariableCondition>"){
             StatePointer first = currentLineBeginState;
 
-            auto [leftVariableName, leftVariableContainingIndex] = parseVariableLocationContainer(root->children[5]);
-            auto [rightVariableName, rightVariableContainingIndex] = parseVariableLocationContainer(root->children[3]);
+            auto [leftVariableName, leftVariableContainingIndex] = parseVariableLocationContainer(root.getChild(5));
+            auto [rightVariableName, rightVariableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
             StatePointer standardDestination = getNextLineStartState();
-            int conditionalDestinationLineNumber = parseInteger(root->children[1]);
+            int conditionalDestinationLineNumber = parseInteger(root.getChild(1));
 
             // seek second variable and copy it to third tape
             StatePointer moveToValue = MoveToVariableValue(first, rightVariableName, rightVariableContainingIndex);
+            const std::optional<int> rightValuePosition = variableHeadPosition;
 
             // if integer
             StatePointer firstCheckerState;
@@ -455,50 +514,43 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
             postponedTransitionBuffer.back().tape = 2;
             postponedTransitionBuffer.back().directions[2] = Left;
             postponedTransitionBuffer.back().toWrite = "B";
-            postponedTransitionBuffer.emplace_back(trueEraser, conditionalDestinationLineNumber, set<string>{"B"}, true);
+            if(variableHeadPosition) *variableHeadPosition += BINARY_VALUE_WIDTH;
+            jumpToLine(trueEraser, conditionalDestinationLineNumber, set<string>{"B"}, true).tape = 2;
 
             //if symbol
             //copy to third tape
             StatePointer doneCopying2 = makeState();
-            for(const string& copiedSymbol: tapeAlphabet){
-                if(copiedSymbol == "0" || copiedSymbol == "1") continue;
-                transitions.insert({
-                                           TransitionDomain(moveToValue, {SYMBOL_ANY, copiedSymbol, "B", SYMBOL_ANY}),
-                                           TransitionImage(doneCopying2, {SYMBOL_ANY, copiedSymbol, copiedSymbol, SYMBOL_ANY}, {Stationary, Right, Stationary, Stationary})
-                                   });
-            }
+            transitions.insert({
+                                       TransitionDomain(moveToValue, {SYMBOL_ANY, SYMBOL_ANY, "B", SYMBOL_ANY}),
+                                       TransitionImage(doneCopying2, {SYMBOL_ANY, SYMBOL_ANY, TapeReference::symbolOn(1), SYMBOL_ANY}, {Stationary, Right, Stationary, Stationary})
+                               });
             //move to the value
+            variableHeadPosition = rightValuePosition;
+            if(variableHeadPosition) *variableHeadPosition += 1;
             StatePointer checkSingleValue = MoveToVariableValue(doneCopying2, leftVariableName);
 
             StatePointer symbolTrueIntermediate = makeState();
-            postponedTransitionBuffer.emplace_back(symbolTrueIntermediate, conditionalDestinationLineNumber);
-            for(const string& comparedSymbol1: tapeAlphabet){
-                if(comparedSymbol1 == "0" || comparedSymbol1 == "1") continue;
-                transitions.insert({
-                                           TransitionDomain(checkSingleValue, {SYMBOL_ANY, comparedSymbol1, comparedSymbol1, SYMBOL_ANY}),
-                                           TransitionImage(symbolTrueIntermediate, {SYMBOL_ANY, comparedSymbol1, "B", SYMBOL_ANY}, {Stationary, Stationary, Stationary, Stationary})
-                                   });
-                for(const string& comparedSymbol2: tapeAlphabet){
-                    if(comparedSymbol2 == "0" || comparedSymbol2 == "1") continue;
-                    if(comparedSymbol1 != comparedSymbol2){
-                        transitions.insert({
-                                                   TransitionDomain(checkSingleValue, {SYMBOL_ANY, comparedSymbol1, comparedSymbol2, SYMBOL_ANY}),
-                                                   TransitionImage(standardDestination, {SYMBOL_ANY, comparedSymbol1, "B", SYMBOL_ANY}, {Stationary, Stationary, Stationary, Stationary})
-                                           });
-
-                    }
-                }
-            }
+            jumpToLine(symbolTrueIntermediate, conditionalDestinationLineNumber);
+            transitions.insert({
+                                       TransitionDomain(checkSingleValue, {SYMBOL_ANY, SYMBOL_ANY, TapeReference::equalTo(1), SYMBOL_ANY}),
+                                       TransitionImage(symbolTrueIntermediate, {SYMBOL_ANY, SYMBOL_ANY, "B", SYMBOL_ANY}, {Stationary, Stationary, Stationary, Stationary})
+                               });
+            transitions.insert({
+                                       TransitionDomain(checkSingleValue, {SYMBOL_ANY, SYMBOL_ANY, TapeReference::unequalTo(1), SYMBOL_ANY}),
+                                       TransitionImage(standardDestination, {SYMBOL_ANY, SYMBOL_ANY, "B", SYMBOL_ANY}, {Stationary, Stationary, Stationary, Stationary})
+                               });
+            // the integer comparison stops at the first differing bit
+            variableHeadPosition.reset();
         }
         else if(l == "<BinaryMultiplication>" || l == "<ImmediateMultiplication>"){
             StatePointer first = currentLineBeginState;
-            auto [assignedVariableName, assignedVariableContainingIndex] = parseVariableLocationContainer(root->children[3]);
+            auto [assignedVariableName, assignedVariableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
             bool assignedIsArrayElement = assignedVariableContainingIndex != "";
             StatePointer destination = getNextLineStartState();
             StatePointer sysVarLoaded;
             if(l == "<ImmediateMultiplication>"){
                 // write the multiplier to sysvar
-                int multiplier = parseInteger(root->children[1]);
+                int multiplier = parseInteger(root.getChild(1));
                 std::string binaryMultiplier = IntegerAsBitString(multiplier);
                 StatePointer moveToVTB = makeState();
                 postponedTransitionBuffer.emplace_back(first, moveToVTB, std::set<string>{VariableTapeStart});
@@ -525,7 +577,7 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
                 sysVarLoaded = *std::next(writeValueStates1.end(), -1);
             }
             else{
-                auto [readVariableName, readVariableContainingIndex] = parseVariableLocationContainer(root->children[1]);
+                auto [readVariableName, readVariableContainingIndex] = parseVariableLocationContainer(root.getChild(1));
                 // copy the multiplier to third tape
                 StatePointer moveToValue = MoveToVariableValue(first, readVariableName, readVariableContainingIndex);
                 StatePointer doneCopying = copyIntegerToThirdTape(moveToValue, true);
@@ -578,201 +630,260 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
 
             }
 
-            // put multiplicand on third tape
+            // put multiplicand on third tape, right after the system variable
+            variableHeadPosition = 1 + BINARY_VALUE_WIDTH;
             StatePointer moveToValue2 = MoveToVariableValue(sysVarLoaded, assignedVariableName, assignedVariableContainingIndex);
-            StatePointer doneCopying2 = copyIntegerToThirdTape(moveToValue2, true);
-            // erase multiplicand from second tape to start from 0 properly
-            StatePointer eraseMultiplicand = makeState();
-            if(!assignedIsArrayElement){ // naive erase until no more 0 or 1
-                postponedTransitionBuffer.emplace_back(doneCopying2, eraseMultiplicand, std::set<string>{"0", "1"}, true);
-                postponedTransitionBuffer.back().tape = 1;
-                postponedTransitionBuffer.back().directions[1] = Right;
-                postponedTransitionBuffer.back().toWrite = "0";
-                postponedTransitionBuffer.emplace_back(eraseMultiplicand, eraseMultiplicand, std::set<string>{"0", "1"}, true);
-                postponedTransitionBuffer.back().tape = 1;
-                postponedTransitionBuffer.back().directions[1] = Right;
-                postponedTransitionBuffer.back().toWrite = "0";
-            }
-            else{ // erase for fixed length
-                std::vector<StatePointer> writeValueStates1 {doneCopying2};
-                std::vector<StatePointer> returnStates{makeState()};
-                for (int i = 0; i < BINARY_VALUE_WIDTH - 1; ++i) {
-                    writeValueStates1.emplace_back(makeState());
-                    auto last = std::next(writeValueStates1.end(), -1);
-                    auto penultimate = std::next(last, -1);
-                    postponedTransitionBuffer.emplace_back(*penultimate, *last);
+            if(nativeArithmetic){
+                runNatively(moveToValue2, destination, make_shared<NativeArithmetic>(Native_Multiplication));
+                // like the subroutine, which stops right after the counter
+                if(allocateVariableSlots) variableHeadPosition = BINARY_VALUE_WIDTH + 2;
+            }else{
+                StatePointer doneCopying2 = copyIntegerToThirdTape(moveToValue2, true);
+                // everything below is repeated for every addition
+                variableHeadPosition.reset();
+                // erase multiplicand from second tape to start from 0 properly
+                StatePointer eraseMultiplicand = makeState();
+                if(!assignedIsArrayElement){ // naive erase until no more 0 or 1
+                    postponedTransitionBuffer.emplace_back(doneCopying2, eraseMultiplicand, std::set<string>{"0", "1"}, true);
                     postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().directions[1] = Right;
                     postponedTransitionBuffer.back().toWrite = "0";
+                    postponedTransitionBuffer.emplace_back(eraseMultiplicand, eraseMultiplicand, std::set<string>{"0", "1"}, true);
+                    postponedTransitionBuffer.back().tape = 1;
                     postponedTransitionBuffer.back().directions[1] = Right;
+                    postponedTransitionBuffer.back().toWrite = "0";
                 }
-                // turn back
-                postponedTransitionBuffer.emplace_back(writeValueStates1.back(), returnStates.front());
-                postponedTransitionBuffer.back().tape = 1;
-                postponedTransitionBuffer.back().toWrite = "0";
-                postponedTransitionBuffer.back().directions[1] = Left;
-                for (int i = 0; i < BINARY_VALUE_WIDTH - 3; ++i) {
-                    returnStates.emplace_back(makeState());
-                    auto last = std::next(returnStates.end(), -1);
-                    auto penultimate = std::next(last, -1);
-                    postponedTransitionBuffer.emplace_back(*penultimate, *last, std::set<string>{"0"}, true);
+                else{ // erase for fixed length
+                    std::vector<StatePointer> writeValueStates1 {doneCopying2};
+                    std::vector<StatePointer> returnStates{makeState()};
+                    for (int i = 0; i < BINARY_VALUE_WIDTH - 1; ++i) {
+                        writeValueStates1.emplace_back(makeState());
+                        auto last = std::next(writeValueStates1.end(), -1);
+                        auto penultimate = std::next(last, -1);
+                        postponedTransitionBuffer.emplace_back(*penultimate, *last);
+                        postponedTransitionBuffer.back().tape = 1;
+                        postponedTransitionBuffer.back().toWrite = "0";
+                        postponedTransitionBuffer.back().directions[1] = Right;
+                    }
+                    // turn back
+                    postponedTransitionBuffer.emplace_back(writeValueStates1.back(), returnStates.front());
+                    postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().toWrite = "0";
+                    postponedTransitionBuffer.back().directions[1] = Left;
+                    for (int i = 0; i < BINARY_VALUE_WIDTH - 3; ++i) {
+                        returnStates.emplace_back(makeState());
+                        auto last = std::next(returnStates.end(), -1);
+                        auto penultimate = std::next(last, -1);
+                        postponedTransitionBuffer.emplace_back(*penultimate, *last, std::set<string>{"0"}, true);
+                        postponedTransitionBuffer.back().tape = 1;
+                        postponedTransitionBuffer.back().directions[1] = Left;
+                    }
+                    postponedTransitionBuffer.emplace_back(returnStates.back(), eraseMultiplicand, std::set<string>{"0"}, true);
                     postponedTransitionBuffer.back().tape = 1;
                     postponedTransitionBuffer.back().directions[1] = Left;
                 }
-                postponedTransitionBuffer.emplace_back(returnStates.back(), eraseMultiplicand, std::set<string>{"0"}, true);
+                //check counter != 0
+                StatePointer moveToVTB2 = makeState();
+                postponedTransitionBuffer.emplace_back(eraseMultiplicand, moveToVTB2, std::set<string>{VariableTapeStart});
                 postponedTransitionBuffer.back().tape = 1;
                 postponedTransitionBuffer.back().directions[1] = Left;
-            }
-            //check counter != 0
-            StatePointer moveToVTB2 = makeState();
-            postponedTransitionBuffer.emplace_back(eraseMultiplicand, moveToVTB2, std::set<string>{VariableTapeStart});
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Left;
-            postponedTransitionBuffer.emplace_back(moveToVTB2, moveToVTB2, std::set<string>{VariableTapeStart});
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Left;
-            StatePointer checkIsNotZero = makeState();
-            StatePointer prepareCounterDecrement = makeState();
-            StatePointer multiplicationDone = makeState();
-            postponedTransitionBuffer.emplace_back(moveToVTB2, checkIsNotZero, std::set<string>{VariableTapeStart}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.emplace_back(checkIsNotZero, checkIsNotZero, std::set<string>{"0"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.emplace_back(checkIsNotZero, prepareCounterDecrement, std::set<string>{"1"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.emplace_back(checkIsNotZero, multiplicationDone, std::set<string>{VariableTapeStart, "0", "1"});
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-
-            // decrement counter
-            // move to counter start
-            postponedTransitionBuffer.emplace_back(prepareCounterDecrement, prepareCounterDecrement, std::set<string>{"0", "1"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Left;
-            StatePointer counterDecrement = makeState();
-            postponedTransitionBuffer.emplace_back(prepareCounterDecrement, counterDecrement, std::set<string>{VariableTapeStart}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            StatePointer counterDecrementBorrowing = makeState();
-            StatePointer doneDecrementing = makeState();
-            postponedTransitionBuffer.emplace_back(counterDecrement, doneDecrementing, std::set<string>{"1"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.back().toWrite = "0";
-            postponedTransitionBuffer.emplace_back(counterDecrement, counterDecrementBorrowing, std::set<string>{"0"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.back().toWrite = "1";
-            postponedTransitionBuffer.emplace_back(counterDecrementBorrowing, counterDecrementBorrowing, std::set<string>{"0"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.back().toWrite = "1";
-            postponedTransitionBuffer.emplace_back(counterDecrementBorrowing, doneDecrementing, std::set<string>{"1"}, true);
-            postponedTransitionBuffer.back().tape = 1;
-            postponedTransitionBuffer.back().directions[1] = Right;
-            postponedTransitionBuffer.back().toWrite = "0";
+                postponedTransitionBuffer.emplace_back(moveToVTB2, moveToVTB2, std::set<string>{VariableTapeStart});
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Left;
+                StatePointer checkIsNotZero = makeState();
+                StatePointer prepareCounterDecrement = makeState();
+                StatePointer multiplicationDone = makeState();
+                postponedTransitionBuffer.emplace_back(moveToVTB2, checkIsNotZero, std::set<string>{VariableTapeStart}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
+                postponedTransitionBuffer.emplace_back(checkIsNotZero, checkIsNotZero, std::set<string>{"0"}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
+                postponedTransitionBuffer.emplace_back(checkIsNotZero, prepareCounterDecrement, std::set<string>{"1"}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.emplace_back(checkIsNotZero, multiplicationDone, std::set<string>{VariableTapeStart, "0", "1"});
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
 
-            StatePointer moveBackToMultiplicandValue = makeState();
-            if(!assignedIsArrayElement){
-                StatePointer moveBackToMultiplicand = makeState();
-                postponedTransitionBuffer.emplace_back(doneDecrementing, moveBackToMultiplicand, std::set<string>{assignedVariableName});
+                // decrement counter
+                // move to counter start
+                postponedTransitionBuffer.emplace_back(prepareCounterDecrement, prepareCounterDecrement, std::set<string>{"0", "1"}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Left;
+                StatePointer counterDecrement = makeState();
+                postponedTransitionBuffer.emplace_back(prepareCounterDecrement, counterDecrement, std::set<string>{VariableTapeStart}, true);
                 postponedTransitionBuffer.back().tape = 1;
                 postponedTransitionBuffer.back().directions[1] = Right;
-                postponedTransitionBuffer.emplace_back(moveBackToMultiplicand, moveBackToMultiplicand, std::set<string>{assignedVariableName});
+                StatePointer counterDecrementBorrowing = makeState();
+                StatePointer doneDecrementing = makeState();
+                postponedTransitionBuffer.emplace_back(counterDecrement, doneDecrementing, std::set<string>{"1"}, true);
                 postponedTransitionBuffer.back().tape = 1;
                 postponedTransitionBuffer.back().directions[1] = Right;
-                postponedTransitionBuffer.emplace_back(moveBackToMultiplicand, moveBackToMultiplicandValue, std::set<string>{assignedVariableName}, true);
+                postponedTransitionBuffer.back().toWrite = "0";
+                postponedTransitionBuffer.emplace_back(counterDecrement, counterDecrementBorrowing, std::set<string>{"0"}, true);
                 postponedTransitionBuffer.back().tape = 1;
                 postponedTransitionBuffer.back().directions[1] = Right;
-            }else{
-                // go to the end of third tape
-                StatePointer goToEndOfThirdTape = makeState();
-                postponedTransitionBuffer.emplace_back(doneDecrementing, goToEndOfThirdTape, std::set<string>{"0", "1"}, true);
+                postponedTransitionBuffer.back().toWrite = "1";
+                postponedTransitionBuffer.emplace_back(counterDecrementBorrowing, counterDecrementBorrowing, std::set<string>{"0"}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
+                postponedTransitionBuffer.back().toWrite = "1";
+                postponedTransitionBuffer.emplace_back(counterDecrementBorrowing, doneDecrementing, std::set<string>{"1"}, true);
+                postponedTransitionBuffer.back().tape = 1;
+                postponedTransitionBuffer.back().directions[1] = Right;
+                postponedTransitionBuffer.back().toWrite = "0";
+
+                StatePointer moveBackToMultiplicandValue = makeState();
+                if(!assignedIsArrayElement){
+                    StatePointer moveBackToMultiplicand = makeState();
+                    postponedTransitionBuffer.emplace_back(doneDecrementing, moveBackToMultiplicand, std::set<string>{assignedVariableName});
+                    postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().directions[1] = Right;
+                    postponedTransitionBuffer.emplace_back(moveBackToMultiplicand, moveBackToMultiplicand, std::set<string>{assignedVariableName});
+                    postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().directions[1] = Right;
+                    postponedTransitionBuffer.emplace_back(moveBackToMultiplicand, moveBackToMultiplicandValue, std::set<string>{assignedVariableName}, true);
+                    postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().directions[1] = Right;
+                }else{
+                    // go to the end of third tape
+                    StatePointer goToEndOfThirdTape = makeState();
+                    postponedTransitionBuffer.emplace_back(doneDecrementing, goToEndOfThirdTape, std::set<string>{"0", "1"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Right;
+                    postponedTransitionBuffer.emplace_back(goToEndOfThirdTape, goToEndOfThirdTape, std::set<string>{"0", "1"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Right;
+                    StatePointer thirdTapeSeparator = makeState();
+                    postponedTransitionBuffer.emplace_back(goToEndOfThirdTape, thirdTapeSeparator, std::set<string>{"B"}, true);
+                    std::next(postponedTransitionBuffer.end(), -1)->tape = 2;
+                    std::next(postponedTransitionBuffer.end(), -1)->directions[2] = Right;
+                    // seek first variable
+                    StatePointer doneMoving = MoveToVariableValue(thirdTapeSeparator, assignedVariableName, assignedVariableContainingIndex);
+                    // go back to the beginning of the multiplicand
+                    StatePointer skipSeparator = makeState();
+                    postponedTransitionBuffer.emplace_back(doneMoving, skipSeparator, std::set<string>{"B"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Left;
+                    postponedTransitionBuffer.emplace_back(skipSeparator, skipSeparator, std::set<string>{"B"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Left;
+                    StatePointer goBackToStart = makeState();
+                    postponedTransitionBuffer.emplace_back(skipSeparator, goBackToStart, std::set<string>{"0", "1"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Left;
+                    postponedTransitionBuffer.emplace_back(goBackToStart, goBackToStart, std::set<string>{"0", "1"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Left;
+                    postponedTransitionBuffer.emplace_back(goBackToStart, moveBackToMultiplicandValue, std::set<string>{"B"}, true);
+                    postponedTransitionBuffer.back().tape = 2;
+                    postponedTransitionBuffer.back().directions[2] = Right;
+                }
+
+
+                // add once
+                vector<StatePointer> writeValueStates2 = {moveBackToMultiplicandValue, makeState()};
+                addThirdToSecond(writeValueStates2, false);
+                StatePointer oldNormalState = *std::next(writeValueStates2.end(), -2);
+                StatePointer oldCarryState = *std::next(writeValueStates2.end(), -1);
+                //Tape head on third tape back to start
+                StatePointer ThirdTapeBackToStart1 = makeState();
+                StatePointer ThirdTapeBackToStart2 = makeState();
+                postponedTransitionBuffer.emplace_back(oldNormalState, ThirdTapeBackToStart1, std::set<string>{"B"}, true);
                 postponedTransitionBuffer.back().tape = 2;
-                postponedTransitionBuffer.back().directions[2] = Right;
-                postponedTransitionBuffer.emplace_back(goToEndOfThirdTape, goToEndOfThirdTape, std::set<string>{"0", "1"}, true);
+                postponedTransitionBuffer.back().directions[2] = Left;
+                postponedTransitionBuffer.emplace_back(oldCarryState, ThirdTapeBackToStart1, std::set<string>{"B"}, true);
                 postponedTransitionBuffer.back().tape = 2;
-                postponedTransitionBuffer.back().directions[2] = Right;
-                StatePointer thirdTapeSeparator = makeState();
-                postponedTransitionBuffer.emplace_back(goToEndOfThirdTape, thirdTapeSeparator, std::set<string>{"B"}, true);
-                std::next(postponedTransitionBuffer.end(), -1)->tape = 2;
-                std::next(postponedTransitionBuffer.end(), -1)->directions[2] = Right;
-                // seek first variable
-                StatePointer doneMoving = MoveToVariableValue(thirdTapeSeparator, assignedVariableName, assignedVariableContainingIndex);
-                // go back to the beginning of the multiplicand
-                StatePointer skipSeparator = makeState();
-                postponedTransitionBuffer.emplace_back(doneMoving, skipSeparator, std::set<string>{"B"}, true);
+                postponedTransitionBuffer.back().directions[2] = Left;
+                postponedTransitionBuffer.emplace_back(ThirdTapeBackToStart1, ThirdTapeBackToStart2, std::set<string>{"0", "1"}, true);
                 postponedTransitionBuffer.back().tape = 2;
                 postponedTransitionBuffer.back().directions[2] = Left;
-                postponedTransitionBuffer.emplace_back(skipSeparator, skipSeparator, std::set<string>{"B"}, true);
+                postponedTransitionBuffer.emplace_back(ThirdTapeBackToStart2, ThirdTapeBackToStart2, std::set<string>{"0", "1"}, true);
                 postponedTransitionBuffer.back().tape = 2;
                 postponedTransitionBuffer.back().directions[2] = Left;
-                StatePointer goBackToStart = makeState();
-                postponedTransitionBuffer.emplace_back(skipSeparator, goBackToStart, std::set<string>{"0", "1"}, true);
+
+                // go back to check counter
+                postponedTransitionBuffer.emplace_back(ThirdTapeBackToStart2, moveToVTB2, std::set<string>{"B"}, true);
+                postponedTransitionBuffer.back().tape = 2;
+                postponedTransitionBuffer.back().directions[2] = Right;
+
+                // if multiplication done, erase third tape
+                postponedTransitionBuffer.emplace_back(multiplicationDone, multiplicationDone, std::set<string>{"0", "1"}, true);
+                postponedTransitionBuffer.back().tape = 2;
+                postponedTransitionBuffer.back().directions[2] = Right;
+                StatePointer eraser2 = makeState();
+                postponedTransitionBuffer.emplace_back(multiplicationDone, eraser2, std::set<string>{"B"}, true);
                 postponedTransitionBuffer.back().tape = 2;
                 postponedTransitionBuffer.back().directions[2] = Left;
-                postponedTransitionBuffer.emplace_back(goBackToStart, goBackToStart, std::set<string>{"0", "1"}, true);
+                postponedTransitionBuffer.emplace_back(eraser2, eraser2, std::set<string>{"0", "1"}, true);
                 postponedTransitionBuffer.back().tape = 2;
                 postponedTransitionBuffer.back().directions[2] = Left;
-                postponedTransitionBuffer.emplace_back(goBackToStart, moveBackToMultiplicandValue, std::set<string>{"B"}, true);
+                postponedTransitionBuffer.back().toWrite = "B";
+                postponedTransitionBuffer.emplace_back(eraser2, destination, std::set<string>{"B"}, true);
                 postponedTransitionBuffer.back().tape = 2;
-                postponedTransitionBuffer.back().directions[2] = Right;
+                postponedTransitionBuffer.back().directions[2] = Left;
             }
-
-
-            // add once
-            vector<StatePointer> writeValueStates2 = {moveBackToMultiplicandValue, makeState()};
-            addThirdToSecond(writeValueStates2, false);
-            StatePointer oldNormalState = *std::next(writeValueStates2.end(), -2);
-            StatePointer oldCarryState = *std::next(writeValueStates2.end(), -1);
-            //Tape head on third tape back to start
-            StatePointer ThirdTapeBackToStart1 = makeState();
-            StatePointer ThirdTapeBackToStart2 = makeState();
-            postponedTransitionBuffer.emplace_back(oldNormalState, ThirdTapeBackToStart1, std::set<string>{"B"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
-            postponedTransitionBuffer.emplace_back(oldCarryState, ThirdTapeBackToStart1, std::set<string>{"B"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
-            postponedTransitionBuffer.emplace_back(ThirdTapeBackToStart1, ThirdTapeBackToStart2, std::set<string>{"0", "1"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
-            postponedTransitionBuffer.emplace_back(ThirdTapeBackToStart2, ThirdTapeBackToStart2, std::set<string>{"0", "1"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
-
-            // go back to check counter
-            postponedTransitionBuffer.emplace_back(ThirdTapeBackToStart2, moveToVTB2, std::set<string>{"B"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Right;
-
-            // if multiplication done, erase third tape
-            postponedTransitionBuffer.emplace_back(multiplicationDone, multiplicationDone, std::set<string>{"0", "1"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Right;
-            StatePointer eraser2 = makeState();
-            postponedTransitionBuffer.emplace_back(multiplicationDone, eraser2, std::set<string>{"B"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
-            postponedTransitionBuffer.emplace_back(eraser2, eraser2, std::set<string>{"0", "1"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
-            postponedTransitionBuffer.back().toWrite = "B";
-            postponedTransitionBuffer.emplace_back(eraser2, destination, std::set<string>{"B"}, true);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().directions[2] = Left;
+        }
+        else if(l == "<BinaryDivision>" || l == "<ImmediateDivision>"){
+            StatePointer first = currentLineBeginState;
+            auto [assignedVariableName, assignedVariableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
+            StatePointer destination = getNextLineStartState();
+            StatePointer readDivisor = first;
+            if(l == "<BinaryDivision>"){
+                auto [readVariableName, readVariableContainingIndex] = parseVariableLocationContainer(root.getChild(1));
+                StatePointer moveToValue = MoveToVariableValue(first, readVariableName, readVariableContainingIndex);
+                readDivisor = copyIntegerToThirdTape(moveToValue, true);
+            }
+            // the divisor goes into sysvar
+            StatePointer moveToVTB = makeState();
+            postponedTransitionBuffer.emplace_back(readDivisor, moveToVTB);
+            postponedTransitionBuffer.emplace_back(moveToVTB, moveToVTB, std::set<string>{VariableTapeStart});
+            postponedTransitionBuffer.back().tape = 1;
+            postponedTransitionBuffer.back().directions[1] = Left;
+            StatePointer writeDivisor = makeState();
+            postponedTransitionBuffer.emplace_back(moveToVTB, writeDivisor, std::set<string>{VariableTapeStart}, true);
+            postponedTransitionBuffer.back().tape = 1;
+            postponedTransitionBuffer.back().directions[1] = Right;
+            StatePointer sysVarLoaded = makeState();
+            if(l == "<ImmediateDivision>"){
+                std::string binaryDivisor = IntegerAsBitString(parseInteger(root.getChild(1)));
+                vector<StatePointer> writeValueStates = {writeDivisor};
+                for (int i = 0; i < BINARY_VALUE_WIDTH; ++i) {
+                    writeValueStates.push_back(i == BINARY_VALUE_WIDTH - 1 ? sysVarLoaded : makeState());
+                    postponedTransitionBuffer.emplace_back(writeValueStates[i], writeValueStates[i + 1]);
+                    postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().toWrite = binaryDivisor[i];
+                    postponedTransitionBuffer.back().directions[1] = Right;
+                }
+            }else{
+                // move the copy from the third tape, erasing it on the way
+                for(const string bit : {"0", "1"}){
+                    transitions.insert({
+                           TransitionDomain(writeDivisor, {SYMBOL_ANY, SYMBOL_ANY, bit, SYMBOL_ANY}),
+                           TransitionImage(writeDivisor, {SYMBOL_ANY, bit, "B", SYMBOL_ANY}, {Stationary, Right, Right, Stationary})
+                   });
+                }
+                transitions.insert({
+                       TransitionDomain(writeDivisor, {SYMBOL_ANY, SYMBOL_ANY, "B", SYMBOL_ANY}),
+                       TransitionImage(sysVarLoaded, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}, {Stationary, Stationary, Stationary, Stationary})
+               });
+            }
+            variableHeadPosition = 1 + BINARY_VALUE_WIDTH;
+            integerDivision(assignedVariableName, sysVarLoaded, destination, assignedVariableContainingIndex);
         }
         else if(l == "<ImmediateAnd>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[3]);
-            int addedValue = parseInteger(root->children[1]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(3));
+            int addedValue = parseInteger(root.getChild(1));
             std::string binaryAndedValue = IntegerAsBitString(addedValue);
             StatePointer destination = getNextLineStartState();
             bitwiseAnd(variableName, binaryAndedValue, first, destination, variableContainingIndex);
         }
         else if(l == "<CellularAutomatonDeclaration>"){
-            auto symbols = parseIdentifierList(root->children.at(4));
+            auto symbols = parseIdentifierList(root.getChild(4));
+            // the automaton is started from anywhere in the cube loop
+            const std::optional<int> positionBeforeDeclaration = variableHeadPosition;
+            variableHeadPosition.reset();
             if (!CAstart) CAstart = makeState();
             if (!CAend) CAend = makeState();
             StatePointer getDirections = makeState();
@@ -785,6 +896,7 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
                                                                                            {{TMTapeDirection::Down,  TMTapeDirection::Up},    "Down"},
                                                                                            {{TMTapeDirection::Front, TMTapeDirection::Back},  "Front"},
                                                                                            {{TMTapeDirection::Back,  TMTapeDirection::Front}, "Back"}}) {
+                if (!storedNeighbours.count(direction.second)) continue;
                 StatePointer move = makeState();
                 tapeMove(direction.first.first, previous, move, 3);
                 StatePointer store = makeState();
@@ -796,16 +908,19 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
             StatePointer temporarilyHiddenDestination = currentLineBeginState;
             currentLineBeginState = previous;
             currentLineNumber++;
-            explorer(root->children[2]);
+            insideAutomaton = true;
+            explorer(root.getChild(2));
+            insideAutomaton = false;
             postponedTransitionBuffer.emplace_back(currentLineBeginState, CAend);
             registerRegularNewline(temporarilyHiddenDestination);
+            variableHeadPosition = positionBeforeDeclaration;
 
         }
         else if(l == "<CellularAutomatonRun>"){ // NEVER PUT THIS IN A SCRIPT MULTIPLE TIMES
             StatePointer first = currentLineBeginState;
-            int z = parseInteger(root->children[1]);
-            int y = parseInteger(root->children[3]);
-            int x = parseInteger(root->children[5]);
+            int z = parseInteger(root.getChild(1));
+            int y = parseInteger(root.getChild(3));
+            int x = parseInteger(root.getChild(5));
             StatePointer destination = getNextLineStartState();
 
             // update the history tape
@@ -814,11 +929,37 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
             // execute the CA
             doThingForEveryVoxelInCube(x, y, z, historyUpdated, destination, CAstart, CAend, {0,3});
         }
+        else if(l == "<BoxFill>"){
+            StatePointer first = currentLineBeginState;
+            auto [x, y, z] = parseBox(root.getChild(3));
+            string symbol = parseSymbolLiteral(root.getChild(1));
+            StatePointer destination = getNextLineStartState();
+            runNatively(first, destination, make_shared<BoxOperation>(Box_Fill, x, y, z, symbol));
+        }
+        else if(l == "<BoxCopy>"){
+            StatePointer first = currentLineBeginState;
+            auto [x, y, z] = parseBox(root.getChild(5));
+            int sourceTape = parseInteger(root.getChild(3));
+            int destinationTape = parseInteger(root.getChild(1));
+            for (int tape : {sourceTape, destinationTape}) {
+                if(tape != 0 && tape != 3) throw runtime_error("Boxes can only be copied between tape 0 (the world) and tape 3 (its history)");
+            }
+            StatePointer destination = getNextLineStartState();
+            runNatively(first, destination, make_shared<BoxOperation>(Box_Copy, x, y, z, "", sourceTape, destinationTape));
+        }
+        else if(l == "<BoxShift>"){
+            StatePointer first = currentLineBeginState;
+            auto [x, y, z] = parseBox(root.getChild(3));
+            TMTapeDirection direction = parseDirection(root.getChild(2));
+            int distance = parseInteger(root.getChild(1));
+            StatePointer destination = getNextLineStartState();
+            runNatively(first, destination, make_shared<BoxOperation>(Box_Shift, x, y, z, "", 0, 0, direction, distance));
+        }
         else if(l == "<ArrayDeclaration>"){
             StatePointer first = currentLineBeginState;
-            string arrayName = root->children[8]->token->lexeme;
-            int arraySize = parseInteger(root->children[4]);
-            int defaultValue = parseInteger(root->children[2]);
+            string arrayName = root.getChild(8).getToken()->lexeme;
+            int arraySize = parseInteger(root.getChild(4));
+            int defaultValue = parseInteger(root.getChild(2));
             StatePointer destination = getNextLineStartState();
 
             // go to tape end
@@ -850,63 +991,69 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
             postponedTransitionBuffer.emplace_back(writeValueStates.back(), destination);
             postponedTransitionBuffer.back().tape = 1;
             postponedTransitionBuffer.back().toWrite = VariableTapeEnd;
+            variableHeadPosition.reset();
         }
         else if(l == "<RandomInteger>"){
             StatePointer first = currentLineBeginState;
-            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root->children[6]);
-            int width = parseInteger(root->children[2]);
+            auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root.getChild(6));
+            int width = parseInteger(root.getChild(2));
             if(width >= BINARY_VALUE_WIDTH)
                 throw runtime_error("random integer demanded of size larger than what fits in a single variable");
             StatePointer destination = getNextLineStartState();
 
             StatePointer moveToValue = MoveToVariableValue(first, variableName, variableContainingIndex);
-            StatePointer writeTemplate0 = makeState();
-            StatePointer writeTemplate1 = makeState();
-            postponedTransitionBuffer.emplace_back(moveToValue, writeTemplate0);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().toWrite = "0";
-            postponedTransitionBuffer.back().directions[2] = Right;
-            postponedTransitionBuffer.emplace_back(writeTemplate0, writeTemplate1);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().toWrite = "1";
-            postponedTransitionBuffer.back().directions[2] = Left;
+            if(nativeArithmetic){
+                runNatively(moveToValue, destination, make_shared<NativeArithmetic>(Native_Random, "", width));
+            }else{
+                StatePointer writeTemplate0 = makeState();
+                StatePointer writeTemplate1 = makeState();
+                postponedTransitionBuffer.emplace_back(moveToValue, writeTemplate0);
+                postponedTransitionBuffer.back().tape = 2;
+                postponedTransitionBuffer.back().toWrite = "0";
+                postponedTransitionBuffer.back().directions[2] = Right;
+                postponedTransitionBuffer.emplace_back(writeTemplate0, writeTemplate1);
+                postponedTransitionBuffer.back().tape = 2;
+                postponedTransitionBuffer.back().toWrite = "1";
+                postponedTransitionBuffer.back().directions[2] = Left;
 
 
-            std::vector<StatePointer> writeValueStates = {writeTemplate1};
-            for (int i = 0; i < width; ++i) {
-                auto previous = std::next(writeValueStates.end(), -1);
+                std::vector<StatePointer> writeValueStates = {writeTemplate1};
+                for (int i = 0; i < width; ++i) {
+                    auto previous = std::next(writeValueStates.end(), -1);
 
-                StatePointer choose = makeState();
-                TMTapeProbabilisticDirection stay{{Stationary}, {1}};
-                transitions.insert({
-                                           TransitionDomain(*previous, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
-                                           TransitionImage(choose, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}, {stay, stay, {{Stationary, Right}, {0.5, 0.5}}, stay})
-                                   });
-                StatePointer write = makeState();
-                for (const string& pick: {"0", "1"}) {
+                    StatePointer choose = makeState();
+                    TMTapeProbabilisticDirection stay{{Stationary}, {1}};
                     transitions.insert({
-                                               TransitionDomain(choose, {SYMBOL_ANY, SYMBOL_ANY, pick, SYMBOL_ANY}),
-                                               TransitionImage(write, {SYMBOL_ANY, pick, SYMBOL_ANY, SYMBOL_ANY}, {Stationary, Stationary, pick == "1" ? Left : Stationary, Stationary})
+                                               TransitionDomain(*previous, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                                               TransitionImage(choose, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}, {stay, stay, {{Stationary, Right}, {0.5, 0.5}}, stay})
                                        });
+                    StatePointer write = makeState();
+                    for (const string& pick: {"0", "1"}) {
+                        transitions.insert({
+                                                   TransitionDomain(choose, {SYMBOL_ANY, SYMBOL_ANY, pick, SYMBOL_ANY}),
+                                                   TransitionImage(write, {SYMBOL_ANY, pick, SYMBOL_ANY, SYMBOL_ANY}, {Stationary, Stationary, pick == "1" ? Left : Stationary, Stationary})
+                                           });
+                    }
+                    StatePointer shift = makeState();
+                    postponedTransitionBuffer.emplace_back(write, shift);
+                    postponedTransitionBuffer.back().tape = 1;
+                    postponedTransitionBuffer.back().directions[1] = Right;
+                    writeValueStates.push_back(shift);
                 }
-                StatePointer shift = makeState();
-                postponedTransitionBuffer.emplace_back(write, shift);
-                postponedTransitionBuffer.back().tape = 1;
-                postponedTransitionBuffer.back().directions[1] = Right;
-                writeValueStates.push_back(shift);
+                auto last = *std::next(writeValueStates.end(), -1);
+                StatePointer removeTemplate0 = makeState();
+                StatePointer removeTemplate1 = makeState();
+                postponedTransitionBuffer.emplace_back(last, removeTemplate0);
+                postponedTransitionBuffer.back().tape = 2;
+                postponedTransitionBuffer.back().toWrite = "B";
+                postponedTransitionBuffer.back().directions[2] = Right;
+                postponedTransitionBuffer.emplace_back(removeTemplate0, removeTemplate1);
+                postponedTransitionBuffer.back().tape = 2;
+                postponedTransitionBuffer.back().toWrite = "B";
+                postponedTransitionBuffer.back().directions[2] = Left;
+                postponedTransitionBuffer.emplace_back(removeTemplate1, destination);
             }
-            auto last = *std::next(writeValueStates.end(), -1);
-            StatePointer removeTemplate0 = makeState();
-            StatePointer removeTemplate1 = makeState();
-            postponedTransitionBuffer.emplace_back(last, removeTemplate0);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().toWrite = "B";
-            postponedTransitionBuffer.back().directions[2] = Right;
-            postponedTransitionBuffer.emplace_back(removeTemplate0, removeTemplate1);
-            postponedTransitionBuffer.back().tape = 2;
-            postponedTransitionBuffer.back().toWrite = "B";
-            postponedTransitionBuffer.back().directions[2] = Left;
-            postponedTransitionBuffer.emplace_back(removeTemplate1, destination);
+            placeVariableHead(variableName, variableContainingIndex, width);
         }
         else{
             cerr << "Instruction " << l << " is currently not supported by the compiler" << endl;
@@ -914,15 +1061,186 @@ void TMGenerator::explorer(const shared_ptr<STNode> &root) {
     }
 }
 
+// the statements of a list in source order
+static void collectStatements(SyntaxNode root, vector<SyntaxNode> &statements) {
+    if(root.getLabel() == "<StatementList>"){
+        if(root.getChildCount() == 2) collectStatements(root.getChild(1), statements);
+        collectStatements(root.getChild(0), statements);
+    }else statements.push_back(root);
+}
+
+static const string &statementLabel(SyntaxNode statement) {
+    return statement.getLabel() == "<Statement>" ? statement.getChild(0).getLabel() : statement.getLabel();
+}
+
+// a cellular automaton declaration has a line of its own before and after its body
+static int lineCount(SyntaxNode statement) {
+    if(statementLabel(statement) != "<CellularAutomatonDeclaration>") return 1;
+    SyntaxNode declaration = statement.getLabel() == "<Statement>" ? statement.getChild(0) : statement;
+    vector<SyntaxNode> body;
+    collectStatements(declaration.getChild(2), body);
+    int count = 2;
+    for(SyntaxNode bodyStatement : body) count += lineCount(bodyStatement);
+    return count;
+}
+
+// every statement is generated on its own with states numbered from 0, as if it was the first one,
+// after which the fragments are renumbered and merged in source order so the result is exactly what explorer() makes.
+// With variable slots a statement also depends on where the previous one left the variable tape head. The statements are
+// generated in runs, every run guessing where the head is at its start, then the statements after a wrong guess are generated
+// again from what the statements before them did, and any guess that is still wrong is fixed when the fragments are checked in order
+bool TMGenerator::parallelExplorer(SyntaxNode root) {
+    struct Fragment {
+        set<StatePointer> states;
+        map<TransitionDomain, TransitionImage> transitions;
+        // stands in for the start state of the statement, which the previous statement makes
+        StatePointer incoming = make_shared<const State>("incoming");
+        std::unique_ptr<TMGenerator> generator;
+        // where the variable tape head was assumed to be when the statement starts
+        std::optional<int> headPosition;
+        std::exception_ptr exception;
+    };
+    vector<SyntaxNode> statements;
+    collectStatements(root, statements);
+    vector<Fragment> fragments(statements.size());
+    const StatePointer automatonStart = make_shared<const State>("CAstart");
+    const StatePointer automatonEnd = make_shared<const State>("CAend");
+    vector<int> firstLines;
+    vector<bool> automatonDeclared;
+    int lineNumber = currentLineNumber;
+    for(unsigned int i = 0; i < statements.size(); i++){
+        automatonDeclared.push_back(CAstart != nullptr || (i > 0 && (automatonDeclared[i - 1]
+                                                                     || statementLabel(statements[i - 1]) == "<CellularAutomatonDeclaration>")));
+        firstLines.push_back(lineNumber);
+        lineNumber += lineCount(statements[i]);
+    }
+    firstLines.push_back(lineNumber);
+
+    const auto generate = [&](size_t statement, const std::optional<int> &headPosition){
+        Fragment &fragment = fragments[statement];
+        fragment.states.clear();
+        fragment.transitions.clear();
+        fragment.exception = nullptr;
+        fragment.headPosition = headPosition;
+        fragment.generator = std::make_unique<TMGenerator>(tapeAlphabet, fragment.transitions, fragment.states, readableStateNames,
+                                                           optimizeFiniteControl, allocateVariableSlots, nativeArithmetic);
+        TMGenerator &child = *fragment.generator;
+        child.currentLineNumber = firstLines[statement];
+        child.currentLineBeginState = fragment.incoming;
+        child.storedNeighbours = storedNeighbours;
+        child.variableSlots = variableSlots;
+        child.jumpTargetLines = jumpTargetLines;
+        child.variableHeadHome = variableHeadHome;
+        child.variableHeadPosition = headPosition;
+        if(automatonDeclared[statement]){
+            child.CAstart = automatonStart;
+            child.CAend = automatonEnd;
+        }
+        try{
+            child.explorer(statements[statement]);
+        }catch(...){
+            fragment.exception = std::current_exception();
+        }
+    };
+    // a job is a run of statements, each one starts where the one before it left the head
+    const auto generateInParallel = [&](const vector<std::pair<size_t, size_t>> &runs, const vector<std::optional<int>> &headPositions){
+        std::atomic<size_t> next = 0;
+        vector<std::thread> workers;
+        for(unsigned int i = 0; i < std::min<size_t>(threadCount, runs.size()); i++){
+            workers.emplace_back([&](){
+                for(size_t job = next++; job < runs.size(); job = next++){
+                    std::optional<int> headPosition = headPositions[job];
+                    for(size_t statement = runs[job].first; statement < runs[job].second; statement++){
+                        generate(statement, headPosition);
+                        if(fragments[statement].exception) headPosition.reset();
+                        else headPosition = fragments[statement].generator->variableHeadPosition;
+                    }
+                }
+            });
+        }
+        for(std::thread &worker : workers) worker.join();
+    };
+
+    // a few runs per thread so they can even out
+    const size_t runLength = allocateVariableSlots ? std::max<size_t>(statements.size() / (4 * threadCount), 1) : 1;
+    vector<std::pair<size_t, size_t>> runs;
+    for(size_t first = 0; first < statements.size(); first += runLength) runs.emplace_back(first, std::min(first + runLength, statements.size()));
+    generateInParallel(runs, vector<std::optional<int>>(runs.size(), variableHeadPosition));
+    if(allocateVariableSlots){
+        // a statement that left the head where it found it is expected to do so from anywhere, any other one to leave it at the same place
+        vector<std::pair<size_t, size_t>> guessedWrong;
+        vector<std::optional<int>> betterGuesses;
+        std::optional<int> headPosition = variableHeadPosition;
+        for(size_t i = 0; i < statements.size(); i++){
+            const Fragment &fragment = fragments[i];
+            if(fragment.headPosition != headPosition){
+                guessedWrong.emplace_back(i, i + 1);
+                betterGuesses.push_back(headPosition);
+            }
+            if(fragment.exception) headPosition.reset();
+            else if(fragment.generator->variableHeadPosition != fragment.headPosition) headPosition = fragment.generator->variableHeadPosition;
+        }
+        generateInParallel(guessedWrong, betterGuesses);
+    }
+    std::optional<int> headPosition = variableHeadPosition;
+    for(unsigned int i = 0; i < fragments.size(); i++){
+        if(allocateVariableSlots && fragments[i].headPosition != headPosition) generate(i, headPosition);
+        if(fragments[i].exception) std::rethrow_exception(fragments[i].exception);
+        // a statement that does not take up the lines it was expected to is left to explorer()
+        if(fragments[i].generator->currentLineNumber != firstLines[i + 1]) return false;
+        headPosition = fragments[i].generator->variableHeadPosition;
+    }
+
+    for(Fragment &fragment : fragments){
+        TMGenerator &child = *fragment.generator;
+        std::unordered_map<StatePointer, StatePointer> renamed{{fragment.incoming, currentLineBeginState},
+                                                          {automatonStart, CAstart}, {automatonEnd, CAend}};
+        for(const StatePointer &state : fragment.states){
+            const bool numbered = std::all_of(state->name.begin(), state->name.end(), [](unsigned char c){return std::isdigit(c);});
+            const StatePointer merged = numbered ? make_shared<const State>(to_string(std::stoi(state->name) + currentStateNumber),
+                                                                            state->isInitial, state->type) : state;
+            renamed.emplace(state, merged);
+            states.insert(merged);
+        }
+        const auto rename = [&renamed](const StatePointer &state) {
+            const auto found = renamed.find(state);
+            return found == renamed.end() ? state : found->second;
+        };
+        for(const auto &[domain, image] : fragment.transitions){
+            transitions.insert({TransitionDomain(rename(domain.state), domain.replacedSymbols),
+                                TransitionImage(rename(image.state), image.replacementSymbols, image.directions, image.macro)});
+        }
+        for(PostponedTransition &transition : child.postponedTransitionBuffer){
+            transition.startState = rename(transition.startState);
+            transition.endState = rename(transition.endState);
+        }
+        postponedTransitionBuffer.append(child.postponedTransitionBuffer);
+        for(const auto &[line, state] : child.lineStartStates) lineStartStates[line] = rename(state);
+        lineHeadPositions.insert(child.lineHeadPositions.begin(), child.lineHeadPositions.end());
+        for(const auto &[jump, position, jumpLine] : child.pendingJumps) pendingJumps.emplace_back(rename(jump), position, jumpLine);
+        if(!CAstart && child.CAstart){
+            CAstart = rename(child.CAstart);
+            CAend = rename(child.CAend);
+        }
+        currentStateNumber += child.currentStateNumber;
+        currentLineNumber = child.currentLineNumber;
+        currentLineBeginState = rename(child.currentLineBeginState);
+        variableHeadPosition = child.variableHeadPosition;
+    }
+    return true;
+}
+
 void TMGenerator::updateHistoryTape(int x, int y, int z, StatePointer &beginState, StatePointer &endState) {
+    if(nativeArithmetic){
+        runNatively(beginState, endState, make_shared<BoxOperation>(Box_Copy, x, y, z, "", 0, 3));
+        return;
+    }
     StatePointer start = makeState();
     StatePointer end = makeState();
-    for(const auto& writtenSymbol: tapeAlphabet){
-        transitions.insert({
-                   TransitionDomain(start, {writtenSymbol, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
-                   TransitionImage(end, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, writtenSymbol}, {Stationary, Stationary, Stationary, Stationary})
-           });
-    }
+    transitions.insert({
+               TransitionDomain(start, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+               TransitionImage(end, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, TapeReference::symbolOn(0)}, {Stationary, Stationary, Stationary, Stationary})
+       });
     doThingForEveryVoxelInCube(x, y, z, beginState, endState, start, end, {0,3});
 }
 
@@ -941,9 +1259,26 @@ void TMGenerator::doThingForEveryVoxelInCube(int x, int y, int z, StatePointer &
     integerAssignment("Zcounter", zero, initY, thingStart);
 
     // from thingStart to thingEnd, the actual thing gets executed
+    // the sweep box is a macro like the native arithmetic, so it is only used when macros are allowed. Without them the
+    // finite control has to stay a plain Turing machine, which steps the counters below itself. Both keep the counters
+    // on the variable tape, so the tapes end up the same either way
+    if(nativeArithmetic){
+        // the sweep box steps to the next voxel in one transition and leaves whether there was one on the third tape
+        variableHeadPosition.reset();
+        StatePointer swept = makeState();
+        runNatively(thingEnd, swept, make_shared<SweepBox>(x, y, z, vector<unsigned int>(tapesToMove.begin(), tapesToMove.end())));
+        postponedTransitionBuffer.emplace_back(swept, thingStart, std::set<string>{"1"}, true);
+        postponedTransitionBuffer.back().tape = 2;
+        postponedTransitionBuffer.back().toWrite = "B";
+        postponedTransitionBuffer.emplace_back(swept, destination, std::set<string>{"0"}, true);
+        postponedTransitionBuffer.back().tape = 2;
+        postponedTransitionBuffer.back().toWrite = "B";
+        return;
+    }
 
 
     // move forward
+    variableHeadPosition.reset();
     StatePointer moveForward = makeState();
     moveMultipleTapes(Front, thingEnd, moveForward, tapesToMove);
     // increment X var
@@ -992,6 +1327,7 @@ void TMGenerator::doThingForEveryVoxelInCube(int x, int y, int z, StatePointer &
     StatePointer backDown = makeState();
     IntegerCompare("Zcounter", zString, thingStart, 0, zCheck, backDown);
     //  if so, move down while decrementing Z until Z is zero AND THEN EXIT
+    variableHeadPosition.reset();
     StatePointer startZReset = makeState();
     StatePointer zDecrement = makeState();
     moveMultipleTapes(Down, backDown, startZReset, tapesToMove);
@@ -1043,6 +1379,7 @@ TMGenerator::integerAssignment(const string &variableName, string &binaryAssigne
     postponedTransitionBuffer.back().toWrite = VariableTapeEnd;
     postponedTransitionBuffer.emplace_back(writeTapeEnd, destination, std::set<string>{VariableTapeEnd}, true);
     postponedTransitionBuffer.back().tape = 1;
+    placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
 }
 
 void
@@ -1050,6 +1387,31 @@ TMGenerator::IntegerCompare(const string &variableName, string &binaryComparedVa
                             int conditionalDestinationLineNumber, StatePointer beginState,
                             StatePointer conditionalEndState, const string &indexContainingVariable) {
     StatePointer reader1 = MoveToVariableValue(beginState, variableName, indexContainingVariable);
+    if(nativeArithmetic){
+        // branch on the outcome the comparison leaves on the third tape and erase it again
+        StatePointer compared = makeState();
+        runNatively(reader1, compared, make_shared<NativeArithmetic>(variableHeadPosition ? Native_CompareReturning : Native_Compare,
+                                                                     binaryComparedValue));
+        postponedTransitionBuffer.emplace_back(compared, standardDestination, std::set<string>{"0"}, true);
+        postponedTransitionBuffer.back().tape = 2;
+        postponedTransitionBuffer.back().toWrite = "B";
+        placeVariableHead(variableName, indexContainingVariable, BINARY_VALUE_WIDTH);
+        PostponedTransition &equal = conditionalEndState == nullptr
+                ? jumpToLine(compared, conditionalDestinationLineNumber, std::set<string>{"1"}, true)
+                : postponedTransitionBuffer.emplace_back(compared, conditionalEndState, std::set<string>{"1"}, true);
+        equal.tape = 2;
+        equal.toWrite = "B";
+        placeVariableHead(variableName, indexContainingVariable, 0);
+        return;
+    }
+    // with a known slot, a mismatch returns to the start of the value so the head position stays known
+    std::vector<StatePointer> returnStates = {standardDestination};
+    if(variableHeadPosition){
+        for (int i = 0; i < BINARY_VALUE_WIDTH - 1; ++i) {
+            returnStates.push_back(makeState());
+            moveMultipleTapes(Left, returnStates.back(), returnStates[i], {1});
+        }
+    }
 
     //bitwise comparison
     std::vector<StatePointer> readerStates = {reader1};
@@ -1060,22 +1422,30 @@ TMGenerator::IntegerCompare(const string &variableName, string &binaryComparedVa
         postponedTransitionBuffer.emplace_back(*penultimate, *last, std::set<string>{string(1, c)}, true);
         postponedTransitionBuffer.back().tape = 1;
         postponedTransitionBuffer.back().directions[1] = Right;
-        postponedTransitionBuffer.emplace_back(*penultimate, standardDestination, std::set<string>{string(1, c)});
+        const StatePointer &mismatch = returnStates.size() == 1 ? standardDestination : returnStates[readerStates.size() - 2];
+        postponedTransitionBuffer.emplace_back(*penultimate, mismatch, std::set<string>{string(1, c)});
         postponedTransitionBuffer.back().tape = 1;
         postponedTransitionBuffer.back().directions[1] = Stationary;
     }
+    placeVariableHead(variableName, indexContainingVariable, BINARY_VALUE_WIDTH);
     if(conditionalEndState == nullptr){
-        postponedTransitionBuffer.emplace_back(*std::next(readerStates.end(), -1), conditionalDestinationLineNumber);
+        jumpToLine(*std::next(readerStates.end(), -1), conditionalDestinationLineNumber).tape = 1;
+        placeVariableHead(variableName, indexContainingVariable, 0);
     }else{
         postponedTransitionBuffer.emplace_back(*std::next(readerStates.end(), -1), conditionalEndState);
+        postponedTransitionBuffer.back().tape = 1;
     }
-    postponedTransitionBuffer.back().tape = 1;
 }
 
 void
 TMGenerator::immediateAddition(const string &variableName, string &binaryAddedValue, StatePointer &startingState,
                                StatePointer &destination, const string &variableContainingIndex) {
     StatePointer writer1 = MoveToVariableValue(startingState, variableName, variableContainingIndex);
+    if(nativeArithmetic){
+        runNatively(writer1, destination, make_shared<NativeArithmetic>(Native_Addition, binaryAddedValue));
+        placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
+        return;
+    }
 
     //start adding
     std::vector<StatePointer> writeValueStates = {writer1, makeState()}; // first carry state cannot be reached here but makes the loop below easier
@@ -1128,6 +1498,7 @@ TMGenerator::immediateAddition(const string &variableName, string &binaryAddedVa
     postponedTransitionBuffer.emplace_back(oldCarryState, destination);
     postponedTransitionBuffer.back().tape = 1;
     postponedTransitionBuffer.back().directions[1] = Stationary;
+    placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
 }
 // only works for single variables that definitely exist, not arrays
 //also, overflows are not handled so will break everything
@@ -1172,10 +1543,17 @@ void TMGenerator::optimizedIncrement(const string &variableName, StatePointer &s
         postponedTransitionBuffer.back().directions[1] = Right;
         postponedTransitionBuffer.back().toWrite = "1";
     }
+    // the carry stops anywhere in the value
+    variableHeadPosition.reset();
 }
 void TMGenerator::bitwiseAnd(const string &variableName, string &binaryAddedValue, StatePointer &startingState,
            StatePointer &destination, const string &variableContainingIndex){
     StatePointer writer1 = MoveToVariableValue(startingState, variableName, variableContainingIndex);
+    if(nativeArithmetic){
+        runNatively(writer1, destination, make_shared<NativeArithmetic>(Native_And, binaryAddedValue));
+        placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
+        return;
+    }
 
     //start comparison
     std::vector<StatePointer> writeValueStates = {writer1};
@@ -1205,6 +1583,209 @@ void TMGenerator::bitwiseAnd(const string &variableName, string &binaryAddedValu
     postponedTransitionBuffer.emplace_back(oldNormalState, destination);
     postponedTransitionBuffer.back().tape = 1;
     postponedTransitionBuffer.back().directions[1] = Stationary;
+    placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
+}
+void TMGenerator::integerDivision(const string &variableName, StatePointer &startingState, StatePointer &destination,
+                                  const string &variableContainingIndex) {
+    StatePointer dividend = MoveToVariableValue(startingState, variableName, variableContainingIndex);
+    if(nativeArithmetic){
+        runNatively(dividend, destination, make_shared<NativeArithmetic>(Native_Division));
+        placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
+        return;
+    }
+    const string A = SYMBOL_ANY;
+    const auto step = [this](const StatePointer &from, const StatePointer &to, const vector<string> &read,
+                             const vector<string> &write, const vector<TMTapeDirection> &directions){
+        transitions.insert({TransitionDomain(from, read), TransitionImage(to, write, directions)});
+    };
+    // moves one tape while it reads (or does not read) the given symbols
+    const auto moveWhile = [this](const StatePointer &from, const StatePointer &to, int tape, const set<string> &symbols,
+                                  bool reading, TMTapeDirection direction){
+        postponedTransitionBuffer.emplace_back(from, from, symbols, reading);
+        postponedTransitionBuffer.back().tape = tape;
+        postponedTransitionBuffer.back().directions[tape] = direction;
+        postponedTransitionBuffer.emplace_back(from, to, symbols, !reading);
+        postponedTransitionBuffer.back().tape = tape;
+    };
+    const auto moveOnce = [this](const StatePointer &from, const StatePointer &to, int tape, TMTapeDirection direction){
+        postponedTransitionBuffer.emplace_back(from, to);
+        postponedTransitionBuffer.back().tape = tape;
+        postponedTransitionBuffer.back().directions[tape] = direction;
+    };
+    const set<string> bits = {"0", "1"};
+    const set<string> tapeStart = {VariableTapeStart};
+    // rewrites the bits under the head of a tape as their two's complement negation, stopping on the first other symbol
+    const auto negate = [&](const StatePointer &from, const StatePointer &to, int tape){
+        StatePointer invert = makeState();
+        vector<string> read(4, A);
+        vector<TMTapeDirection> directions(4, Stationary);
+        directions[tape] = Right;
+        for(const StatePointer &state : {from, invert}){
+            for(const string bit : {"0", "1"}){
+                read[tape] = bit;
+                vector<string> write = read;
+                if(state == invert) write[tape] = bit == "0" ? "1" : "0";
+                step(state, bit == "1" ? invert : state, read, write, directions);
+            }
+            postponedTransitionBuffer.emplace_back(state, to, bits);
+            postponedTransitionBuffer.back().tape = tape;
+        }
+    };
+    // the sign of the result is kept two cells left of the third tape head
+    const auto toggleSign = [&](const StatePointer &from, const StatePointer &to){
+        for(const string bit : {"0", "1"}){
+            step(from, to, {A, A, bit, A}, {A, A, bit == "0" ? "1" : "0", A}, {Stationary, Stationary, Right, Stationary});
+        }
+    };
+
+    // the dividend goes to the third tape, as its magnitude
+    StatePointer copied = copyIntegerToThirdTape(dividend, true);
+    StatePointer signLeft = makeState(), writeSign = makeState(), signRight = makeState(), signWritten = makeState();
+    moveOnce(copied, signLeft, 2, Left);
+    moveOnce(signLeft, writeSign, 2, Left);
+    step(writeSign, signRight, {A, A, A, A}, {A, A, "0", A}, {Stationary, Stationary, Right, Stationary});
+    moveOnce(signRight, signWritten, 2, Right);
+    StatePointer dividendEnd = makeState(), dividendSign = makeState(), dividendPositive = makeState(), dividendNegative = makeState();
+    moveWhile(signWritten, dividendEnd, 2, bits, true, Right);
+    moveOnce(dividendEnd, dividendSign, 2, Left);
+    StatePointer dividendMagnitude = makeState();
+    step(dividendSign, dividendPositive, {A, A, "0", A}, {A, A, "0", A}, {Stationary, Stationary, Stationary, Stationary});
+    step(dividendSign, dividendNegative, {A, A, "1", A}, {A, A, "1", A}, {Stationary, Stationary, Stationary, Stationary});
+    moveWhile(dividendPositive, dividendMagnitude, 2, bits, true, Left);
+    StatePointer negateDividend = makeState(), negatedDividend = makeState(), dividendBack = makeState(), dividendSignCell = makeState();
+    moveWhile(dividendNegative, negateDividend, 2, bits, true, Left);
+    StatePointer dividendStart = makeState();
+    moveOnce(negateDividend, dividendStart, 2, Right);
+    negate(dividendStart, negatedDividend, 2);
+    moveWhile(negatedDividend, dividendBack, 2, bits, false, Left);
+    moveWhile(dividendBack, dividendSignCell, 2, bits, true, Left);
+    StatePointer toggleDividendSign = makeState();
+    moveOnce(dividendSignCell, toggleDividendSign, 2, Left);
+    toggleSign(toggleDividendSign, dividendMagnitude);
+
+    // the divisor in sysvar becomes its magnitude, a divisor of 0 always gives a non-negative result
+    StatePointer seekSysvar = makeState(), sysvarStart = makeState(), sysvarEnd = makeState(), divisorSign = makeState();
+    moveWhile(dividendMagnitude, seekSysvar, 1, tapeStart, false, Left);
+    moveOnce(seekSysvar, sysvarStart, 1, Right);
+    moveWhile(sysvarStart, sysvarEnd, 1, bits, true, Right);
+    moveOnce(sysvarEnd, divisorSign, 1, Left);
+    StatePointer divisorReady = makeState();
+    StatePointer negateDivisor = makeState(), divisorValue = makeState(), negatedDivisor = makeState(), toggleDivisorSign = makeState();
+    step(divisorSign, negateDivisor, {A, "1", A, A}, {A, "1", A, A}, {Stationary, Stationary, Stationary, Stationary});
+    moveWhile(negateDivisor, divisorValue, 1, tapeStart, false, Left);
+    StatePointer divisorStart = makeState();
+    moveOnce(divisorValue, divisorStart, 1, Right);
+    negate(divisorStart, negatedDivisor, 1);
+    moveOnce(negatedDivisor, toggleDivisorSign, 2, Left);
+    toggleSign(toggleDivisorSign, divisorReady);
+    StatePointer divisorZero = makeState(), zeroSign = makeState();
+    step(divisorSign, divisorZero, {A, "0", A, A}, {A, "0", A, A}, {Stationary, Stationary, Stationary, Stationary});
+    postponedTransitionBuffer.emplace_back(divisorZero, divisorZero, set<string>{"0"}, true);
+    postponedTransitionBuffer.back().tape = 1;
+    postponedTransitionBuffer.back().directions[1] = Left;
+    postponedTransitionBuffer.emplace_back(divisorZero, divisorReady, set<string>{"1"}, true);
+    postponedTransitionBuffer.back().tape = 1;
+    postponedTransitionBuffer.emplace_back(divisorZero, zeroSign, tapeStart, true);
+    postponedTransitionBuffer.back().tape = 1;
+    postponedTransitionBuffer.back().directions[2] = Left;
+    step(zeroSign, divisorReady, {A, A, A, A}, {A, A, "0", A}, {Stationary, Stationary, Right, Stationary});
+
+    // the long division starts with the window on the most significant bit of the dividend
+    StatePointer seekTop = makeState(), topFound = makeState(), rewindDivisor = makeState();
+    moveOnce(divisorReady, seekTop, 2, Right);
+    moveWhile(seekTop, topFound, 2, bits, true, Right);
+    moveOnce(topFound, rewindDivisor, 2, Left);
+    StatePointer onTapeStart = makeState();
+    moveWhile(rewindDivisor, onTapeStart, 1, tapeStart, false, Left);
+    StatePointer trial[2] = {makeState(), makeState()};
+    moveOnce(onTapeStart, trial[0], 1, Right);
+
+    // every iteration subtracts the divisor from the window of W + 1 cells, if that does not borrow the difference is written
+    // the quotient bit goes right after the window, the window then moves one cell left to take in the next bit of the dividend
+    StatePointer returnToCommit = makeState(), quotientBit[2] = {makeState(), makeState()}, returnToNext = makeState();
+    StatePointer commit[2] = {makeState(), makeState()};
+    const vector<TMTapeDirection> bothRight = {Stationary, Right, Right, Stationary};
+    const vector<TMTapeDirection> bothLeft = {Stationary, Left, Left, Stationary};
+    for(int borrow = 0; borrow < 2; borrow++){
+        for(const string divisorBit : {"0", "1"}){
+            for(const string remainderBit : {"0", "1", "B"}){
+                const int difference = (remainderBit == "1") - (divisorBit == "1") - borrow;
+                step(trial[borrow], trial[difference < 0], {A, divisorBit, remainderBit, A}, {A, divisorBit, remainderBit, A}, bothRight);
+                step(commit[borrow], commit[difference < 0], {A, divisorBit, remainderBit, A},
+                     {A, divisorBit, std::to_string(difference & 1), A}, bothRight);
+            }
+        }
+        for(const string remainderBit : {"0", "1", "B"}){
+            if(borrow && remainderBit != "1"){
+                step(trial[borrow], quotientBit[0], {A, A, remainderBit, A}, {A, A, "0", A}, {Stationary, Stationary, Right, Stationary});
+            }else{
+                step(trial[borrow], returnToCommit, {A, A, remainderBit, A}, {A, A, remainderBit, A}, bothLeft);
+            }
+        }
+        step(commit[borrow], quotientBit[1], {A, A, A, A}, {A, A, "0", A}, {Stationary, Stationary, Right, Stationary});
+    }
+    postponedTransitionBuffer.emplace_back(returnToCommit, returnToCommit, tapeStart);
+    postponedTransitionBuffer.back().tape = 1;
+    postponedTransitionBuffer.back().directions = {Stationary, Left, Left, Stationary};
+    postponedTransitionBuffer.emplace_back(returnToCommit, commit[0], tapeStart, true);
+    postponedTransitionBuffer.back().tape = 1;
+    postponedTransitionBuffer.back().directions = {Stationary, Right, Right, Stationary};
+    for(int bit = 0; bit < 2; bit++){
+        step(quotientBit[bit], returnToNext, {A, A, A, A}, {A, A, std::to_string(bit), A}, {Stationary, Stationary, Left, Stationary});
+    }
+    postponedTransitionBuffer.emplace_back(returnToNext, returnToNext, tapeStart);
+    postponedTransitionBuffer.back().tape = 1;
+    postponedTransitionBuffer.back().directions = {Stationary, Left, Left, Stationary};
+    StatePointer divided = makeState();
+    for(const string bit : {"0", "1"}){
+        step(returnToNext, trial[0], {A, VariableTapeStart, bit, A}, {A, VariableTapeStart, bit, A}, {Stationary, Right, Stationary, Stationary});
+    }
+    step(returnToNext, divided, {A, VariableTapeStart, "B", A}, {A, VariableTapeStart, "B", A}, {Stationary, Stationary, Right, Stationary});
+
+    // erase the remainder and give the quotient its sign
+    vector<StatePointer> eraseStates = {divided};
+    for(int i = 0; i <= BINARY_VALUE_WIDTH; i++){
+        eraseStates.push_back(makeState());
+        step(eraseStates[i], eraseStates[i + 1], {A, A, A, A}, {A, A, "B", A},
+             {Stationary, Stationary, i == BINARY_VALUE_WIDTH ? Left : Right, Stationary});
+    }
+    StatePointer seekSign = eraseStates.back(), quotientStart = makeState(), skipBlanks[2] = {makeState(), makeState()};
+    postponedTransitionBuffer.emplace_back(seekSign, seekSign, set<string>{"B"}, true);
+    postponedTransitionBuffer.back().tape = 2;
+    postponedTransitionBuffer.back().directions[2] = Left;
+    for(int sign = 0; sign < 2; sign++){
+        step(seekSign, skipBlanks[sign], {A, A, std::to_string(sign), A}, {A, A, "B", A}, {Stationary, Stationary, Right, Stationary});
+    }
+    StatePointer negateQuotient = makeState(), negatedQuotient = makeState(), rewindQuotient = makeState();
+    moveWhile(skipBlanks[0], quotientStart, 2, {"B"}, true, Right);
+    moveWhile(skipBlanks[1], negateQuotient, 2, {"B"}, true, Right);
+    negate(negateQuotient, negatedQuotient, 2);
+    moveOnce(negatedQuotient, rewindQuotient, 2, Left);
+    StatePointer quotientRewound = makeState();
+    moveWhile(rewindQuotient, quotientRewound, 2, bits, true, Left);
+    moveOnce(quotientRewound, quotientStart, 2, Right);
+    // leave a blank left of the third tape head for array lookups
+    StatePointer quotientEnd = makeState(), quotientParked = makeState();
+    moveWhile(quotientStart, quotientEnd, 2, bits, true, Right);
+    moveOnce(quotientEnd, quotientParked, 2, Right);
+
+    // write the quotient over the dividend, erasing it from the third tape
+    variableHeadPosition = 0;
+    StatePointer backToDividend = MoveToVariableValue(quotientParked, variableName, variableContainingIndex);
+    StatePointer skipParking = makeState(), quotientFound = makeState(), writeQuotient = makeState();
+    moveOnce(backToDividend, skipParking, 2, Stationary);
+    moveWhile(skipParking, quotientFound, 2, {"B"}, true, Left);
+    postponedTransitionBuffer.emplace_back(quotientFound, quotientFound, bits, true);
+    postponedTransitionBuffer.back().tape = 2;
+    postponedTransitionBuffer.back().directions[2] = Left;
+    postponedTransitionBuffer.emplace_back(quotientFound, writeQuotient, set<string>{"B"}, true);
+    postponedTransitionBuffer.back().tape = 2;
+    postponedTransitionBuffer.back().directions[2] = Right;
+    for(const string bit : {"0", "1"}){
+        step(writeQuotient, writeQuotient, {A, A, bit, A}, {A, bit, "B", A}, bothRight);
+    }
+    step(writeQuotient, destination, {A, A, "B", A}, {A, A, "B", A}, {Stationary, Stationary, Stationary, Stationary});
+    placeVariableHead(variableName, variableContainingIndex, BINARY_VALUE_WIDTH);
 }
 void
 TMGenerator::tapeMove(TMTapeDirection direction, StatePointer &beginState, StatePointer &destination, int tapeIndex) {
@@ -1217,49 +1798,42 @@ void TMGenerator::currentIntoVariable(const string &variableName, const StatePoi
                                       const string &variableContainingIndex) {
     assert(tapeIndex >= 0 && tapeIndex != 1);
     StatePointer goRight = MoveToVariableValue(beginState, variableName, variableContainingIndex);
-    for (const string& symbolToWrite: tapeAlphabet) {
-        if(symbolToWrite == VariableTapeEnd) continue;
-        // option 1: variable name found: overwrite current value, whatever it is
-        for(const string& ignoredSymbol: tapeAlphabet){
-            if(ignoredSymbol == VariableTapeEnd) continue;
-            vector<string> replaced = {SYMBOL_ANY, ignoredSymbol, SYMBOL_ANY, SYMBOL_ANY};
-            vector<string> replacement = {SYMBOL_ANY, symbolToWrite, SYMBOL_ANY, SYMBOL_ANY};
-            *std::next(replaced.begin(), tapeIndex) = symbolToWrite;
-            *std::next(replacement.begin(), tapeIndex) = symbolToWrite;
-            transitions.insert({
-                                       TransitionDomain(goRight, replaced),
-                                       TransitionImage(destination, replacement, {Stationary, Right, Stationary, Stationary}) // move right for a chance that the next variable sought is there
-                               });
-        }
-        // option 2: tape end found: overwrite it and put a new tape end to the right
-        StatePointer writeName = makeState();
-        //write the name
-        vector<string> replaced4 = {SYMBOL_ANY, VariableTapeEnd, SYMBOL_ANY, SYMBOL_ANY};
-        vector<string> replaced5 = {SYMBOL_ANY, variableName, SYMBOL_ANY, SYMBOL_ANY};
-        *std::next(replaced4.begin(), tapeIndex) = symbolToWrite;
-        *std::next(replaced5.begin(), tapeIndex) = symbolToWrite;
-        transitions.insert({
-                                   TransitionDomain(goRight, replaced4),
-                                   TransitionImage(writeName, replaced5, {Stationary, Right, Stationary, Stationary})
-                           });
-        StatePointer writeValue = makeState();
-        //write the value
-        vector<string> replaced6 = {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY};
-        vector<string> replaced7 = {SYMBOL_ANY, symbolToWrite, SYMBOL_ANY, SYMBOL_ANY};
-        *std::next(replaced6.begin(), tapeIndex) = symbolToWrite;
-        *std::next(replaced7.begin(), tapeIndex) = symbolToWrite;
-        transitions.insert({
-                                   TransitionDomain(writeName, replaced6),
-                                   TransitionImage(writeValue, replaced7, {Stationary, Right, Stationary, Stationary})
-                           });
-        postponedTransitionBuffer.emplace_back(writeValue, destination);
-        postponedTransitionBuffer.back().tape = 1;
-        postponedTransitionBuffer.back().toWrite = VariableTapeEnd;
-        postponedTransitionBuffer.back().directions[1] = Left; // the variable tape end is never going to be sought after directly
-    }
+    vector<string> copied = {SYMBOL_ANY, TapeReference::symbolOn(tapeIndex), SYMBOL_ANY, SYMBOL_ANY};
+    // option 1: variable name found: overwrite current value, whatever it is
+    transitions.insert({
+                               TransitionDomain(goRight, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                               TransitionImage(destination, copied, {Stationary, Right, Stationary, Stationary}) // move right for a chance that the next variable sought is there
+                       });
+    // option 2: tape end found: overwrite it and put a new tape end to the right
+    StatePointer writeName = makeState();
+    //write the name
+    transitions.insert({
+                               TransitionDomain(goRight, {SYMBOL_ANY, VariableTapeEnd, SYMBOL_ANY, SYMBOL_ANY}),
+                               TransitionImage(writeName, {SYMBOL_ANY, variableName, SYMBOL_ANY, SYMBOL_ANY}, {Stationary, Right, Stationary, Stationary})
+                       });
+    StatePointer writeValue = makeState();
+    //write the value
+    transitions.insert({
+                               TransitionDomain(writeName, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                               TransitionImage(writeValue, copied, {Stationary, Right, Stationary, Stationary})
+                       });
+    transitions.insert({
+                               TransitionDomain(writeValue, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                               TransitionImage(destination, {SYMBOL_ANY, VariableTapeEnd, SYMBOL_ANY, SYMBOL_ANY}, {Stationary, Left, Stationary, Stationary}) // the variable tape end is never going to be sought after directly
+                       });
+    placeVariableHead(variableName, variableContainingIndex, 1);
 }
 
 void TMGenerator::addThirdToSecond(vector<StatePointer> &writeValueStates, bool subtract) {
+    if(nativeArithmetic){
+        StatePointer added = makeState();
+        runNatively(*std::next(writeValueStates.end(), -2), added,
+                    make_shared<NativeArithmetic>(subtract ? Native_TapeSubtraction : Native_TapeAddition));
+        // there is no carry left over, so the last normal and carry states are the same
+        writeValueStates.push_back(added);
+        writeValueStates.push_back(added);
+        return;
+    }
     for (int i = 0; i < BINARY_VALUE_WIDTH; ++i) {
         StatePointer oldNormalState = *std::next(writeValueStates.end(), -2);
         StatePointer oldCarryState = *std::next(writeValueStates.end(), -1);
@@ -1393,6 +1967,7 @@ StatePointer TMGenerator::copyIntegerToThirdTape(StatePointer startState, bool b
                                TransitionImage(lastState, {SYMBOL_ANY, "1", "1", SYMBOL_ANY}, {Stationary, Stationary, lastDirection, Stationary})
                        });
     if(!backToStart){
+        if(variableHeadPosition) *variableHeadPosition += BINARY_VALUE_WIDTH - 1;
         return lastState;
     }
     return doneCopying;
@@ -1400,6 +1975,13 @@ StatePointer TMGenerator::copyIntegerToThirdTape(StatePointer startState, bool b
 
 StatePointer TMGenerator::MoveToVariableValue(StatePointer startState, const string &variableName,
                                               const string &variableContainingIndex) {
+    const bool hasSlot = variableContainingIndex.empty() && variableSlots.count(variableName);
+    if(hasSlot && variableHeadPosition){
+        // the distance to the slot is known, so no searching is needed
+        StatePointer moved = moveVariableHead(startState, variableSlots.at(variableName) - *variableHeadPosition);
+        variableHeadPosition = variableSlots.at(variableName);
+        return moved;
+    }
     StatePointer seekMainVariable;
     if(variableContainingIndex.empty()){
         seekMainVariable = startState;
@@ -1408,22 +1990,31 @@ StatePointer TMGenerator::MoveToVariableValue(StatePointer startState, const str
         StatePointer copied = copyIntegerToThirdTape(moved, true);
         seekMainVariable = copied;
     }
-    //search for the tape begin marker
-    StatePointer goLeft = makeState();
-    postponedTransitionBuffer.emplace_back(seekMainVariable, goLeft);
-    postponedTransitionBuffer.emplace_back(goLeft, goLeft, std::set<string>{VariableTapeStart, variableName});
-    postponedTransitionBuffer.back().directions[1] = Left;
-    postponedTransitionBuffer.back().tape = 1;
-    // shortcut if the variable name is already found on the way
-    StatePointer moveToValue = makeState();
-    postponedTransitionBuffer.emplace_back(goLeft, moveToValue, std::set<string>{variableName}, true);
-    postponedTransitionBuffer.back().directions[1] = Right;
-    postponedTransitionBuffer.back().tape = 1;
-    //move right until variable name or tape end found (stopping at tape end will halt unexpectedly so is better than going past the end)
-    StatePointer goRight = makeState();
-    postponedTransitionBuffer.emplace_back(goLeft, goRight, std::set<string>{VariableTapeStart}, true);
-    postponedTransitionBuffer.back().tape = 1;
-    postponedTransitionBuffer.back().directions[1] = Right;
+    StatePointer moveToValue;
+    StatePointer goRight;
+    if(allocateVariableSlots && !variableContainingIndex.empty() && variableHeadPosition){
+        // arrays are declared after all slots, so the array lies to the right of the index that was just read
+        moveToValue = makeState();
+        goRight = makeState();
+        postponedTransitionBuffer.emplace_back(seekMainVariable, goRight);
+    }else{
+        //search for the tape begin marker
+        StatePointer goLeft = makeState();
+        postponedTransitionBuffer.emplace_back(seekMainVariable, goLeft);
+        postponedTransitionBuffer.emplace_back(goLeft, goLeft, std::set<string>{VariableTapeStart, variableName});
+        postponedTransitionBuffer.back().directions[1] = Left;
+        postponedTransitionBuffer.back().tape = 1;
+        // shortcut if the variable name is already found on the way
+        moveToValue = makeState();
+        postponedTransitionBuffer.emplace_back(goLeft, moveToValue, std::set<string>{variableName}, true);
+        postponedTransitionBuffer.back().directions[1] = Right;
+        postponedTransitionBuffer.back().tape = 1;
+        //move right until variable name or tape end found (stopping at tape end will halt unexpectedly so is better than going past the end)
+        goRight = makeState();
+        postponedTransitionBuffer.emplace_back(goLeft, goRight, std::set<string>{VariableTapeStart}, true);
+        postponedTransitionBuffer.back().tape = 1;
+        postponedTransitionBuffer.back().directions[1] = Right;
+    }
     postponedTransitionBuffer.emplace_back(goRight, goRight, std::set<string>{variableName, VariableTapeEnd});
     postponedTransitionBuffer.back().tape = 1;
     postponedTransitionBuffer.back().directions[1] = Right;
@@ -1432,6 +2023,7 @@ StatePointer TMGenerator::MoveToVariableValue(StatePointer startState, const str
     postponedTransitionBuffer.back().directions[1] = Right;
     postponedTransitionBuffer.emplace_back(goRight, moveToValue, set<string>{VariableTapeEnd}, true);
     postponedTransitionBuffer.back().tape = 1;
+    placeVariableHead(variableName, variableContainingIndex, 0);
     if(variableContainingIndex.empty()){
         return moveToValue;
     }
@@ -1522,31 +2114,167 @@ StatePointer TMGenerator::makeState(int beginStateOfThisLineNumber, bool accepti
     return newState;
 }
 
-void TMGenerator::identifierListPartRecursiveParser(const shared_ptr<STNode> &root, set<string> &output) {
-    if(root->children.size() > 1){
-        identifierListPartRecursiveParser(root->children.at(2), output);
+void TMGenerator::identifierListPartRecursiveParser(SyntaxNode root, set<string> &output) {
+    if(root.getChildCount() > 1){
+        identifierListPartRecursiveParser(root.getChild(2), output);
     }
-    output.insert(parseSymbolLiteral(root->children[0]));
+    output.insert(parseSymbolLiteral(root.getChild(0)));
 
 }
 
-set<string> TMGenerator::parseIdentifierList(const shared_ptr<STNode> &root) {
+set<string> TMGenerator::parseIdentifierList(SyntaxNode root) {
     set<string> output;
-    identifierListPartRecursiveParser(root->children.at(1), output);
+    identifierListPartRecursiveParser(root.getChild(1), output);
     return output;
 }
 
-void TMGenerator::alphabetExplorer(const shared_ptr<STNode> &root) {
-    if(root->token != nullptr && root->token->type == TokenType::Token_Identifier){
-        tapeAlphabet.insert(root->token->lexeme);
+void TMGenerator::alphabetExplorer(SyntaxNode root) {
+    if(root.getToken() != nullptr && root.getToken()->type == TokenType::Token_Identifier){
+        tapeAlphabet.insert(root.getToken()->lexeme);
     }
-    if(root->hasChildren()){
-        for (auto& child : root->children) {
+    if(root.hasChildren()){
+        for (SyntaxNode child : root.getChildren()) {
             alphabetExplorer(child);
         }
     }
 }
 
+void TMGenerator::slotExplorer(SyntaxNode root, set<string> &arrayNames) {
+    const string &l = root.getLabel();
+    vector<string> scalarNames;
+    if(l == "<GeneralVariableLocation>"){
+        auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root);
+        if(variableContainingIndex.empty()) scalarNames.push_back(variableName);
+        else{
+            arrayNames.insert(variableName);
+            scalarNames.push_back(variableContainingIndex);
+        }
+    }else if(l == "<ArrayDeclaration>"){
+        arrayNames.insert(root.getChild(8).getToken()->lexeme);
+    }else if(l == "<CellularAutomatonDeclaration>"){
+        scalarNames.assign(storedNeighbours.begin(), storedNeighbours.end());
+    }else if(l == "<CellularAutomatonRun>"){
+        scalarNames = {"Xcounter", "Ycounter", "Zcounter"};
+    }else if(l == "<Jump>" || l == "<ReadCondition>" || l == "<SymbolVariableCondition>"
+             || l == "<IntegerVariableCondition>" || l == "<BinaryVariableCondition>"){
+        jumpTargetLines.insert(parseInteger(root.getChild(1)));
+    }
+    for(const string &name : scalarNames){
+        if(std::find(slotNames.begin(), slotNames.end(), name) == slotNames.end()) slotNames.push_back(name);
+    }
+    // children are stored in reverse, visit them in source order so slots are laid out in order of first use
+    const SyntaxNode::Children children = root.getChildren();
+    for(auto child = children.rbegin(); child != children.rend(); child++){
+        slotExplorer(*child, arrayNames);
+    }
+}
+
+// a neighbour only has to be stored in a variable if it is used as more than the left hand side of a symbol comparison in the automaton
+void TMGenerator::neighbourExplorer(SyntaxNode root, bool inAutomaton) {
+    const string &l = root.getLabel();
+    if(l == "<GeneralVariableLocation>"){
+        auto [variableName, variableContainingIndex] = parseVariableLocationContainer(root);
+        for(const string &name : {variableName, variableContainingIndex}){
+            if(NeighbourOffsets.count(name)) storedNeighbours.insert(name);
+        }
+        return;
+    }
+    if(l == "<SymbolVariableCondition>" && readsNeighbourInPlace(root, inAutomaton)) return;
+    for(SyntaxNode child : root.getChildren()){
+        neighbourExplorer(child, inAutomaton || l == "<CellularAutomatonDeclaration>");
+    }
+}
+
+bool TMGenerator::readsNeighbourInPlace(SyntaxNode condition, bool inAutomaton) const {
+    if(!inAutomaton) return false;
+    auto [variableName, variableContainingIndex] = parseVariableLocationContainer(condition.getChild(5));
+    return variableContainingIndex.empty() && NeighbourOffsets.count(variableName) && !storedNeighbours.count(variableName);
+}
+
+// writes every slot behind the system variable as its name followed by a zeroed value
+StatePointer TMGenerator::writeVariableSlots(const StatePointer &startState) {
+    StatePointer previous = startState;
+    int position = BINARY_VALUE_WIDTH + 1;
+    for(unsigned int i = 0; i < slotNames.size(); i++){
+        variableSlots[slotNames[i]] = position + 1;
+        if(i == 0) variableHeadHome = position + 1;
+        for(int cell = 0; cell <= BINARY_VALUE_WIDTH; cell++){
+            StatePointer next = make_shared<const State>("slot" + to_string(i) + "_" + to_string(cell), false);
+            states.insert(next);
+            transitions.insert({
+                   TransitionDomain(previous, {SYMBOL_ANY, "B", "B", SYMBOL_ANY}),
+                   TransitionImage(next, {SYMBOL_ANY, cell == 0 ? slotNames[i] : "0", "B", SYMBOL_ANY}, {Stationary, Right, Stationary, Stationary})
+           });
+            previous = next;
+            position++;
+        }
+    }
+    return previous;
+}
+
+// children are stored in reverse, so the first location found is the right hand side, which binary operations read first
+std::optional<int> TMGenerator::firstSlotAccessed(SyntaxNode root) const {
+    for(SyntaxNode child : root.getChildren()){
+        if(child.getLabel() != "<GeneralVariableLocation>") continue;
+        auto [variableName, variableContainingIndex] = parseVariableLocationContainer(child);
+        const auto found = variableSlots.find(variableContainingIndex.empty() ? variableName : variableContainingIndex);
+        if(found != variableSlots.end()) return found->second;
+        return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+StatePointer TMGenerator::normalizeVariableHead(const StatePointer &startState, int position) {
+    StatePointer known = startState;
+    if(!variableHeadPosition){
+        StatePointer goLeft = makeState();
+        postponedTransitionBuffer.emplace_back(startState, goLeft);
+        postponedTransitionBuffer.emplace_back(goLeft, goLeft, std::set<string>{VariableTapeStart});
+        postponedTransitionBuffer.back().tape = 1;
+        postponedTransitionBuffer.back().directions[1] = Left;
+        known = makeState();
+        postponedTransitionBuffer.emplace_back(goLeft, known, std::set<string>{VariableTapeStart}, true);
+        postponedTransitionBuffer.back().tape = 1;
+        variableHeadPosition = 0;
+    }
+    StatePointer moved = moveVariableHead(known, position - *variableHeadPosition);
+    variableHeadPosition = position;
+    return moved;
+}
+
+PostponedTransition &TMGenerator::jumpToLine(const StatePointer &startState, int lineNumber, const set<string> &leftOutSymbols,
+                                             bool onlyTheseSymbols) {
+    if(!allocateVariableSlots) return postponedTransitionBuffer.emplace_back(startState, lineNumber, leftOutSymbols, onlyTheseSymbols);
+    // the head is moved into place once every line is generated, as forward jumps do not know where to put it yet
+    StatePointer jump = makeState();
+    pendingJumps.emplace_back(jump, variableHeadPosition, lineNumber);
+    return postponedTransitionBuffer.emplace_back(startState, jump, leftOutSymbols, onlyTheseSymbols);
+}
+
+void TMGenerator::runNatively(const StatePointer &startState, const StatePointer &destination, const MacroPointer &macro) {
+    transitions.insert({
+                               TransitionDomain(startState, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                               TransitionImage(destination, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY},
+                                               {Stationary, Stationary, Stationary, Stationary}, macro)
+                       });
+}
+
+StatePointer TMGenerator::moveVariableHead(const StatePointer &startState, int offset) {
+    StatePointer previous = startState;
+    for(int i = 0; i < std::abs(offset); ++i){
+        StatePointer next = makeState();
+        moveMultipleTapes(offset > 0 ? Right : Left, previous, next, {1});
+        previous = next;
+    }
+    return previous;
+}
+
+void TMGenerator::placeVariableHead(const string &variableName, const string &variableContainingIndex, int cellsPastValue) {
+    if(variableContainingIndex.empty() && variableSlots.count(variableName)){
+        variableHeadPosition = variableSlots.at(variableName) + cellsPastValue;
+    }else variableHeadPosition.reset();
+}
+
 void TMGenerator::moveMultipleTapes(TMTapeDirection direction, StatePointer &beginState, StatePointer &destination,
                                     const vector<int> tapeIndices) {
     vector<TMTapeDirection> directions(4, TMTapeDirection::Stationary);
@@ -1559,23 +2287,19 @@ void TMGenerator::moveMultipleTapes(TMTapeDirection direction, StatePointer &beg
                        });
 }
 
-std::pair<string, string> TMGenerator::parseVariableLocationContainer(const shared_ptr<STNode> &root) {
-    if(!root->children[0]->hasChildren()){ // just a variable name
-        return {root->children[0]->token->lexeme, ""};
-    }else{ // an array element
-        shared_ptr<STNode> indirectPack = root->children[0];
-        return {indirectPack->children[3]->token->lexeme, indirectPack->children[1]->token->lexeme};
+std::array<int, 3> TMGenerator::parseBox(SyntaxNode root) {
+    //<Box> -> box x, y, z
+    if(root.getLabel() != "<Box>"){
+        throw runtime_error("This AST node does not contain a Box");
     }
+    return {parseInteger(root.getChild(4)), parseInteger(root.getChild(2)), parseInteger(root.getChild(0))};
 }
 
-PostponedTransition::PostponedTransition(const StatePointer& start, const StatePointer& end, const set<string>& leftOutSymbols, bool onlyTheseSymbols)
-: startState(start), endState(end), startLine(0), endLine(0), leftOutSymbols(leftOutSymbols), onlyTheseSymbols(onlyTheseSymbols) {}
-
-PostponedTransition::PostponedTransition(const StatePointer &startState, int endLine, const set<string>& leftOutSymbols, bool onlyTheseSymbols)
-: startState(startState), endState(nullptr), startLine(0), endLine(endLine), leftOutSymbols(leftOutSymbols), onlyTheseSymbols(onlyTheseSymbols)  {}
-
-PostponedTransition::PostponedTransition(int startLine, const StatePointer &endState, const set<string>& leftOutSymbols, bool onlyTheseSymbols)
-: startState(nullptr), endState(endState), startLine(startLine), endLine(0), leftOutSymbols(leftOutSymbols), onlyTheseSymbols(onlyTheseSymbols)  {}
-
-PostponedTransition::PostponedTransition(int startLine, int endLine, const set<string>& leftOutSymbols, bool onlyTheseSymbols)
-: startState(nullptr), endState(nullptr), startLine(startLine), endLine(endLine), leftOutSymbols(leftOutSymbols), onlyTheseSymbols(onlyTheseSymbols)  {}
+std::pair<string, string> TMGenerator::parseVariableLocationContainer(SyntaxNode root) {
+    if(!root.getChild(0).hasChildren()){ // just a variable name
+        return {root.getChild(0).getToken()->lexeme, ""};
+    }else{ // an array element
+        SyntaxNode indirectPack = root.getChild(0);
+        return {indirectPack.getChild(3).getToken()->lexeme, indirectPack.getChild(1).getToken()->lexeme};
+    }
+}
@@ -4,68 +4,91 @@
 
 #include "../MTMDTuringMachine/MTMDTuringMachine.h"
 #include "LR1Parser/SyntaxTree/SyntaxTree.h"
+#include "TransitionBuilder.h"
 
+#include <array>
 #include <memory>
 #include <list>
 #include <map>
+#include <optional>
 
 using std::shared_ptr, std::set, std::string, std::map, std::list, std::vector;
 #include <iostream>
 
-struct PostponedTransition{
-    PostponedTransition(const StatePointer& start, const StatePointer& end, const set<string>& leftOutSymbols={}, bool onlyTheseSymbols=false);
-    PostponedTransition(const StatePointer &startState, int endLine, const set<string>& leftOutSymbols={}, bool onlyTheseSymbols=false);
-    PostponedTransition(int startLine, const StatePointer &endState, const set<string>& leftOutSymbols={}, bool onlyTheseSymbols=false);
-    PostponedTransition(int startLine, int endLine, const set<string>& leftOutSymbols={}, bool onlyTheseSymbols=false);
-
-    StatePointer startState;
-    StatePointer endState;
-    int startLine;
-    int endLine;
-    set<string> leftOutSymbols;
-    bool onlyTheseSymbols;
-    int tape = 0;
-    string toWrite;
-    vector<TMTapeDirection> directions = {TMTapeDirection::Stationary, TMTapeDirection::Stationary, TMTapeDirection::Stationary, TMTapeDirection::Stationary};
-};
-
 class TMGenerator {
     set<string> &tapeAlphabet;
     map<TransitionDomain, TransitionImage>& transitions;
     set<StatePointer>& states;
     bool readableStateNames;
+    bool optimizeFiniteControl;
+    bool allocateVariableSlots;
+    bool nativeArithmetic;
+    // with more than one, the statements are generated on that many threads
+    unsigned int threadCount;
     map<int, StatePointer> lineStartStates;
     StatePointer currentLineBeginState;
     int currentStateNumber = 0;
     int currentLineNumber = 1;
-    list<PostponedTransition> postponedTransitionBuffer;
+    TransitionBuilder postponedTransitionBuffer;
     inline static const string VariableTapeStart = "VTB";
     inline static const string VariableTapeEnd = "VTE";
     StatePointer CAstart;
     StatePointer CAend;
-
-    void alphabetExplorer(const shared_ptr<STNode>& root);
-    void explorer(const shared_ptr<STNode>& root);
+    // offsets (forwards, up, right) of the neighbours on the history tape
+    inline static const map<string, std::array<int, 3>> NeighbourOffsets = {{"Left", {0, 0, -1}}, {"Right", {0, 0, 1}},
+                                                                          {"Up", {0, 1, 0}}, {"Down", {0, -1, 0}},
+                                                                          {"Front", {1, 0, 0}}, {"Back", {-1, 0, 0}}};
+    // the neighbours that are used as variables, the others are only compared to a symbol and read in place
+    set<string> storedNeighbours;
+    bool insideAutomaton = false;
+
+    // with allocateVariableSlots, every scalar gets a fixed place on the variable tape (the index of its value relative to VTB)
+    vector<string> slotNames;
+    map<string, int> variableSlots;
+    set<int> jumpTargetLines;
+    // index of the variable tape head relative to VTB in the state that is being generated from, if it is known at compile time
+    std::optional<int> variableHeadPosition;
+    // where jumps leave the variable tape head, per line and by default
+    map<int, int> lineHeadPositions;
+    int variableHeadHome = BINARY_VALUE_WIDTH + 1;
+    list<std::tuple<StatePointer, std::optional<int>, int>> pendingJumps;
+
+    void alphabetExplorer(SyntaxNode root);
+    void slotExplorer(SyntaxNode root, set<string> &arrayNames);
+    void neighbourExplorer(SyntaxNode root, bool inAutomaton);
+    bool readsNeighbourInPlace(SyntaxNode condition, bool inAutomaton) const;
+    StatePointer writeVariableSlots(const StatePointer &startState);
+    StatePointer moveVariableHead(const StatePointer &startState, int offset);
+    StatePointer normalizeVariableHead(const StatePointer &startState, int position);
+    std::optional<int> firstSlotAccessed(SyntaxNode root) const;
+    PostponedTransition& jumpToLine(const StatePointer &startState, int lineNumber, const set<string>& leftOutSymbols={},
+                                    bool onlyTheseSymbols=false);
+    void placeVariableHead(const string &variableName, const string &variableContainingIndex, int cellsPastValue);
+    void explorer(SyntaxNode root);
+    bool parallelExplorer(SyntaxNode root);
+    void runNatively(const StatePointer &startState, const StatePointer &destination, const MacroPointer &macro);
 
     void registerRegularNewline(StatePointer& state);
     StatePointer makeState(int beginStateOfThisLineNumber = 0, bool accepting=false);
     StatePointer MoveToVariableValue(StatePointer startState, const string &variableName,
                                      const string &variableContainingIndex="");
 
-    static TMTapeDirection parseDirection(const shared_ptr<STNode>& root);
-    static int parseInteger(const shared_ptr<STNode>& root);
-    static std::pair<string, string> parseVariableLocationContainer(const shared_ptr<STNode> &root);
-    static string parseSymbolLiteral(const shared_ptr<STNode>& root);
-    static set<string> parseIdentifierList(const shared_ptr<STNode>& root);
-    static void identifierListPartRecursiveParser(const shared_ptr<STNode> &root, set<string> &output);
+    static TMTapeDirection parseDirection(SyntaxNode root);
+    static int parseInteger(SyntaxNode root);
+    static std::pair<string, string> parseVariableLocationContainer(SyntaxNode root);
+    static std::array<int, 3> parseBox(SyntaxNode root);
+    static string parseSymbolLiteral(SyntaxNode root);
+    static set<string> parseIdentifierList(SyntaxNode root);
+    static void identifierListPartRecursiveParser(SyntaxNode root, set<string> &output);
     string IntegerAsBitString(int in, bool flipped = false);
 
     StatePointer getNextLineStartState();
 public:
-    void assembleTasm(const shared_ptr<STNode> root);
+    void assembleTasm(SyntaxNode root);
 
     TMGenerator(set<string> &tapeAlphabet, map<TransitionDomain, TransitionImage> &transitions,
-                set<StatePointer> &states, bool readableStateNames = false);
+                set<StatePointer> &states, bool readableStateNames = false, bool optimizeFiniteControl = false,
+                bool allocateVariableSlots = false, bool nativeArithmetic = false, unsigned int threadCount = 1);
 
     StatePointer copyIntegerToThirdTape(StatePointer startState, bool backToStart);
 
@@ -82,6 +105,12 @@ public:
                            StatePointer &destination, const string &variableContainingIndex="");
     void bitwiseAnd(const string &variableName, string &timesShifted, StatePointer &startingState,
                StatePointer &destination, const string &variableContainingIndex="");
+    /**
+     * @brief Divides the variable by the value in sysvar, truncating towards 0. Dividing by 0 gives -1.
+     * Works on the magnitudes with shift-subtract long division on the third tape, sysvar is left holding the magnitude of the divisor
+     */
+    void integerDivision(const string &variableName, StatePointer &startingState, StatePointer &destination,
+                         const string &variableContainingIndex="");
 
     void
     IntegerCompare(const string &variableName, string &binaryComparedValue, StatePointer &standardDestination,
@@ -0,0 +1,231 @@
+//
+
+#include "TMOptimizer.h"
+#include "utils/Instrumentation.h"
+
+#include <algorithm>
+#include <optional>
+#include <queue>
+#include <unordered_set>
+
+TMOptimizer::TMOptimizer(map<TransitionDomain, TransitionImage> &transitions, set<StatePointer> &states)
+        : transitions(transitions), states(states) {}
+
+void TMOptimizer::optimize() {
+    INSTRUMENT_SCOPE("optimise finite control");
+    collectTransitions();
+    if(!initialState) return;
+    threadJumps();
+    findReachableStates();
+    mergeEquivalentStates();
+}
+
+void TMOptimizer::collectTransitions() {
+    for(const StatePointer &state : states) {
+        if(state->isInitial) initialState = state;
+    }
+    for(const auto &[domain, image] : transitions) {
+        outgoing[domain.state].emplace(domain.replacedSymbols, image);
+    }
+}
+
+// a jump does nothing but go to a single other state, whatever is read
+bool TMOptimizer::isJump(const StatePointer &state) const {
+    if(state == initialState || state->type != State_NonHalting) return false;
+    const auto found = outgoing.find(state);
+    if(found == outgoing.end() || found->second.empty()) return false;
+    const StatePointer &target = found->second.begin()->second.state;
+    if(target == state) return false;
+
+    bool coversEverything = false;
+    for(const auto &[domain, image] : found->second) {
+        if(image.state != target || image.macro) return false;
+        for(unsigned int i = 0; i < domain.size(); i++) {
+            const TMTapeProbabilisticDirection &direction = image.directions[i];
+            if(direction.directions.size() != 1 || direction.directions[0] != Stationary) return false;
+            const string &replacement = image.replacementSymbols[i];
+            if(replacement != SYMBOL_ANY && replacement != domain[i] && replacement != TapeReference::symbolOn(i)) return false;
+            if(TapeReference::isReference(domain[i]) || NeighbourRead::isNeighbourRead(domain[i])) return false;
+        }
+        if(std::all_of(domain.begin(), domain.end(), [](const string &symbol) { return symbol == SYMBOL_ANY; })) {
+            coversEverything = true;
+        }
+    }
+    // an enumeration of the tape alphabet is not enough, the world can hold symbols outside of it and the machine
+    // halts on those
+    return coversEverything;
+}
+
+void TMOptimizer::threadJumps() {
+    unordered_map<StatePointer, StatePointer> jumpTargets;
+    for(const auto &[state, stateTransitions] : outgoing) {
+        if(isJump(state)) jumpTargets[state] = stateTransitions.begin()->second.state;
+    }
+    // follow every chain of jumps to its end, jumps that loop forever are left alone
+    unordered_map<StatePointer, StatePointer> threadedTargets;
+    for(const auto &[state, target] : jumpTargets) {
+        std::unordered_set<StatePointer> visited{state};
+        StatePointer current = target;
+        while(current && jumpTargets.count(current)) {
+            current = visited.insert(current).second ? jumpTargets.at(current) : nullptr;
+        }
+        if(current) threadedTargets[state] = current;
+    }
+    for(auto &[state, stateTransitions] : outgoing) {
+        StateTransitions threaded;
+        for(const auto &[domain, image] : stateTransitions) {
+            const auto found = threadedTargets.find(image.state);
+            if(found == threadedTargets.end()) threaded.emplace(domain, image);
+            else threaded.emplace(domain, TransitionImage(found->second, image.replacementSymbols, image.directions, image.macro));
+        }
+        stateTransitions.swap(threaded);
+    }
+}
+
+void TMOptimizer::findReachableStates() {
+    std::unordered_set<StatePointer> visited{initialState};
+    std::queue<StatePointer> queue;
+    queue.push(initialState);
+    while(!queue.empty()) {
+        const StatePointer state = queue.front();
+        queue.pop();
+        reachableStates.push_back(state);
+        const auto found = outgoing.find(state);
+        // the machine halts as soon as it enters a halting state
+        if(state->type != State_NonHalting || found == outgoing.end()) continue;
+        for(const auto &[domain, image] : found->second) {
+            if(visited.insert(image.state).second) queue.push(image.state);
+        }
+    }
+}
+
+string TMOptimizer::transitionLabel(const vector<string> &domain, const TransitionImage &image) {
+    string label;
+    for(const string &symbol : domain) label += symbol + '\t';
+    label += '\n';
+    for(const string &symbol : image.replacementSymbols) label += symbol + '\t';
+    label += '\n';
+    for(const TMTapeProbabilisticDirection &direction : image.directions) {
+        for(unsigned int i = 0; i < direction.directions.size(); i++) {
+            label += (char) direction.directions[i] + std::to_string(direction.probabilities[i]);
+        }
+        label += '\t';
+    }
+    if(image.macro) label += '\n' + image.macro->getKey();
+    return label;
+}
+
+void TMOptimizer::mergeEquivalentStates() {
+    // Hopcroft's partition refinement: states start out together when they have the same type and transitions that read
+    // and do the same, a block is split whenever some of its states go into a splitter block by a transition and the
+    // others do not, and only the smaller part of a split needs to be used as a splitter again
+    const size_t stateCount = reachableStates.size();
+    unordered_map<StatePointer, unsigned int> index;
+    for(unsigned int i = 0; i < stateCount; i++) index.emplace(reachableStates[i], i);
+    map<string, unsigned int> labels;
+    vector<vector<unsigned int>> stateLabels(stateCount);
+    // the transitions into every state as their label and the state they come from
+    vector<vector<std::pair<unsigned int, unsigned int>>> predecessors(stateCount);
+    for(unsigned int i = 0; i < stateCount; i++) {
+        const StatePointer &state = reachableStates[i];
+        if(state->type != State_NonHalting || !outgoing.count(state)) continue;
+        for(const auto &[domain, image] : outgoing.at(state)) {
+            const unsigned int label = labels.emplace(transitionLabel(domain, image), labels.size()).first->second;
+            stateLabels[i].push_back(label);
+            predecessors[index.at(image.state)].emplace_back(label, i);
+        }
+        std::sort(stateLabels[i].begin(), stateLabels[i].end());
+    }
+
+    // the states of a block are kept next to each other in elements, the marked ones at its front
+    vector<unsigned int> elements(stateCount), location(stateCount), block(stateCount);
+    vector<size_t> blockStart, blockEnd, marked;
+    {
+        map<std::pair<unsigned int, vector<unsigned int>>, vector<unsigned int>> initialBlocks;
+        for(unsigned int i = 0; i < stateCount; i++) {
+            initialBlocks[{reachableStates[i]->type, std::move(stateLabels[i])}].push_back(i);
+        }
+        size_t position = 0;
+        for(const auto &[signature, members] : initialBlocks) {
+            blockStart.push_back(position);
+            for(unsigned int state : members) {
+                elements[position] = state;
+                location[state] = position++;
+                block[state] = blockStart.size() - 1;
+            }
+            blockEnd.push_back(position);
+            marked.push_back(0);
+        }
+    }
+    vector<unsigned int> worklist(blockStart.size());
+    for(unsigned int i = 0; i < worklist.size(); i++) worklist[i] = i;
+
+    vector<unsigned int> splitter;
+    vector<std::pair<unsigned int, unsigned int>> incoming;
+    vector<unsigned int> touchedBlocks;
+    while(!worklist.empty()) {
+        const unsigned int splitterBlock = worklist.back();
+        worklist.pop_back();
+        // the splitter itself can be split below
+        splitter.assign(elements.begin() + blockStart[splitterBlock], elements.begin() + blockEnd[splitterBlock]);
+        incoming.clear();
+        for(unsigned int state : splitter) incoming.insert(incoming.end(), predecessors[state].begin(), predecessors[state].end());
+        std::sort(incoming.begin(), incoming.end());
+        for(size_t first = 0; first < incoming.size();) {
+            size_t last = first;
+            // a state has one transition for every label, so it is marked at most once per label
+            for(; last < incoming.size() && incoming[last].first == incoming[first].first; last++) {
+                const unsigned int state = incoming[last].second;
+                const unsigned int stateBlock = block[state];
+                if(marked[stateBlock] == 0) touchedBlocks.push_back(stateBlock);
+                const size_t front = blockStart[stateBlock] + marked[stateBlock]++;
+                const unsigned int swapped = elements[front];
+                std::swap(elements[location[state]], elements[front]);
+                location[swapped] = location[state];
+                location[state] = front;
+            }
+            first = last;
+            for(unsigned int touched : touchedBlocks) {
+                const size_t start = blockStart[touched], end = blockEnd[touched], split = start + marked[touched];
+                marked[touched] = 0;
+                if(split == end) continue;
+                // the smaller part becomes a new block
+                const unsigned int newBlock = blockStart.size();
+                if(split - start <= end - split) {
+                    blockStart.push_back(start);
+                    blockEnd.push_back(split);
+                    blockStart[touched] = split;
+                }
+                else {
+                    blockStart.push_back(split);
+                    blockEnd.push_back(end);
+                    blockEnd[touched] = split;
+                }
+                marked.push_back(0);
+                for(size_t i = blockStart[newBlock]; i < blockEnd[newBlock]; i++) block[elements[i]] = newBlock;
+                // whether or not the old block is still waiting to be a splitter, adding the smaller part suffices
+                worklist.push_back(newBlock);
+            }
+            touchedBlocks.clear();
+        }
+    }
+
+    // the first state of every block in breadth-first order represents it, so the initial state is kept
+    vector<std::optional<unsigned int>> representatives(blockStart.size());
+    for(unsigned int i = 0; i < stateCount; i++) {
+        if(!representatives[block[i]]) representatives[block[i]] = i;
+    }
+    states.clear();
+    transitions.clear();
+    for(unsigned int i = 0; i < stateCount; i++) {
+        if(*representatives[block[i]] != i) continue;
+        const StatePointer &state = reachableStates[i];
+        states.insert(state);
+        if(state->type != State_NonHalting || !outgoing.count(state)) continue;
+        for(const auto &[domain, image] : outgoing.at(state)) {
+            const StatePointer &target = reachableStates[*representatives[block[index.at(image.state)]]];
+            transitions.emplace(TransitionDomain(state, domain),
+                                TransitionImage(target, image.replacementSymbols, image.directions, image.macro));
+        }
+    }
+}
@@ -0,0 +1,42 @@
+//
+
+#ifndef VOXELFUSION_TMOPTIMIZER_H
+#define VOXELFUSION_TMOPTIMIZER_H
+
+#include "../MTMDTuringMachine/FiniteControl.h"
+
+#include <map>
+#include <set>
+#include <unordered_map>
+
+using std::set, std::string, std::map, std::vector, std::unordered_map;
+
+/**
+ * @brief Shrinks a generated finite control without changing what it does to the tapes:
+ * goto chains are threaded, unreachable states are removed and equivalent states are merged
+ * by partition refinement over the (multi-tape) domains and images of their transitions
+ */
+class TMOptimizer {
+    map<TransitionDomain, TransitionImage> &transitions;
+    set<StatePointer> &states;
+
+    StatePointer initialState;
+    unordered_map<StatePointer, StateTransitions> outgoing;
+    // every state reachable from the initial state, in breadth-first order
+    vector<StatePointer> reachableStates;
+
+    void collectTransitions();
+    bool isJump(const StatePointer &state) const;
+    void threadJumps();
+    void findReachableStates();
+    void mergeEquivalentStates();
+
+    static string transitionLabel(const vector<string> &domain, const TransitionImage &image);
+public:
+    TMOptimizer(map<TransitionDomain, TransitionImage> &transitions, set<StatePointer> &states);
+
+    void optimize();
+};
+
+
+#endif //VOXELFUSION_TMOPTIMIZER_H
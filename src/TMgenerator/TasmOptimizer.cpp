@@ -0,0 +1,440 @@
+//
+
+#include "TasmOptimizer.h"
+#include "utils/Instrumentation.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace {
+    const uint64_t ValueMask = (uint64_t(2) << (BINARY_VALUE_WIDTH - 1)) - 1;
+
+    const set<string> KnownStatements = {
+            "<TapeMove>", "<TapeWrite>", "<Jump>", "<ReadCondition>", "<Accept>", "<ConditionalMove>",
+            "<SymbolValueAssignment>", "<IntegerValueAssignment>", "<ImmediateSymbolValueAssignment>",
+            "<SymbolVariableCondition>", "<IntegerVariableCondition>", "<BinaryVariableCondition>",
+            "<ImmediateAddition>", "<ImmediateSubtraction>", "<ImmediateMultiplication>", "<ImmediateDivision>", "<ImmediateAnd>",
+            "<BinaryAddition>", "<BinarySubtraction>", "<BinaryMultiplication>", "<BinaryDivision>",
+            "<CellularAutomatonDeclaration>", "<CellularAutomatonRun>", "<ArrayDeclaration>", "<RandomInteger>",
+            "<BoxFill>", "<BoxCopy>", "<BoxShift>"
+    };
+    // the goto line is always the second to last child, as children are stored in reverse
+    const set<string> JumpStatements = {
+            "<Jump>", "<ReadCondition>", "<SymbolVariableCondition>", "<IntegerVariableCondition>", "<BinaryVariableCondition>"
+    };
+    const map<string, char> ImmediateOperations = {
+            {"<ImmediateAddition>", '+'}, {"<ImmediateSubtraction>", '-'}, {"<ImmediateMultiplication>", '*'},
+            {"<ImmediateDivision>", '/'}, {"<ImmediateAnd>", '&'}
+    };
+    const map<string, char> BinaryOperations = {
+            {"<BinaryAddition>", '+'}, {"<BinarySubtraction>", '-'}, {"<BinaryMultiplication>", '*'}, {"<BinaryDivision>", '/'}
+    };
+
+    bool isNegative(uint64_t value) {return (value >> (BINARY_VALUE_WIDTH - 1)) & 1;}
+    // only non-negative values can be written as an Integer
+    bool fitsInteger(uint64_t value) {return !isNegative(value);}
+    uint64_t negate(uint64_t value) {return -value & ValueMask;}
+
+    // the same arithmetic as the generated machine, on BINARY_VALUE_WIDTH bit two's complement values
+    uint64_t apply(char operation, uint64_t value, uint64_t operand) {
+        switch(operation){
+            case '+': return (value + operand) & ValueMask;
+            case '-': return (value - operand) & ValueMask;
+            case '*': return (value * operand) & ValueMask;
+            case '&': return value & operand;
+            default:{
+                // truncates towards 0, dividing by 0 gives -1
+                const uint64_t dividend = isNegative(value) ? negate(value) : value;
+                const uint64_t divisor = isNegative(operand) ? negate(operand) : operand;
+                if(divisor == 0) return ValueMask;
+                const uint64_t quotient = dividend / divisor;
+                return isNegative(value) != isNegative(operand) ? negate(quotient) : quotient;
+            }
+        }
+    }
+    bool isIdentity(char operation, uint64_t operand) {
+        return ((operation == '+' || operation == '-') && operand == 0) || ((operation == '*' || operation == '/') && operand == 1);
+    }
+
+    std::optional<string> scalarName(SyntaxNode location) {
+        if(location.getChild(0).hasChildren()) return std::nullopt;
+        return location.getChild(0).getToken()->lexeme;
+    }
+    // wraps around like the generator's bit strings, however many digits the literal has
+    uint64_t parseValue(SyntaxNode integer) {
+        uint64_t value = 0;
+        for(const char digit : integer.getToken()->lexeme) value = value * 10 + (digit - '0');
+        return value & ValueMask;
+    }
+    int target(SyntaxNode statement) {return std::stoi(statement.getChild(1).getToken()->lexeme);}
+
+    SyntaxNode leaf(SyntaxTree &tree, TokenType type, const string &lexeme) {return tree.addLeaf(Token(type, lexeme));}
+    SyntaxNode integer(SyntaxTree &tree, uint64_t value) {return leaf(tree, Token_Integer, std::to_string(value));}
+    // takes the children in source order
+    SyntaxNode node(SyntaxTree &tree, const string &label, vector<SyntaxNode> children) {
+        std::reverse(children.begin(), children.end());
+        return tree.addNode(label, children);
+    }
+    SyntaxNode withChild(SyntaxTree &tree, SyntaxNode parent, unsigned int index, SyntaxNode child) {
+        const SyntaxNode::Children parentChildren = parent.getChildren();
+        vector<SyntaxNode> children(parentChildren.begin(), parentChildren.end());
+        children[index] = child;
+        return tree.addNode(parent.getLabel(), children);
+    }
+
+    SyntaxNode jump(SyntaxTree &tree, SyntaxNode line) {
+        return node(tree, "<Jump>", {leaf(tree, Token_Keyword, "goto"), line, leaf(tree, Token_Punctuator, ";")});
+    }
+    SyntaxNode assignment(SyntaxTree &tree, SyntaxNode location, uint64_t value) {
+        return node(tree, "<IntegerValueAssignment>", {location, leaf(tree, Token_Operator, "="), integer(tree, value), leaf(tree, Token_Punctuator, ";")});
+    }
+    SyntaxNode immediateOperation(SyntaxTree &tree, char operation, SyntaxNode location, uint64_t operand) {
+        const auto found = std::find_if(ImmediateOperations.begin(), ImmediateOperations.end(),
+                                        [operation](const auto &immediate) {return immediate.second == operation;});
+        return node(tree, found->first, {location, leaf(tree, Token_Operator, string(1, operation) + "="), integer(tree, operand),
+                                         leaf(tree, Token_Punctuator, ";")});
+    }
+    SyntaxNode condition(SyntaxTree &tree, SyntaxNode location, uint64_t value, SyntaxNode line) {
+        return node(tree, "<IntegerVariableCondition>", {leaf(tree, Token_Keyword, "if"), location, leaf(tree, Token_Operator, "=="),
+                                                         integer(tree, value), leaf(tree, Token_Keyword, "goto"), line,
+                                                         leaf(tree, Token_Punctuator, ";")});
+    }
+    // adding a value that does not fit is subtracting its negation
+    SyntaxNode addition(SyntaxTree &tree, SyntaxNode location, uint64_t term) {
+        if(fitsInteger(term)) return immediateOperation(tree, '+', location, term);
+        if(fitsInteger(negate(term))) return immediateOperation(tree, '-', location, negate(term));
+        return {};
+    }
+
+    void transfer(SyntaxNode statement, map<string, uint64_t> &constants) {
+        const string &l = statement.getLabel();
+        const auto valueOf = [&constants](SyntaxNode location) -> std::optional<uint64_t> {
+            const std::optional<string> name = scalarName(location);
+            if(!name || !constants.count(*name)) return std::nullopt;
+            return constants.at(*name);
+        };
+        if(l == "<IntegerValueAssignment>"){
+            if(const auto name = scalarName(statement.getChild(3))) constants[*name] = parseValue(statement.getChild(1));
+        }else if(ImmediateOperations.count(l)){
+            if(const auto value = valueOf(statement.getChild(3))){
+                constants[*scalarName(statement.getChild(3))] = apply(ImmediateOperations.at(l), *value, parseValue(statement.getChild(1)));
+            }
+        }else if(BinaryOperations.count(l)){
+            const auto name = scalarName(statement.getChild(3));
+            const auto value = valueOf(statement.getChild(3)), operand = valueOf(statement.getChild(1));
+            if(value && operand) constants[*name] = apply(BinaryOperations.at(l), *value, *operand);
+            else if(name) constants.erase(*name);
+        }else if(l == "<SymbolValueAssignment>" || l == "<ImmediateSymbolValueAssignment>"){
+            if(const auto name = scalarName(statement.getChild(3))) constants.erase(*name);
+        }else if(l == "<RandomInteger>"){
+            if(const auto name = scalarName(statement.getChild(6))) constants.erase(*name);
+        }else if(l == "<ArrayDeclaration>"){
+            constants.erase(statement.getChild(8).getToken()->lexeme);
+        }else if(l == "<CellularAutomatonRun>"){
+            // the automaton can change any variable
+            constants.clear();
+        }
+    }
+}
+
+bool TasmOptimizer::flatten(SyntaxNode statementList, bool inAutomaton) {
+    vector<SyntaxNode> statements;
+    for(SyntaxNode list = statementList; ; list = list.getChild(1)){
+        if(list.getLabel() != "<StatementList>") return false;
+        statements.push_back(list.getChild(0));
+        if(list.getChildCount() == 1) break;
+    }
+    std::reverse(statements.begin(), statements.end());
+    for(SyntaxNode statement : statements){
+        if(statement.getLabel() != "<Statement>" || statement.getChildCount() != 1 || !KnownStatements.count(statement.getChild(0).getLabel())){
+            return false;
+        }
+        const SyntaxNode inner = statement.getChild(0);
+        if(inner.getLabel() == "<CellularAutomatonDeclaration>"){
+            if(inAutomaton) return false;
+            const size_t declaration = lines.size();
+            lines.push_back({inner});
+            if(!flatten(inner.getChild(2), true)) return false;
+            lines.push_back({SyntaxNode(), true});
+            lines[declaration].automatonEnd = lineCount();
+        }else lines.push_back({inner, inAutomaton});
+    }
+    return true;
+}
+
+// gotos may not jump into or out of the body of a cellular automaton
+bool TasmOptimizer::jumpsStayInPlace() const {
+    vector<int> automaton(lines.size(), 0);
+    for(int i = 1; i <= lineCount(); i++){
+        for(int j = i + 1; j <= lines[i].automatonEnd; j++) automaton[j] = i;
+    }
+    for(int i = 1; i <= lineCount(); i++){
+        if(!lines[i].statement || !JumpStatements.count(lines[i].statement.getLabel())) continue;
+        const int line = target(lines[i].statement);
+        if((line >= 1 && line <= lineCount() ? automaton[line] : 0) != automaton[i]) return false;
+    }
+    return true;
+}
+
+vector<int> TasmOptimizer::successors(int line) const {
+    const Line &current = lines[line];
+    if(current.removed) return {line + 1};
+    if(current.automatonEnd) return {current.automatonEnd + 1};
+    const string &l = current.statement.getLabel();
+    if(l == "<Accept>") return {};
+    if(l == "<Jump>") return {target(current.statement)};
+    if(JumpStatements.count(l)) return {target(current.statement), line + 1};
+    return {line + 1};
+}
+
+set<int> TasmOptimizer::jumpTargets() const {
+    set<int> targets;
+    for(const Line &line : lines){
+        if(line.statement && !line.removed && JumpStatements.count(line.statement.getLabel())) targets.insert(target(line.statement));
+    }
+    return targets;
+}
+
+// the constants known at the start of every line outside the automata, none for lines that are never reached
+vector<std::optional<TasmOptimizer::Constants>> TasmOptimizer::propagateConstants() const {
+    vector<std::optional<Constants>> known(lines.size());
+    std::queue<int> worklist;
+    const auto merge = [&](int line, const Constants &constants) {
+        if(line < 1 || line > lineCount()) return;
+        std::optional<Constants> &current = known[line];
+        if(!current){
+            current = constants;
+            worklist.push(line);
+            return;
+        }
+        const size_t before = current->size();
+        std::erase_if(*current, [&constants](const auto &constant) {
+            const auto found = constants.find(constant.first);
+            return found == constants.end() || found->second != constant.second;
+        });
+        if(current->size() != before) worklist.push(line);
+    };
+    merge(1, {});
+    while(!worklist.empty()){
+        const int line = worklist.front();
+        worklist.pop();
+        const Line &current = lines[line];
+        Constants constants = *known[line];
+        if(!current.removed && !current.automatonEnd) transfer(current.statement, constants);
+        // taking the jump tells which value the variable has
+        if(!current.removed && current.statement.getLabel() == "<IntegerVariableCondition>" && scalarName(current.statement.getChild(5))){
+            Constants jumped = constants;
+            jumped[*scalarName(current.statement.getChild(5))] = parseValue(current.statement.getChild(3));
+            merge(target(current.statement), jumped);
+            merge(line + 1, constants);
+            continue;
+        }
+        for(const int next : successors(line)) merge(next, constants);
+    }
+    return known;
+}
+
+bool TasmOptimizer::foldConstants() {
+    const vector<std::optional<Constants>> known = propagateConstants();
+    bool changed = false;
+    for(int i = 1; i <= lineCount(); i++){
+        Line &line = lines[i];
+        if(line.removed || line.automatonEnd || line.inAutomaton || !known[i]) continue;
+        const SyntaxNode statement = line.statement;
+        const string &l = statement.getLabel();
+        const auto valueOf = [&known, i](SyntaxNode location) -> std::optional<uint64_t> {
+            const std::optional<string> name = scalarName(location);
+            if(!name || !known[i]->count(*name)) return std::nullopt;
+            return known[i]->at(*name);
+        };
+        SyntaxNode replacement;
+        bool remove = false;
+        // an operation on a known value becomes an assignment of the result
+        const auto fold = [&](char operation, SyntaxNode location, uint64_t operand) {
+            if(const auto value = valueOf(location)){
+                const uint64_t result = apply(operation, *value, operand);
+                if(result == *value) remove = true;
+                else if(fitsInteger(result)) replacement = assignment(*tree, location, result);
+                return true;
+            }
+            remove = isIdentity(operation, operand);
+            return remove;
+        };
+        if(l == "<IntegerValueAssignment>"){
+            remove = valueOf(statement.getChild(3)) == parseValue(statement.getChild(1));
+        }else if(ImmediateOperations.count(l)){
+            fold(ImmediateOperations.at(l), statement.getChild(3), parseValue(statement.getChild(1)));
+        }else if(BinaryOperations.count(l)){
+            const char operation = BinaryOperations.at(l);
+            const auto operand = valueOf(statement.getChild(1));
+            if(operand && !fold(operation, statement.getChild(3), *operand)){
+                if(operation == '+' || operation == '-'){
+                    replacement = addition(*tree, statement.getChild(3), operation == '+' ? *operand : negate(*operand));
+                }else if(fitsInteger(*operand)) replacement = immediateOperation(*tree, operation, statement.getChild(3), *operand);
+            }
+        }else if(l == "<IntegerVariableCondition>"){
+            if(const auto value = valueOf(statement.getChild(5))){
+                if(*value == parseValue(statement.getChild(3))) replacement = jump(*tree, statement.getChild(1));
+                else remove = true;
+            }
+        }else if(l == "<BinaryVariableCondition>"){
+            const auto left = valueOf(statement.getChild(5)), right = valueOf(statement.getChild(3));
+            if(left && right){
+                if(*left == *right) replacement = jump(*tree, statement.getChild(1));
+                else remove = true;
+            }else if(right && fitsInteger(*right)) replacement = condition(*tree, statement.getChild(5), *right, statement.getChild(1));
+            else if(left && fitsInteger(*left)) replacement = condition(*tree, statement.getChild(3), *left, statement.getChild(1));
+        }
+        if(remove) line.removed = true;
+        else if(replacement) line.statement = replacement;
+        changed |= remove || replacement;
+    }
+    return changed;
+}
+
+// merges a line into the next one if that one can only be reached from it
+bool TasmOptimizer::mergeNeighbours() {
+    const set<int> targets = jumpTargets();
+    bool changed = false;
+    for(int i = 1; i <= lineCount(); i++){
+        Line &line = lines[i];
+        if(line.removed || line.automatonEnd || line.inAutomaton) continue;
+        int next = i + 1;
+        bool onlyFromHere = !targets.count(next);
+        while(next <= lineCount() && lines[next].removed) onlyFromHere &= !targets.count(++next);
+        if(next > lineCount() || !onlyFromHere || lines[next].automatonEnd || lines[next].inAutomaton) continue;
+        const SyntaxNode first = line.statement, second = lines[next].statement;
+        const auto isImmediate = [](SyntaxNode statement) {
+            return statement.getLabel() == "<IntegerValueAssignment>" || ImmediateOperations.count(statement.getLabel());
+        };
+        if(!isImmediate(first) || !isImmediate(second)) continue;
+        const std::optional<string> name = scalarName(first.getChild(3));
+        if(!name || name != scalarName(second.getChild(3))) continue;
+
+        if(first.getLabel() == "<IntegerValueAssignment>" && second.getLabel() == "<IntegerValueAssignment>"){
+            // the value is overwritten before it is read
+            line.removed = true;
+            changed = true;
+            continue;
+        }
+        if(!ImmediateOperations.count(first.getLabel()) || !ImmediateOperations.count(second.getLabel())) continue;
+        const char firstOperation = ImmediateOperations.at(first.getLabel()), secondOperation = ImmediateOperations.at(second.getLabel());
+        const uint64_t firstOperand = parseValue(first.getChild(1)), secondOperand = parseValue(second.getChild(1));
+        SyntaxNode merged;
+        if((firstOperation == '+' || firstOperation == '-') && (secondOperation == '+' || secondOperation == '-')){
+            const uint64_t term = apply(secondOperation, apply(firstOperation, 0, firstOperand), secondOperand);
+            if(term == 0){
+                line.removed = lines[next].removed = true;
+                changed = true;
+                continue;
+            }
+            merged = addition(*tree, second.getChild(3), term);
+        }else if(firstOperation == secondOperation && (firstOperation == '*' || firstOperation == '&')){
+            const uint64_t operand = apply(firstOperation, firstOperand, secondOperand);
+            if(fitsInteger(operand)) merged = immediateOperation(*tree, firstOperation, second.getChild(3), operand);
+        }
+        if(!merged) continue;
+        line.removed = true;
+        lines[next].statement = merged;
+        changed = true;
+    }
+    return changed;
+}
+
+// where a jump to the line ends up, past removed lines, declarations and other jumps
+int TasmOptimizer::resolve(int target) const {
+    set<int> visited;
+    while(target >= 1 && target <= lineCount() && visited.insert(target).second){
+        const Line &line = lines[target];
+        if(line.inAutomaton) break;
+        if(line.removed) target++;
+        else if(line.automatonEnd) target = line.automatonEnd + 1;
+        else if(line.statement.getLabel() == "<Jump>") target = ::target(line.statement);
+        else break;
+    }
+    return target;
+}
+
+bool TasmOptimizer::threadJumps() {
+    bool changed = false;
+    for(int i = 1; i <= lineCount(); i++){
+        Line &line = lines[i];
+        if(line.removed || line.automatonEnd || line.inAutomaton || !JumpStatements.count(line.statement.getLabel())) continue;
+        const int threaded = resolve(target(line.statement));
+        if(line.statement.getLabel() == "<Jump>" && threaded == resolve(i + 1)) line.removed = true;
+        else if(threaded != target(line.statement)) line.statement = withChild(*tree, line.statement, 1, integer(*tree, threaded));
+        else continue;
+        changed = true;
+    }
+    return changed;
+}
+
+bool TasmOptimizer::removeUnreachable() {
+    vector<bool> reached(lines.size(), false);
+    std::queue<int> worklist;
+    worklist.push(1);
+    while(!worklist.empty()){
+        const int line = worklist.front();
+        worklist.pop();
+        if(line < 1 || line > lineCount() || reached[line]) continue;
+        reached[line] = true;
+        for(const int next : successors(line)) worklist.push(next);
+    }
+    bool changed = false;
+    for(int i = 1; i <= lineCount(); i++){
+        // the automata are run from anywhere
+        if(reached[i] || lines[i].removed || lines[i].automatonEnd || lines[i].inAutomaton) continue;
+        lines[i].removed = true;
+        changed = true;
+    }
+    return changed;
+}
+
+SyntaxNode TasmOptimizer::rebuild(int first, int last, const vector<int> &renumbered) const {
+    SyntaxNode list;
+    for(int i = first; i <= last; i++){
+        const Line &line = lines[i];
+        if(line.removed) continue;
+        SyntaxNode statement = line.statement;
+        if(JumpStatements.count(statement.getLabel())){
+            const int jumpedTo = target(statement);
+            const int number = jumpedTo < 1 ? jumpedTo
+                    : jumpedTo <= lineCount() + 1 ? renumbered[jumpedTo] : renumbered.back() + jumpedTo - lineCount() - 1;
+            statement = withChild(*tree, statement, 1, integer(*tree, number));
+        }
+        if(line.automatonEnd){
+            statement = withChild(*tree, statement, 2, rebuild(i + 1, line.automatonEnd - 1, renumbered));
+            i = line.automatonEnd;
+        }
+        const SyntaxNode wrapped = tree->addNode("<Statement>", {statement});
+        list = list ? tree->addNode("<StatementList>", {wrapped, list}) : tree->addNode("<StatementList>", {wrapped});
+    }
+    return list;
+}
+
+SyntaxNode TasmOptimizer::optimize(SyntaxTree &syntaxTree) {
+    INSTRUMENT_SCOPE("optimise syntax tree");
+    tree = &syntaxTree;
+    const SyntaxNode root = tree->getRoot();
+    lines.assign(1, {});
+    if(!flatten(root, false) || !jumpsStayInPlace()) return root;
+    bool optimized = false;
+    for(bool changed = true; changed; optimized |= changed){
+        changed = foldConstants();
+        changed |= mergeNeighbours();
+        changed |= threadJumps();
+        changed |= removeUnreachable();
+    }
+    if(!optimized) return root;
+
+    // a removed line is replaced by the one after it
+    vector<int> renumbered(lines.size() + 1);
+    int number = 0;
+    for(int i = 1; i <= lineCount(); i++) number += !lines[i].removed;
+    renumbered[lineCount() + 1] = number + 1;
+    for(int i = lineCount(); i >= 1; i--) renumbered[i] = lines[i].removed ? renumbered[i + 1] : number--;
+    const SyntaxNode optimizedRoot = rebuild(1, lineCount(), renumbered);
+    if(!optimizedRoot) return root;
+    tree->setRoot(optimizedRoot);
+    return optimizedRoot;
+}
@@ -0,0 +1,59 @@
+//
+
+#ifndef VOXELFUSION_TASMOPTIMIZER_H
+#define VOXELFUSION_TASMOPTIMIZER_H
+
+#include "../LR1Parser/SyntaxTree/SyntaxTree.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+
+using std::set, std::string, std::map, std::vector;
+
+/**
+ * @brief Simplifies a parsed TASM script before it is generated, without changing what it does:
+ * integer constants are propagated into conditions and arithmetic, consecutive immediate operations on a variable are merged,
+ * goto chains are threaded and lines that cannot be reached or do nothing are removed, renumbering every goto.
+ * Cellular automaton declarations are kept as they are and scripts with statements it does not know are left alone
+ */
+class TasmOptimizer {
+    struct Line {
+        // the statement without its <Statement> node, no node for the line that ends the body of a cellular automaton
+        SyntaxNode statement;
+        bool inAutomaton = false;
+        // for a cellular automaton declaration, the line that ends its body
+        int automatonEnd = 0;
+        bool removed = false;
+    };
+    // the values integer variables are known to have, as BINARY_VALUE_WIDTH bits
+    typedef map<string, uint64_t> Constants;
+
+    // numbered from 1 like the script, the first line is unused
+    vector<Line> lines;
+    // the tree being optimised, which the new statements are added to
+    SyntaxTree *tree = nullptr;
+
+    bool flatten(SyntaxNode statementList, bool inAutomaton);
+    [[nodiscard]] bool jumpsStayInPlace() const;
+    [[nodiscard]] int lineCount() const {return (int) lines.size() - 1;}
+    [[nodiscard]] vector<int> successors(int line) const;
+    [[nodiscard]] set<int> jumpTargets() const;
+    [[nodiscard]] vector<std::optional<Constants>> propagateConstants() const;
+    bool foldConstants();
+    bool mergeNeighbours();
+    bool threadJumps();
+    bool removeUnreachable();
+    [[nodiscard]] int resolve(int target) const;
+    SyntaxNode rebuild(int first, int last, const vector<int> &renumbered) const;
+public:
+    /**
+     * @brief Adds the optimised script to the tree and makes it its root, the nodes it replaces are left in the tree unused
+     * @return The new root, or the old one if there was nothing to optimise
+     */
+    SyntaxNode optimize(SyntaxTree &syntaxTree);
+};
+
+
+#endif //VOXELFUSION_TASMOPTIMIZER_H
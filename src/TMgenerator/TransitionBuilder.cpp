@@ -0,0 +1,126 @@
+//
+
+#include "TransitionBuilder.h"
+#include "utils/Instrumentation.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+    const string AnySymbol = SYMBOL_ANY;
+    const unsigned int TapeCount = 4;
+
+    // reads the symbol on the tape of its postponed transition and anything on the other tapes
+    struct ExpandedTransition {
+        const PostponedTransition *transition;
+        const string *symbol;
+
+        [[nodiscard]] const string &read(unsigned int tape) const {
+            return tape == (unsigned int) transition->tape ? *symbol : AnySymbol;
+        }
+    };
+
+    // the order of TransitionDomain, without building one
+    bool precedes(const ExpandedTransition &first, const ExpandedTransition &second) {
+        if(first.transition->startState != second.transition->startState) return first.transition->startState < second.transition->startState;
+        for(unsigned int tape = 0; tape < TapeCount; tape++){
+            const int order = first.read(tape).compare(second.read(tape));
+            if(order != 0) return order < 0;
+        }
+        return false;
+    }
+}
+
+TransitionBuilder::TransitionBuilder() {
+    intern({});
+}
+
+uint32_t TransitionBuilder::intern(const set<string> &symbols) {
+    if(symbols.empty() && !symbolSets.empty()) return 0;
+    const auto [found, inserted] = symbolSetIds.try_emplace(symbols, symbolSets.size());
+    if(inserted) symbolSets.push_back(&found->first);
+    return found->second;
+}
+
+void TransitionBuilder::append(TransitionBuilder &other) {
+    for(PostponedTransition &transition : other.postponed){
+        transition.symbolSet = intern(*other.symbolSets[transition.symbolSet]);
+        postponed.push_back(std::move(transition));
+    }
+    other.postponed.clear();
+}
+
+void TransitionBuilder::build(const set<string> &tapeAlphabet, const map<int, StatePointer> &lineStartStates,
+                              map<TransitionDomain, TransitionImage> &transitions, unsigned int threadCount) {
+    INSTRUMENT_SCOPE("expand transitions");
+    // the symbols each transition is expanded over, the difference with the alphabet is only taken once per symbol set
+    vector<vector<const string*>> leftOutSymbols(symbolSets.size()), onlyTheseSymbols(symbolSets.size());
+    vector<bool> expandedLeftOut(symbolSets.size()), expandedOnlyThese(symbolSets.size());
+    vector<size_t> offsets{0};
+    for(PostponedTransition &transition : postponed){
+        if(transition.startState == nullptr) transition.startState = lineStartStates.at(transition.startLine);
+        if(transition.endState == nullptr) transition.endState = lineStartStates.at(transition.endLine);
+        const set<string> &symbols = *symbolSets[transition.symbolSet];
+        vector<const string*> &relevant = (transition.onlyTheseSymbols ? onlyTheseSymbols : leftOutSymbols)[transition.symbolSet];
+        vector<bool>::reference expanded = (transition.onlyTheseSymbols ? expandedOnlyThese : expandedLeftOut)[transition.symbolSet];
+        if(!expanded){
+            for(const string &symbol : transition.onlyTheseSymbols ? symbols : tapeAlphabet){
+                if(transition.onlyTheseSymbols || !symbols.count(symbol)) relevant.push_back(&symbol);
+            }
+            expanded = true;
+        }
+        offsets.push_back(offsets.back() + relevant.size());
+    }
+
+    // every thread expands and sorts a consecutive part of one array, the parts are merged in order
+    vector<ExpandedTransition> expanded(offsets.back());
+    const size_t partCount = std::min<size_t>(std::max(threadCount, 1u), std::max<size_t>(postponed.size(), 1));
+    const auto partStart = [&](size_t part){return part * postponed.size() / partCount;};
+    const auto expandPart = [&](size_t part){
+        for(size_t i = partStart(part); i < partStart(part + 1); i++){
+            const PostponedTransition &transition = postponed[i];
+            const vector<const string*> &relevant = (transition.onlyTheseSymbols ? onlyTheseSymbols : leftOutSymbols)[transition.symbolSet];
+            for(size_t j = 0; j < relevant.size(); j++) expanded[offsets[i] + j] = {&transition, relevant[j]};
+        }
+        std::stable_sort(expanded.begin() + offsets[partStart(part)], expanded.begin() + offsets[partStart(part + 1)], precedes);
+    };
+    vector<std::thread> workers;
+    for(size_t part = 1; part < partCount; part++) workers.emplace_back(expandPart, part);
+    expandPart(0);
+    for(std::thread &worker : workers) worker.join();
+    for(size_t part = 1; part < partCount; part++){
+        std::inplace_merge(expanded.begin(), expanded.begin() + offsets[partStart(part)],
+                           expanded.begin() + offsets[partStart(part + 1)], precedes);
+    }
+    // stable throughout, so the transition that was added first is the one kept
+    expanded.erase(std::unique(expanded.begin(), expanded.end(), [](const ExpandedTransition &first, const ExpandedTransition &second){
+        return !precedes(first, second) && !precedes(second, first);
+    }), expanded.end());
+
+    auto hint = transitions.begin();
+    for(const ExpandedTransition &expandedTransition : expanded){
+        const PostponedTransition &transition = *expandedTransition.transition;
+        vector<string> replacedSymbols(TapeCount, AnySymbol);
+        vector<string> replacementSymbols(TapeCount, AnySymbol);
+        replacedSymbols[transition.tape] = *expandedTransition.symbol;
+        replacementSymbols[transition.tape] = transition.toWrite.empty() ? *expandedTransition.symbol : transition.toWrite;
+        hint = std::next(transitions.emplace_hint(hint, TransitionDomain(transition.startState, replacedSymbols),
+                                                  TransitionImage(transition.endState, replacementSymbols,
+                                                                  vector<TMTapeDirection>(transition.directions.begin(), transition.directions.end()))));
+    }
+
+    postponed.clear();
+    postponed.shrink_to_fit();
+}
+
+PostponedTransition::PostponedTransition(const StatePointer& start, const StatePointer& end, uint32_t symbolSet, bool onlyTheseSymbols)
+: startState(start), endState(end), startLine(0), endLine(0), symbolSet(symbolSet), onlyTheseSymbols(onlyTheseSymbols) {}
+
+PostponedTransition::PostponedTransition(const StatePointer &startState, int endLine, uint32_t symbolSet, bool onlyTheseSymbols)
+: startState(startState), endState(nullptr), startLine(0), endLine(endLine), symbolSet(symbolSet), onlyTheseSymbols(onlyTheseSymbols)  {}
+
+PostponedTransition::PostponedTransition(int startLine, const StatePointer &endState, uint32_t symbolSet, bool onlyTheseSymbols)
+: startState(nullptr), endState(endState), startLine(startLine), endLine(0), symbolSet(symbolSet), onlyTheseSymbols(onlyTheseSymbols)  {}
+
+PostponedTransition::PostponedTransition(int startLine, int endLine, uint32_t symbolSet, bool onlyTheseSymbols)
+: startState(nullptr), endState(nullptr), startLine(startLine), endLine(endLine), symbolSet(symbolSet), onlyTheseSymbols(onlyTheseSymbols)  {}
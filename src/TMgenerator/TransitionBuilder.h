@@ -0,0 +1,72 @@
+//
+
+#ifndef VOXELFUSION_TRANSITIONBUILDER_H
+#define VOXELFUSION_TRANSITIONBUILDER_H
+
+#include "../MTMDTuringMachine/FiniteControl.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+
+using std::set, std::string, std::map, std::vector;
+
+struct PostponedTransition{
+    PostponedTransition(const StatePointer& start, const StatePointer& end, uint32_t symbolSet, bool onlyTheseSymbols);
+    PostponedTransition(const StatePointer &startState, int endLine, uint32_t symbolSet, bool onlyTheseSymbols);
+    PostponedTransition(int startLine, const StatePointer &endState, uint32_t symbolSet, bool onlyTheseSymbols);
+    PostponedTransition(int startLine, int endLine, uint32_t symbolSet, bool onlyTheseSymbols);
+
+    StatePointer startState;
+    StatePointer endState;
+    int startLine;
+    int endLine;
+    // the left out symbols (or the only symbols), interned by the builder that holds the transition
+    uint32_t symbolSet;
+    bool onlyTheseSymbols;
+    int tape = 0;
+    string toWrite;
+    std::array<TMTapeDirection, 4> directions = {TMTapeDirection::Stationary, TMTapeDirection::Stationary, TMTapeDirection::Stationary, TMTapeDirection::Stationary};
+};
+
+/**
+ * @brief Collects the transitions that can only be expanded once the whole tape alphabet and every line start state is known.
+ * The transitions live in a deque, so references handed out stay valid while more are added, and identical symbol sets are stored once.
+ * Expansion writes compact records that are sorted and deduplicated before any domain or image is built,
+ * the first transition added for a domain wins (as do transitions that were already in the finite control)
+ */
+class TransitionBuilder {
+    std::deque<PostponedTransition> postponed;
+    // the sets are the keys of symbolSetIds, the empty set is always 0
+    map<set<string>, uint32_t> symbolSetIds;
+    vector<const set<string>*> symbolSets;
+
+    uint32_t intern(const set<string> &symbols);
+public:
+    TransitionBuilder();
+
+    template<class Start, class End>
+    PostponedTransition& emplace_back(const Start &start, const End &end, const set<string> &symbols = {}, bool onlyTheseSymbols = false){
+        return postponed.emplace_back(start, end, intern(symbols), onlyTheseSymbols);
+    }
+    PostponedTransition& back() {return postponed.back();}
+    std::deque<PostponedTransition>::iterator begin() {return postponed.begin();}
+    std::deque<PostponedTransition>::iterator end() {return postponed.end();}
+    [[nodiscard]] size_t size() const {return postponed.size();}
+
+    /**
+     * @brief Moves every transition of another builder to the back of this one
+     */
+    void append(TransitionBuilder &other);
+
+    /**
+     * @brief Expands every transition into the finite control (on threadCount threads) and empties the builder
+     */
+    void build(const set<string> &tapeAlphabet, const map<int, StatePointer> &lineStartStates,
+               map<TransitionDomain, TransitionImage> &transitions, unsigned int threadCount);
+};
+
+
+#endif //VOXELFUSION_TRANSITIONBUILDER_H
@@ -1,15 +1,16 @@
 #include "Visualisation.h"
-#include "../MTMDTuringMachine/TMTapeUtils.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <thread>
 #include <iostream>
 #include "LR1Parser/LALR1Parser/LALR1Parser.h"
 #include "Lexer/Lexer.h"
+#include "Lexer/SourceFile.h"
 #include "string"
 #include "TMgenerator/TMGenerator.h"
 #include "MTMDTuringMachine/MTMDTuringMachine.h"
 #include "utils.h"
+#include "Instrumentation.h"
 
 #define SCREEN_WIDTH 1600
 #define SCREEN_HEIGHT 800
@@ -75,61 +76,46 @@ FOV(fov), nearPlane(nearPlane), farPlane(farPlane), colorMap(colorMap) {
 }
 
 void Visualisation::runTM() {
-    assert(tmRunning == false && tape != nullptr);
-    tmRunning = true;
-    cachedTMRunning = true;
-    // Step 1: read tasm code
-    string code;
-    string line;
-    ifstream input (selectedTasmPath);
-    if (input.is_open())
-    {
-        while ( getline (input, line) )
-        {
-            code += line;
-        }
-        input.close();
+    assert(!compiling.valid() && !execution && tape != nullptr);
+    // take the parse table built into the binary, unless another one is given, the first time a script is compiled
+    if(!compiler){
+        auto parser = make_shared<LALR1Parser>(CompiledParseTable::tasm());
+        if(!parseTablePath.empty()) parser->importTable(parseTablePath);
+        compiler = make_unique<const CompileService>(parser, set<string>{"B"}, true, true, true, true, true);
     }
-    // Step 2: get the lexicon of the code
-    Lexer lexer(code);
-    lexer.print();
-    // Step 3: parse the code
-// Step 3.3: import parse table
-    LALR1Parser parser;
-    parser.importTable("parsingTable.json");
-    // Step 3.4: parse the table
-    const shared_ptr<STNode>& root = parser.parse(lexer.getTokenizedInput());
-    // Step 4: Create and assemble all tapes
-    auto *varTape {new TMTape1D()};
-    auto *tempVarTape {new TMTape1D()};
-    auto *historyTape {new TMTape3D()};
-    auto tapes = make_tuple(tape.get(), varTape, tempVarTape, historyTape);
-    set<string> tapeAlphabet = {"B"};
-    set<StatePointer> states;
-    map<TransitionDomain, TransitionImage> transitions;
-    // Step 4.2: put tasm on the tapes
-    TMGenerator generator{tapeAlphabet, transitions, states, true};
-    generator.assembleTasm(root);
-    FiniteControl control(states, transitions);
-    MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D> tm(tapeAlphabet, tapeAlphabet, tapes, control, updateVisualisation);
-
-    transitionsMadeLast = 0;
-    int currentTransitionsMade = 0;
-    while(!tm.isHalted){
-        tm.doTransition();
-        currentTransitionsMade++;
-#ifdef ALLOW_TM_PREEMPTION // this slows down very large TASM scripts because of mutex locking and unlocking
-        if(currentTransitionsMade % 50 == 0){
-            if(!tmRunning) break;
+    compiling = std::async(std::launch::async, &Visualisation::compileTM, this, selectedTasmPath);
+}
+
+CompiledProgram Visualisation::compileTM(const string &path) const {
+    // Step 1: map the tasm code
+    const SourceFile code(path);
+    // Step 2: reuse the finite control generated by an earlier run of the same code
+    CompiledProgram program{{"B"}};
+    const CompiledProgramCache cache;
+    const uint64_t cacheKey = compiler->cacheKey(code.getContents());
+    if(!cache.load(cacheKey, program.tapeAlphabet, program.states, program.transitions)){
+        // Step 3: lex, parse and simplify the code, and put tasm on the tapes
+        program = compiler->compile(code.getContents());
+        cache.store(cacheKey, program.tapeAlphabet, program.states, program.transitions);
+    }
+    return program;
+}
+
+void Visualisation::advanceTM() {
+    if(compiling.valid() && compiling.wait_for(std::chrono::seconds(0)) == std::future_status::ready){
+        // Step 4: create the other tapes and the machine, the first time it is compiled
+        try{
+            const CompiledProgram program = compiling.get();
+            execution = make_unique<TMExecution>(program.tapeAlphabet, program.states, program.transitions, *tape, updateVisualisation);
+            transitionsMadeLast = 0;
+        }catch(const std::exception &exception){
+            cerr << "Cannot run " << selectedTasmPath << ": " << exception.what() << endl;
         }
-#endif
     }
-    transitionsMadeLast = currentTransitionsMade;
-    delete varTape;
-    delete tempVarTape;
-    delete historyTape;
-    tmRunning = false;
-    cachedTMRunning = false;
+    if(!execution) return;
+    // Step 5: run it for part of the frame, the rest is left for drawing
+    execution->runFor(std::chrono::milliseconds(simulationMilliseconds));
+    if(execution->isHalted()) stopTM();
 }
 
 bool Visualisation::update() {
@@ -140,6 +126,7 @@ bool Visualisation::update() {
     //execute said command
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    advanceTM();
     if (updateFlag){
         updateFlag = false;
         if (tape == nullptr) {
@@ -176,12 +163,25 @@ void Visualisation::imguiDrawAndHandleFrame() {
         ImGui::Text("Loading OBJ...");
     }
 
-    if(cachedTMRunning){
-        ImGui::Text("Running TASM...");
+    if(compiling.valid()){
+        ImGui::Text("Compiling TASM...");
     }
-    if(transitionsMadeLast > 0){
-        ImGui::Text("Transitions made in last TM run: %d", transitionsMadeLast);
+    if(execution){
+        ImGui::Text("%s TASM, %llu transitions made", execution->isPaused() ? "Paused" : "Running",
+                    (unsigned long long) execution->getStepCount());
+        if(ImGui::Button(execution->isPaused() ? "Resume" : "Pause")){
+            if(execution->isPaused()) execution->resume();
+            else execution->pause();
+        }
+        ImGui::SameLine();
+        if(ImGui::Button("Step")) execution->step();
+        ImGui::SameLine();
+        if(ImGui::Button("Cancel")) stopTM();
+    }
+    else if(transitionsMadeLast > 0){
+        ImGui::Text("Transitions made in last TM run: %llu", (unsigned long long) transitionsMadeLast);
     }
+    ImGui::SliderInt("Simulation ms per frame", &simulationMilliseconds, 1, 15);
     if (ImGui::TreeNode("Import model"))
     {
         ImGui::BeginChild("Pick a model");
@@ -189,7 +189,7 @@ void Visualisation::imguiDrawAndHandleFrame() {
             if (ImGui::Selectable(objPaths[i].c_str(), objPathsSelected[i], ImGuiSelectableFlags_AllowDoubleClick))
                 if (ImGui::IsMouseDoubleClicked(0)) {
                     selectedObjPath = objPaths[i];
-                    killAndWaitForTMworker();
+                    stopTM();
                     killAndWaitForOBJloader();
                     if(tape == nullptr) tape = make_unique<TMTape3D>();
                     objLoader = make_unique<thread>([this]{
@@ -214,10 +214,8 @@ void Visualisation::imguiDrawAndHandleFrame() {
                     selectedTasmPath = tasmPaths[i];
                     if (tape == nullptr) tape = make_unique<TMTape3D>();
                     killAndWaitForOBJloader();
-                    killAndWaitForTMworker();
-                    TMworker = make_unique<thread>([this]{
-                        runTM();
-                    });
+                    stopTM();
+                    runTM();
                     cout << "Picked a script to run" << endl;
                 }
         }
@@ -230,7 +228,7 @@ void Visualisation::imguiDrawAndHandleFrame() {
             if (tape == nullptr) tape = make_unique<TMTape3D>();
             cout << "H20 Button pressed" << endl;
             killAndWaitForOBJloader();
-            killAndWaitForTMworker();
+            stopTM();
             std::string resultedTasm = utils::getWaterScriptForTape(*tape);
             std::string savedTasm = "tasm-for-water.tasm";
             // Save tasm
@@ -245,15 +243,13 @@ void Visualisation::imguiDrawAndHandleFrame() {
                 std::cerr << "Unable to open water file " << savedTasm << std::endl;
             }
             selectedTasmPath = savedTasm;
-            TMworker = make_unique<thread>([this]{
-                runTM();
-            });
+            runTM();
         }
         if (ImGui::Button("Boom")){
             if (tape == nullptr) tape = make_unique<TMTape3D>();
             cout << "Boom Button pressed" << endl;
             killAndWaitForOBJloader();
-            killAndWaitForTMworker();
+            stopTM();
             std::string resultedTasm = utils::getBoomScriptForTape(*tape);
             std::string savedTasm = "tasm-for-boom.tasm";
             // Save tasm
@@ -268,9 +264,7 @@ void Visualisation::imguiDrawAndHandleFrame() {
                 std::cerr << "Unable to open boom file " << savedTasm << std::endl;
             }
             selectedTasmPath = savedTasm;
-            TMworker = make_unique<thread>([this]{
-                runTM();
-            });
+            runTM();
         }
         ImGui::TreePop();
     }
@@ -311,7 +305,7 @@ void Visualisation::imguiDrawAndHandleFrame() {
             rebuild(tape.get());
         }
         if (ImGui::Button("save tape to JSON")){
-            killAndWaitForTMworker();
+            // a running script only changes the tape between frames, so it can keep running
             killAndWaitForOBJloader();
             utils::save3DTapeToJson(*tape, "tape.json");
         }
@@ -343,7 +337,7 @@ void Visualisation::imguiDrawAndHandleFrame() {
 }
 
 void Visualisation::resetTape() {
-    killAndWaitForTMworker();
+    stopTM();
     killAndWaitForOBJloader();
     tape = nullptr;
 }
@@ -355,32 +349,12 @@ void Visualisation::imguiBeginFrame() const {
 }
 
 void Visualisation::rebuild(TMTape3D *tape) {
+    INSTRUMENT_SCOPE("rebuild");
     //https://stackoverflow.com/questions/15821969/what-is-the-proper-way-to-modify-opengl-vertex-buffer
-    vertices.clear();
-    indices.clear();
-
-    if(tape){
-        TMTapeUtils::expansionMutex.lock();
-        const int greatest3DSize = tape->getCells().size();
-        const int greatest2DSize = TMTapeUtils::getGreatestSize(tape->getCells());
-        const long greatestSize = TMTapeUtils::getGreatestSize(tape->at(0).cells);
-        TMTapeUtils::expansionMutex.unlock();
-        for (int x= -tape->zeroAnchor; x < greatest3DSize; x++) {
-            for(int y= -tape->at(x).zeroAnchor; y < greatest2DSize; y++) {
-                for(int z= -tape->at(x).at(y).zeroAnchor; z < greatestSize; z++) {
-                    TMTapeUtils::expansionMutex.lock();
-                    string symbol = tape->at(x).at(y).at(z).symbol;
-                    TMTapeUtils::expansionMutex.unlock();
-                    if(symbol != "B" && symbol != "BB"){
-                        auto it = colorMap.find(symbol);
-                        if(it == colorMap.end()){
-                            it = colorMap.find("default");
-                        }
-                        VisualisationHelper::createCube(vertices, indices, x, y, z, 1, it->second);
-                    }
-                }
-            }
-        }
+    if(tape) VisualisationHelper::buildMesh(*tape, colorMap, vertices, indices);
+    else {
+        vertices.clear();
+        indices.clear();
     }
 
     if(!VAO){ //first time
@@ -408,7 +382,7 @@ void Visualisation::rebuild(TMTape3D *tape) {
 
 Visualisation::~Visualisation() {
 
-    killAndWaitForTMworker();
+    stopTM();
     killAndWaitForOBJloader();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -430,10 +404,15 @@ void Visualisation::run() {
     while(update());
 }
 
-void Visualisation::killAndWaitForTMworker() {
-    tmRunning = false;
-    if(TMworker) TMworker->join();
-    TMworker = nullptr;
+void Visualisation::stopTM() {
+    // compiling cannot be interrupted, so it is waited for
+    if(compiling.valid()) compiling.wait();
+    compiling = {};
+    if(!execution) return;
+    transitionsMadeLast = execution->getStepCount();
+    INSTRUMENT_COUNTER("steps", execution->getStepCount());
+    INSTRUMENT_COUNTER("tape cells", execution->getCellCount());
+    execution = nullptr;
 }
 
 void Visualisation::killAndWaitForOBJloader() {
@@ -449,5 +428,3 @@ void Visualisation::framebuffer_size_callback(GLFWwindow *window, int width, int
         camera->height = height;
     }
 }
-
-Color::Color(float r, float g, float b, float a) : r(r), g(g), b(b), a(a) {}
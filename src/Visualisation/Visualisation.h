@@ -9,6 +9,7 @@
 #include <cmath>
 #include <thread>
 #include <memory>
+#include <future>
 #include <map>
 #include "imgui.h"
 
@@ -24,7 +25,10 @@
 
 #include "MTMDTuringMachine/TMTape.h"
 #include "TMgenerator/TMGenerator.h"
+#include "TMgenerator/CompiledProgramCache.h"
+#include "TMgenerator/CompileService.h"
 #include "MTMDTuringMachine/MTMDTuringMachine.h"
+#include "MTMDTuringMachine/TMExecution.h"
 #include "LR1Parser/LALR1Parser/LALR1Parser.h"
 using namespace std;
 
@@ -45,7 +49,10 @@ class Visualisation {
     ImVec4 sunColor{1.0f, 1.0f, 1.0f, 1.0f};
     ImVec4 backgroundColor{0.07f, 0.13f, 0.17f, 1.0f};
     unique_ptr<TMTape3D> tape;
-    unique_ptr<thread> TMworker;
+    // the script that is compiled on another thread, then run here a few milliseconds every frame
+    std::future<CompiledProgram> compiling;
+    unique_ptr<TMExecution> execution;
+    int simulationMilliseconds = 8;
     unique_ptr<thread> objLoader;
     const string tasmBasePath = "tasm/";
     const string objBasePath = "objs/";
@@ -55,14 +62,16 @@ class Visualisation {
     vector<bool> objPathsSelected;
     string selectedTasmPath;
     string selectedObjPath;
-    int transitionsMadeLast = 0;
-    bool cachedTMRunning = false;
+    uint64_t transitionsMadeLast = 0;
+    // made on the first run, once parseTablePath is known
+    unique_ptr<const CompileService> compiler;
 
-    inline static std::atomic<bool> tmRunning = false;
     inline static std::atomic<bool> objLoaderRunning = false;
 public:
     inline static unique_ptr<Camera> camera;
     inline static std::atomic<bool> updateFlag = false;
+    // when not empty, scripts are parsed with the table in this JSON file instead of the one built into the binary
+    string parseTablePath;
     Visualisation(float fov, float nearPlane, float farPlane, map<string, Color>& colorMap);
     bool update();
     void rebuild(TMTape3D *tape);
@@ -70,10 +79,21 @@ public:
     ~Visualisation();
     void imguiBeginFrame() const;
     void imguiDrawAndHandleFrame();
-    void killAndWaitForTMworker();
+    /**
+     * @brief Waits for the script that is compiling, and throws away the script that runs
+     */
+    void stopTM();
     void killAndWaitForOBJloader();
 
+    /**
+     * @brief Starts compiling the selected script, it runs once it is compiled
+     */
     void runTM();
+    CompiledProgram compileTM(const string &path) const;
+    /**
+     * @brief Starts the compiled script and runs it for this frame
+     */
+    void advanceTM();
 
     void resetTape();
     static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
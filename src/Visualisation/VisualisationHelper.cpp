@@ -1,7 +1,10 @@
 #include <fstream>
 #include "VisualisationHelper.h"
+#include "MTMDTuringMachine/TMTapeUtils.h"
 
-vector<GLfloat> baseVertices = {
+Color::Color(float r, float g, float b, float a) : r(r), g(g), b(b), a(a) {}
+
+vector<float> baseVertices = {
         0, 0, 0,    0, -1, 0, //face 0
         1, 0, 0,    0, -1, 0,
         1, 0, 1,    0, -1, 0,
@@ -28,7 +31,7 @@ vector<GLfloat> baseVertices = {
         1, 1, 0,    0, 0, -1
 };
 
-vector<GLuint> baseIndices = {
+vector<unsigned int> baseIndices = {
         0, 1, 2,
         0, 2, 3,
         4, 5, 6,
@@ -43,7 +46,7 @@ vector<GLuint> baseIndices = {
         20, 22, 23
 };
 
-void VisualisationHelper::createCube(vector<GLfloat> &vertices, vector<GLuint> &indices, int x, int y, int z, float scale, const Color &color) {
+void VisualisationHelper::createCube(vector<float> &vertices, vector<unsigned int> &indices, int x, int y, int z, float scale, const Color &color) {
     int startingIndex = vertices.size()/10;
     for(unsigned int i = 0; i < baseVertices.size(); i += 6)
     {
@@ -63,7 +66,32 @@ void VisualisationHelper::createCube(vector<GLfloat> &vertices, vector<GLuint> &
         indices.push_back(startingIndex + baseIndices[i]);
     }
 }
-void VisualisationHelper::exportMesh(vector<GLfloat> &vertices, vector<GLuint> &indices, const string &filename) {
+void VisualisationHelper::buildMesh(const TMTape3D &tape, const map<string, Color> &colorMap, vector<float> &vertices, vector<unsigned int> &indices) {
+    vertices.clear();
+    indices.clear();
+    TMTapeUtils::expansionMutex.lock();
+    const int greatest3DSize = tape.getCells().size();
+    const int greatest2DSize = TMTapeUtils::getGreatestSize(tape.getCells());
+    const long greatestSize = TMTapeUtils::getGreatestSize(tape.at(0).cells);
+    TMTapeUtils::expansionMutex.unlock();
+    for (int x= -tape.zeroAnchor; x < greatest3DSize; x++) {
+        for(int y= -tape.at(x).zeroAnchor; y < greatest2DSize; y++) {
+            for(int z= -tape.at(x).at(y).zeroAnchor; z < greatestSize; z++) {
+                TMTapeUtils::expansionMutex.lock();
+                string symbol = tape.at(x).at(y).at(z).symbol;
+                TMTapeUtils::expansionMutex.unlock();
+                if(symbol != "B" && symbol != "BB"){
+                    auto it = colorMap.find(symbol);
+                    if(it == colorMap.end()){
+                        it = colorMap.find("default");
+                    }
+                    createCube(vertices, indices, x, y, z, 1, it->second);
+                }
+            }
+        }
+    }
+}
+void VisualisationHelper::exportMesh(vector<float> &vertices, vector<unsigned int> &indices, const string &filename) {
     ofstream objFile;
     objFile.open (filename);
 
@@ -2,8 +2,9 @@
 #define VOXELFUSION_VISUALISATIONHELPER_H
 
 #include <vector>
-#include <GLFW/glfw3.h>
+#include <map>
 #include <string>
+#include "MTMDTuringMachine/TMTape.h"
 
 using namespace std;
 
@@ -16,9 +17,14 @@ struct Color{
     Color(float r, float g, float b, float a);
 };
 
+// the vertices and indices are built on the CPU without OpenGL, so they can also be made and measured without a window
 struct VisualisationHelper {
-    static void createCube(vector<GLfloat> &vertices, vector<GLuint> &indices, int x, int y, int z, float scale, const Color &color);
-    static void exportMesh(vector<GLfloat> &vertices, vector<GLuint> &indices, const string &filename);
+    static void createCube(vector<float> &vertices, vector<unsigned int> &indices, int x, int y, int z, float scale, const Color &color);
+    /**
+     * @brief Replaces the vertices and indices with a cube for every cell of the tape that is not blank, in the color of its symbol
+     */
+    static void buildMesh(const TMTape3D &tape, const map<string, Color> &colorMap, vector<float> &vertices, vector<unsigned int> &indices);
+    static void exportMesh(vector<float> &vertices, vector<unsigned int> &indices, const string &filename);
 };
 
 
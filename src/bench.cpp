@@ -0,0 +1,389 @@
+#include "LR1Parser/LALR1Parser/LALR1Parser.h"
+#include "Lexer/Lexer.h"
+#include "Lexer/SourceFile.h"
+#include "MTMDTuringMachine/MTMDTuringMachine.h"
+#include "TMgenerator/TMGenerator.h"
+#include "TMgenerator/TasmOptimizer.h"
+#include "Visualisation/VisualisationHelper.h"
+#include "utils.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using json = nlohmann::json;
+
+namespace {
+    const char *const Usage = "usage: voxelfusion_bench [--filter <text>] [--repetitions <count>] [--output <results.json>]";
+
+    struct Options {
+        std::string filter;
+        unsigned int repetitions = 5;
+        std::string outputPath;
+    };
+
+    Options parseOptions(int argc, char **argv) {
+        Options options;
+        for(int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            const auto value = [&]() -> std::string {
+                if(++i >= argc) throw std::invalid_argument("Missing value for " + argument);
+                return argv[i];
+            };
+            if(argument == "--filter") options.filter = value();
+            else if(argument == "--repetitions") options.repetitions = std::stoul(value());
+            else if(argument == "--output") options.outputPath = value();
+            else throw std::invalid_argument("Unexpected argument " + argument);
+        }
+        if(options.repetitions == 0) throw std::invalid_argument("At least one repetition is needed");
+        return options;
+    }
+
+    // results are added to it so the compiler cannot leave out the work that is measured
+    std::atomic<size_t> sink = 0;
+
+    template<class Function>
+    double timed(Function &&function) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct Prepared {
+        // the number of units one run handles
+        double items;
+        // runs the benchmark once and returns the seconds taken by the part that is measured
+        std::function<double()> run;
+    };
+    struct Benchmark {
+        std::string name;
+        std::string unit;
+        // loads and builds everything the benchmark needs, only for the benchmarks that are run
+        std::function<Prepared()> prepare;
+    };
+
+    std::vector<std::string> scriptPaths() {
+        std::vector<std::string> paths;
+        for(const auto &entry : std::filesystem::directory_iterator("tasm")) {
+            if(entry.path().extension() == ".tasm") paths.push_back(entry.path().string());
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+    std::vector<std::string> readScripts(const std::vector<std::string> &paths = scriptPaths()) {
+        std::vector<std::string> scripts;
+        for(const std::string &path : paths) scripts.emplace_back(SourceFile(path).getContents());
+        return scripts;
+    }
+
+    // the syntax trees of the scripts that parse and generate, templates and unfinished scripts are left out
+    std::shared_ptr<std::deque<SyntaxTree>> parseScripts(const std::vector<std::string> &paths, bool optimizeSyntaxTree) {
+        const LALR1Parser parser(CompiledParseTable::tasm());
+        auto trees = std::make_shared<std::deque<SyntaxTree>>();
+        for(const std::string &script : readScripts(paths)) {
+            try {
+                TokenStream tokens(script);
+                SyntaxTree tree = parser.parse(tokens);
+                if(optimizeSyntaxTree) TasmOptimizer().optimize(tree);
+                set<string> tapeAlphabet{"B"};
+                map<TransitionDomain, TransitionImage> transitions;
+                set<StatePointer> states;
+                TMGenerator(tapeAlphabet, transitions, states).assembleTasm(tree.getRoot());
+                trees->push_back(std::move(tree));
+            }
+            catch(const std::exception &) {}
+        }
+        return trees;
+    }
+
+    Prepared generate(const std::vector<std::string> &paths, bool optimize) {
+        const std::shared_ptr<std::deque<SyntaxTree>> trees = parseScripts(paths, optimize);
+        return {(double) trees->size(), [trees, optimize]() {
+            return timed([&]() {
+                for(const SyntaxTree &tree : *trees) {
+                    set<string> tapeAlphabet{"B"};
+                    map<TransitionDomain, TransitionImage> transitions;
+                    set<StatePointer> states;
+                    TMGenerator generator{tapeAlphabet, transitions, states, false, optimize, optimize, optimize};
+                    generator.assembleTasm(tree.getRoot());
+                    sink += transitions.size();
+                }
+            });
+        }};
+    }
+    // the largest script with the options of voxelfusion-run but the finite control optimiser, which runs on one thread
+    Prepared generateOnThreads(unsigned int threadCount) {
+        const std::shared_ptr<std::deque<SyntaxTree>> trees = parseScripts({"tasm/terrain-generation.tasm"}, true);
+        return {(double) trees->size(), [trees, threadCount]() {
+            return timed([&]() {
+                for(const SyntaxTree &tree : *trees) {
+                    set<string> tapeAlphabet{"B"};
+                    map<TransitionDomain, TransitionImage> transitions;
+                    set<StatePointer> states;
+                    TMGenerator generator{tapeAlphabet, transitions, states, false, false, true, true, threadCount};
+                    generator.assembleTasm(tree.getRoot());
+                    sink += transitions.size();
+                }
+            });
+        }};
+    }
+
+    /**
+     * @brief A machine that walks its head between two walls on the first tape forever, turning every cell from A to C on the way
+     * forwards and back on the way backwards, while reading and writing anything on the other tapes
+     */
+    FiniteControl bounceControl(TMTapeDirection forwards, TMTapeDirection backwards, unsigned int tapeCount) {
+        const StatePointer forwardsState = std::make_shared<const State>("forwards", true);
+        const StatePointer backwardsState = std::make_shared<const State>("backwards");
+        const auto symbols = [&](const std::string &first) {
+            std::vector<std::string> symbols(tapeCount, SYMBOL_ANY);
+            symbols[0] = first;
+            return symbols;
+        };
+        const auto directions = [&](TMTapeDirection first) {
+            std::vector<TMTapeDirection> directions(tapeCount, Stationary);
+            directions[0] = first;
+            return directions;
+        };
+        return FiniteControl({forwardsState, backwardsState}, {
+                {TransitionDomain(forwardsState, symbols("A")), TransitionImage(forwardsState, symbols("C"), directions(forwards))},
+                {TransitionDomain(forwardsState, symbols("W")), TransitionImage(backwardsState, symbols("W"), directions(backwards))},
+                {TransitionDomain(backwardsState, symbols("C")), TransitionImage(backwardsState, symbols("A"), directions(backwards))},
+                {TransitionDomain(backwardsState, symbols("W")), TransitionImage(forwardsState, symbols("W"), directions(forwards))}
+        });
+    }
+    // puts a wall, length cells with A and another wall on the tape, and leaves the head on the first A
+    void fillTrack(TMTape &tape, TMTapeDirection forwards, TMTapeDirection backwards, unsigned int length) {
+        tape.replaceCurrentSymbol("W");
+        for(unsigned int i = 0; i < length; i++) {
+            tape.moveTapeHead(forwards);
+            tape.replaceCurrentSymbol("A");
+        }
+        tape.moveTapeHead(forwards);
+        tape.replaceCurrentSymbol("W");
+        for(unsigned int i = 0; i < length; i++) tape.moveTapeHead(backwards);
+    }
+
+    template<class ...TMTapeType>
+    Prepared bounce(TMTapeDirection forwards, TMTapeDirection backwards, unsigned int length, unsigned int steps) {
+        const auto control = std::make_shared<const FiniteControl>(bounceControl(forwards, backwards, sizeof...(TMTapeType)));
+        return {(double) steps, [=]() {
+            std::tuple<std::unique_ptr<TMTapeType>...> tapes{std::make_unique<TMTapeType>()...};
+            fillTrack(*std::get<0>(tapes), forwards, backwards, length);
+            MTMDTuringMachine<TMTapeType...> tm({}, {}, std::apply([](auto &... tape) {return std::make_tuple(tape.get()...);}, tapes),
+                                                *control);
+            return timed([&]() {
+                for(unsigned int step = 0; step < steps; step++) tm.doTransition();
+                sink += tm.isHalted;
+            });
+        }};
+    }
+
+    // a cube of side cells filled with symbols, so every cell has been allocated
+    std::shared_ptr<TMTape3D> filledTape(int side) {
+        auto tape = std::make_shared<TMTape3D>();
+        for(int x = 0; x < side; x++) {
+            for(int y = 0; y < side; y++) {
+                for(int z = 0; z < side; z++) (*tape)[x][y][z].symbol = (x + y + z) % 2 ? "A" : "C";
+            }
+        }
+        return tape;
+    }
+
+    Prepared voxelise(const std::string &path, double voxelSize) {
+        auto mesh = std::make_shared<Mesh>();
+        utils::load_obj2(path, *mesh);
+        return {(double) mesh->faces.size(), [mesh, voxelSize]() {
+            VoxelSpace space;
+            return timed([&]() {
+                utils::voxelise(*mesh, space, voxelSize);
+                sink += space.size();
+            });
+        }};
+    }
+
+    // the scripts are small, so they are lexed and parsed this many times per run to take much longer than the clock resolution
+    const unsigned int ScriptRounds = 100;
+    const unsigned int TerrainWidth = 128, TerrainLength = 128, TerrainHeight = 32;
+
+    std::vector<Benchmark> benchmarks() {
+        return {
+                {"lex tasm/", "bytes", []() -> Prepared {
+                    // the templates have placeholders that are not tokens until they are filled in
+                    const auto scripts = std::make_shared<std::vector<std::string>>(readScripts());
+                    std::erase_if(*scripts, [](const std::string &script) {
+                        try {
+                            (void) Lexer(script);
+                            return false;
+                        }
+                        catch(const std::invalid_argument &) {
+                            return true;
+                        }
+                    });
+                    double bytes = 0;
+                    for(const std::string &script : *scripts) bytes += script.size();
+                    return {bytes * ScriptRounds, [scripts]() {
+                        return timed([&]() {
+                            for(unsigned int round = 0; round < ScriptRounds; round++) {
+                                for(const std::string &script : *scripts) sink += Lexer(script).getTokenizedInput().size();
+                            }
+                        });
+                    }};
+                }},
+                {"parse tasm/", "tokens", []() -> Prepared {
+                    const auto parser = std::make_shared<const LALR1Parser>(CompiledParseTable::tasm());
+                    const auto inputs = std::make_shared<std::vector<std::vector<Token>>>();
+                    double tokens = 0;
+                    for(const std::string &script : readScripts()) {
+                        try {
+                            std::vector<Token> input = Lexer(script).getTokenizedInput();
+                            parser->parse(input);
+                            tokens += input.size();
+                            inputs->push_back(std::move(input));
+                        }
+                        catch(const std::exception &) {}
+                    }
+                    return {tokens * ScriptRounds, [parser, inputs]() {
+                        return timed([&]() {
+                            for(unsigned int round = 0; round < ScriptRounds; round++) {
+                                for(const std::vector<Token> &input : *inputs) sink += parser->parse(input).size();
+                            }
+                        });
+                    }};
+                }},
+                {"assembleTasm tasm/", "scripts", []() {return generate(scriptPaths(), false);}},
+                {"assembleTasm optimised", "scripts", []() {return generate(scriptPaths(), true);}},
+                {"assembleTasm terrain-generation 1 thread", "scripts", []() {return generateOnThreads(1);}},
+                {"assembleTasm terrain-generation 2 threads", "scripts", []() {return generateOnThreads(2);}},
+                {"assembleTasm terrain-generation 4 threads", "scripts", []() {return generateOnThreads(4);}},
+                {"assembleTasm terrain-generation 8 threads", "scripts", []() {return generateOnThreads(8);}},
+                {"doTransition 1D", "steps", []() {return bounce<TMTape1D>(Right, Left, 1000, 1000000);}},
+                {"doTransition 3D", "steps", []() {return bounce<TMTape3D>(Front, Back, 100, 200000);}},
+                // the tapes of a generated program: the world, variables, temporary values and history
+                {"doTransition 3D 1D 1D 3D", "steps", []() {return bounce<TMTape3D, TMTape1D, TMTape1D, TMTape3D>(Front, Back, 100, 200000);}},
+                {"TMTape3D sequential access", "cells", []() -> Prepared {
+                    const int side = 64;
+                    const std::shared_ptr<TMTape3D> tape = filledTape(side);
+                    return {(double) side * side * side, [tape, side]() {
+                        return timed([&]() {
+                            size_t symbolSizes = 0;
+                            for(int x = 0; x < side; x++) {
+                                for(int y = 0; y < side; y++) {
+                                    for(int z = 0; z < side; z++) symbolSizes += (*tape)[x][y][z].symbol.size();
+                                }
+                            }
+                            sink += symbolSizes;
+                        });
+                    }};
+                }},
+                {"TMTape3D random access", "cells", []() -> Prepared {
+                    const int side = 64;
+                    const std::shared_ptr<TMTape3D> tape = filledTape(side);
+                    // the same coordinates in every run
+                    std::mt19937 generator(42);
+                    std::uniform_int_distribution<int> coordinate(0, side - 1);
+                    const auto cells = std::make_shared<std::vector<std::array<int, 3>>>(1000000);
+                    for(auto &cell : *cells) cell = {coordinate(generator), coordinate(generator), coordinate(generator)};
+                    return {(double) cells->size(), [tape, cells]() {
+                        return timed([&]() {
+                            size_t symbolSizes = 0;
+                            for(const auto &[x, y, z] : *cells) symbolSizes += (*tape)[x][y][z].symbol.size();
+                            sink += symbolSizes;
+                        });
+                    }};
+                }},
+                // every triangle is tested against every voxel, so the voxels are larger than in the window to keep a run near a second
+                {"voxelise objs/teapot.obj 0.25", "triangles", []() {return voxelise("objs/teapot.obj", 0.25);}},
+                {"voxelise objs/Mario.obj 1", "triangles", []() {return voxelise("objs/Mario.obj", 1);}},
+                {"generateTerrain", "voxels", []() -> Prepared {
+                    return {(double) TerrainWidth * TerrainLength * TerrainHeight, []() {
+                        VoxelSpace space;
+                        return timed([&]() {
+                            utils::generateTerrain(space, TerrainWidth, TerrainLength, TerrainHeight);
+                            sink += space.size();
+                        });
+                    }};
+                }},
+                {"buildMesh terrain", "cells", []() -> Prepared {
+                    VoxelSpace space;
+                    utils::generateTerrain(space, TerrainWidth, TerrainLength, TerrainHeight);
+                    const auto tape = std::make_shared<TMTape3D>();
+                    utils::voxelSpaceToTape(space, *tape);
+                    const auto colorMap = std::make_shared<const map<string, Color>>(map<string, Color>{{"default", Color(1, 1, 1, 1)}});
+                    return {(double) tape->getCellCount(), [tape, colorMap]() {
+                        std::vector<float> vertices;
+                        std::vector<unsigned int> indices;
+                        return timed([&]() {
+                            VisualisationHelper::buildMesh(*tape, *colorMap, vertices, indices);
+                            sink += indices.size();
+                        });
+                    }};
+                }},
+        };
+    }
+
+    json measure(const Benchmark &benchmark, unsigned int repetitions) {
+        const Prepared prepared = benchmark.prepare();
+        // a first run that is not counted, so caches and allocators are warm for all the others
+        prepared.run();
+        std::vector<double> seconds;
+        for(unsigned int i = 0; i < repetitions; i++) seconds.push_back(prepared.run());
+        std::sort(seconds.begin(), seconds.end());
+        const double median = seconds.size() % 2 ? seconds[seconds.size() / 2]
+                : (seconds[seconds.size() / 2 - 1] + seconds[seconds.size() / 2]) / 2;
+        double mean = 0;
+        for(double repetition : seconds) mean += repetition / seconds.size();
+        return {{"name", benchmark.name}, {"unit", benchmark.unit}, {"items", prepared.items}, {"repetitions", repetitions},
+                {"seconds", {{"min", seconds.front()}, {"median", median}, {"mean", mean}, {"max", seconds.back()}}},
+                {"items per second", prepared.items / median}};
+    }
+}
+
+// measures the hot paths of the pipeline on the scripts and models in the repository, run it from the root of the repository
+int main(int argc, char **argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    }
+    catch(const std::exception &exception) {
+        std::cerr << exception.what() << "\n" << Usage << std::endl;
+        return 1;
+    }
+    try {
+        // the probabilistic directions of the synthetic machines always go the same way
+        TMTapeProbabilisticDirection::seed(42);
+        json results = json::array();
+        for(const Benchmark &benchmark : benchmarks()) {
+            if(benchmark.name.find(options.filter) == std::string::npos) continue;
+            results.push_back(measure(benchmark, options.repetitions));
+            std::cerr << benchmark.name << ": " << results.back()["seconds"]["median"].get<double>() << " s, "
+                      << results.back()["items per second"].get<double>() << " " << benchmark.unit << "/s" << std::endl;
+        }
+        const json report = {
+                {"context", {{"compiler", __VERSION__}, {"threads", std::thread::hardware_concurrency()},
+#ifdef VOXELFUSION_INSTRUMENTATION
+                             {"instrumentation", true}
+#else
+                             {"instrumentation", false}
+#endif
+                }},
+                {"benchmarks", results}
+        };
+        if(options.outputPath.empty()) std::cout << report.dump(4) << std::endl;
+        else std::ofstream(options.outputPath) << report.dump(4) << std::endl;
+    }
+    catch(const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
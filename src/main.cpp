@@ -1,6 +1,9 @@
 #include "Visualisation/Visualisation.h"
 #include "TMgenerator/TMGenerator.h"
 #include "utils.h"
+#include "Instrumentation.h"
+
+#include <fstream>
 
 int main() {
     map<string, Color> colorMap{{"A", Color(1.0f, 0.0f, 0.0f, .5f)},
@@ -12,7 +15,15 @@ int main() {
                                 {"green", Color(0.0f, 1.0f, 0.0f, 1.0f)},
                                 {"blue", Color(0.0f, 0.0f, 1.0f, 1.0f)},
                                 {"default", Color(1.0f, 1.0f, 1.0f, 1.0f)}};
+#ifdef VOXELFUSION_INSTRUMENTATION
+    Instrumentation::start();
+#endif
     Visualisation v(45.0f, 0.1f, 100.0f, colorMap);
     v.run();
+#ifdef VOXELFUSION_INSTRUMENTATION
+    std::ofstream trace("trace.json"), summary("summary.json");
+    Instrumentation::writeTrace(trace);
+    Instrumentation::writeSummary(summary);
+#endif
     return 0;
 }
\ No newline at end of file
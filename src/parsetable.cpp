@@ -0,0 +1,16 @@
+#include "LR1Parser/LALR1Parser/LALR1Parser.h"
+
+#include <fstream>
+#include <iostream>
+
+// builds the LALR(1) table of a grammar and writes it as C++ source, run by CMake to compile the TASM table into the binaries
+int main(int argc, char **argv) {
+    if(argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <grammar.json> <output.cpp>" << std::endl;
+        return 1;
+    }
+    const LALR1Parser parser(argv[1]);
+    std::ofstream output(argv[2]);
+    parser.getCompiledTable().writeSource(output, argv[1]);
+    return output ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "LR1Parser/LALR1Parser/LALR1Parser.h"
+#include "Lexer/SourceFile.h"
+#include "MTMDTuringMachine/TMExecution.h"
+#include "TMgenerator/CompileService.h"
+#include "utils.h"
+#include "Instrumentation.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+
+namespace {
+    const char *const Usage =
+            "usage: voxelfusion-run <script.tasm> [--obj <world.obj> [--voxel-size <size>] | --json <tape.json> | --terrain <x> <y> <z> [--random]]\n"
+            "                       [--steps <count>] [--seconds <seconds>] [--seed <seed>] [--parse-table <table.json>] [--output <tape.json>]\n"
+            "                       [--trace <trace.json>] [--summary <summary.json>]";
+
+    struct Options {
+        std::string scriptPath;
+        std::string objPath;
+        double voxelSize = 0.1;
+        std::string jsonPath;
+        std::vector<unsigned int> terrainSize;
+        bool randomTerrain = false;
+        uint64_t maxSteps = std::numeric_limits<uint64_t>::max();
+        double maxSeconds = std::numeric_limits<double>::infinity();
+        std::optional<unsigned int> seed;
+        std::string parseTablePath;
+        std::string outputPath = "tape.json";
+        std::string tracePath;
+        std::string summaryPath;
+    };
+
+    Options parseOptions(int argc, char **argv) {
+        Options options;
+        for(int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            const auto value = [&]() -> std::string {
+                if(++i >= argc) throw std::invalid_argument("Missing value for " + argument);
+                return argv[i];
+            };
+            if(argument == "--obj") options.objPath = value();
+            else if(argument == "--voxel-size") options.voxelSize = std::stod(value());
+            else if(argument == "--json") options.jsonPath = value();
+            else if(argument == "--terrain") {
+                for(int axis = 0; axis < 3; axis++) options.terrainSize.push_back(std::stoul(value()));
+            }
+            else if(argument == "--random") options.randomTerrain = true;
+            else if(argument == "--steps") options.maxSteps = std::stoull(value());
+            else if(argument == "--seconds") options.maxSeconds = std::stod(value());
+            else if(argument == "--seed") options.seed = std::stoul(value());
+            else if(argument == "--parse-table") options.parseTablePath = value();
+            else if(argument == "--output") options.outputPath = value();
+            else if(argument == "--trace") options.tracePath = value();
+            else if(argument == "--summary") options.summaryPath = value();
+            else if(argument.rfind("--", 0) == 0 || !options.scriptPath.empty()) throw std::invalid_argument("Unexpected argument " + argument);
+            else options.scriptPath = argument;
+        }
+        if(options.scriptPath.empty()) throw std::invalid_argument("No TASM script given");
+        if(!options.objPath.empty() + !options.jsonPath.empty() + !options.terrainSize.empty() > 1) {
+            throw std::invalid_argument("Only one world can be given");
+        }
+        return options;
+    }
+
+    void loadWorld(const Options &options, TMTape3D &world) {
+        if(!options.objPath.empty()) utils::objToTape(options.objPath, world, options.voxelSize, "A");
+        else if(!options.jsonPath.empty()) utils::load3DTapeFromJson(world, options.jsonPath);
+        else if(!options.terrainSize.empty()) {
+            VoxelSpace space;
+            utils::generateTerrain(space, options.terrainSize[0], options.terrainSize[1], options.terrainSize[2], options.randomTerrain, 0.1);
+            utils::voxelSpaceToTape(space, world);
+        }
+    }
+}
+
+// runs a TASM script on a world without a window, so simulations can be run on machines without a display
+int main(int argc, char **argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    }
+    catch(const std::exception &exception) {
+        std::cerr << exception.what() << "\n" << Usage << std::endl;
+        return 1;
+    }
+    try {
+        // the phases inside the pipeline are only timed if it is built with VOXELFUSION_INSTRUMENTATION, the run itself always is
+        if(!options.tracePath.empty() || !options.summaryPath.empty()) Instrumentation::start();
+        if(options.seed) TMTapeProbabilisticDirection::seed(*options.seed);
+        TMTape3D world;
+        {
+            const ScopedTimer timer("load world");
+            loadWorld(options, world);
+        }
+
+        const auto compileStart = std::chrono::steady_clock::now();
+        auto parser = std::make_shared<LALR1Parser>(CompiledParseTable::tasm());
+        if(!options.parseTablePath.empty()) parser->importTable(options.parseTablePath);
+        const CompileService compiler(parser, {"B"}, false, true, true, true, true);
+        const SourceFile code(options.scriptPath);
+        const CompiledProgram program = compiler.compile(code.getContents());
+        const std::chrono::duration<double> compileSeconds = std::chrono::steady_clock::now() - compileStart;
+        std::cout << "compiled " << options.scriptPath << " to " << program.states.size() << " states and "
+                  << program.transitions.size() << " transitions in " << compileSeconds.count() << " s" << std::endl;
+
+        TMExecution execution(program.tapeAlphabet, program.states, program.transitions, world);
+        const auto runStart = std::chrono::steady_clock::now();
+        const uint64_t steps = options.maxSeconds < std::numeric_limits<double>::infinity()
+                ? execution.runFor(std::chrono::duration<double>(options.maxSeconds), options.maxSteps) : execution.step(options.maxSteps);
+        const auto runEnd = std::chrono::steady_clock::now();
+        const std::chrono::duration<double> runSeconds = runEnd - runStart;
+        const std::string result = !execution.isHalted() ? "stopped" : execution.isAccepted() ? "accepted" : "rejected";
+        std::cout << result << " after " << steps << " steps in " << runSeconds.count() << " s, "
+                  << steps / std::max(runSeconds.count(), 1e-9) << " steps/s" << std::endl;
+        Instrumentation::addSpan("run", runStart, runEnd);
+        Instrumentation::addCounter("states", program.states.size());
+        Instrumentation::addCounter("transitions", program.transitions.size());
+        Instrumentation::addCounter("steps", steps);
+        Instrumentation::addCounter("steps per second", steps / std::max(runSeconds.count(), 1e-9));
+        // tapes only grow, so this is the most cells they held at once
+        Instrumentation::addCounter("tape cells", execution.getCellCount());
+
+        utils::save3DTapeToJson(world, options.outputPath);
+        std::cout << "tape written to " << options.outputPath << std::endl;
+        Instrumentation::stop();
+        if(!options.tracePath.empty()) {
+            std::ofstream trace(options.tracePath);
+            Instrumentation::writeTrace(trace);
+        }
+        if(!options.summaryPath.empty()) {
+            std::ofstream summary(options.summaryPath);
+            Instrumentation::writeSummary(summary);
+        }
+    }
+    catch(const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
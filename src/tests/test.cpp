@@ -1,10 +1,19 @@
 #include <gtest/gtest.h>
 #include "LR1Parser/LALR1Parser/LALR1Parser.h"
 #include "Lexer/Lexer.h"
+#include "Lexer/SourceFile.h"
 #include "string"
 #include "TMgenerator/TMGenerator.h"
+#include "TMgenerator/CompiledProgramCache.h"
+#include "TMgenerator/CompileService.h"
+#include "TMgenerator/TasmOptimizer.h"
 #include "MTMDTuringMachine/MTMDTuringMachine.h"
+#include "MTMDTuringMachine/TMExecution.h"
 #include "utils/utils.h"
+#include "utils/Instrumentation.h"
+#include "json.hpp"
+
+#include <chrono>
 
 using std::ifstream, std::stringstream, std::make_shared;
 
@@ -14,25 +23,9 @@ protected:
     inline static ::shared_ptr<LALR1Parser> parser;
     static void SetUpTestSuite() {
         //parser = ::make_shared<LALR1Parser>("src/CFG/input/Tasm.json");
-        parser = ::make_shared<LALR1Parser>();
-        parser->importTable("parsingTable.json");
+        parser = ::make_shared<LALR1Parser>(CompiledParseTable::tasm());
         //parser->exportTable("parsingTable.json");
     }
-    static shared_ptr<Lexer> initializeLexer(const string& path){
-        string code;
-        string line;
-        ::ifstream input (path);
-        if (input.is_open())
-        {
-            while ( getline (input, line) )
-            {
-                code += line;
-            }
-            input.close();
-        }
-        return make_shared<Lexer>(code);
-    };
-
     static void compareFiles(const string& real, const string& expected){
         ::ifstream t(real);
         ::stringstream buffer;
@@ -42,26 +35,43 @@ protected:
         buffer2 << t2.rdbuf();
         EXPECT_EQ(buffer2.str(), buffer.str());
     }
-    static void compile(const string& codePath, shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>>& tm){
-        auto lexer = initializeLexer(codePath);
-        const std::shared_ptr<STNode>& root = parser->parse(lexer->getTokenizedInput());
-        root->exportVisualization("test.dot");
+    static void generate(const string& codePath, std::set<std::string>& tapeAlphabet, std::set<StatePointer>& states,
+                         map<TransitionDomain, TransitionImage>& transitions, bool optimizeFiniteControl = false,
+                         bool allocateVariableSlots = false, bool nativeArithmetic = false, unsigned int threadCount = 1,
+                         bool optimizeSyntaxTree = false){
+        const SourceFile code(codePath);
+        TokenStream tokens(code.getContents());
+        SyntaxTree tree = parser->parse(tokens);
+        if(optimizeSyntaxTree) TasmOptimizer().optimize(tree);
+        tree.exportVisualization("test.dot");
+        TMGenerator generator{tapeAlphabet, transitions, states, false, optimizeFiniteControl, allocateVariableSlots, nativeArithmetic,
+                              threadCount};
+        generator.assembleTasm(tree.getRoot());
+    }
+    static void makeMachine(std::set<std::string>& tapeAlphabet, const std::set<StatePointer>& states,
+                            const map<TransitionDomain, TransitionImage>& transitions,
+                            shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>>& tm){
         auto *tape3d {new TMTape3D()};
         auto *tape1d {new TMTape1D()};
         auto *tape1d2 {new TMTape1D()};
         auto *history {new TMTape3D()};
         auto tapes = std::make_tuple(tape3d, tape1d, tape1d2, history);
+        FiniteControl control(states, transitions);
+        tm = make_shared<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>>(tapeAlphabet, tapeAlphabet, tapes, control, nullptr);
+    }
+    static void compile(const string& codePath, shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>>& tm,
+                        bool optimizeFiniteControl = false, bool allocateVariableSlots = false, bool nativeArithmetic = false,
+                        bool optimizeSyntaxTree = false){
         std::set<std::string> tapeAlphabet = {"B", "S"};
         std::set<StatePointer> states;
         map<TransitionDomain, TransitionImage> transitions;
-        TMGenerator generator{tapeAlphabet, transitions, states, false};
-        generator.assembleTasm(root);
-        FiniteControl control(states, transitions);
-        tm = make_shared<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>>(tapeAlphabet, tapeAlphabet, tapes, control, nullptr);
+        generate(codePath, tapeAlphabet, states, transitions, optimizeFiniteControl, allocateVariableSlots, nativeArithmetic, 1,
+                 optimizeSyntaxTree);
+        makeMachine(tapeAlphabet, states, transitions, tm);
     }
-    static bool testWithinScript(const string& codePath){
+    static bool testWithinScript(const string& codePath, bool optimizeFiniteControl = false, bool allocateVariableSlots = false){
         shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
-        compile(codePath, tm);
+        compile(codePath, tm, optimizeFiniteControl, allocateVariableSlots);
 
         int counter = 0;
         while(!tm->isHalted && counter < 264332){ //prevent non-halting tests
@@ -70,6 +80,51 @@ protected:
         }
         return tm->getFiniteControl().currentState->type == State_Accepting;
     }
+    // runs with the same random draws and returns the variable and third tapes
+    static vector<vector<string>> runToHalt(const shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>>& tm){
+        TMTapeProbabilisticDirection::seed(2023);
+        for(int counter = 0; !tm->isHalted && counter < 264332; counter++) tm->doTransition();
+        return {tapeContents(*std::get<1>(tm->getTapes())), tapeContents(*std::get<2>(tm->getTapes()))};
+    }
+    // every state and transition by name, as states are compared by address
+    static vector<string> describe(const std::set<StatePointer>& states, const map<TransitionDomain, TransitionImage>& transitions){
+        vector<string> description;
+        for(const StatePointer& state : states) description.push_back(state->name + " " + std::to_string(state->type) + std::to_string(state->isInitial));
+        for(const auto& [domain, image] : transitions){
+            string transition = domain.state->name + " ->" + image.state->name + (image.macro ? " macro" : "") + ":";
+            for(const string& symbol : domain.replacedSymbols) transition += " " + symbol;
+            for(const string& symbol : image.replacementSymbols) transition += " " + symbol;
+            for(const TMTapeProbabilisticDirection& direction : image.directions){
+                for(const TMTapeDirection& tapeDirection : direction.directions) transition += (char) tapeDirection;
+            }
+            description.push_back(transition);
+        }
+        std::sort(description.begin(), description.end());
+        return description;
+    }
+    // every symbol that is not blank by its position (forwards, up, right), however far the tape grew
+    static map<std::array<int, 3>, string> tapeContents(const TMTape3D& tape){
+        map<std::array<int, 3>, string> symbols;
+        for(unsigned int i = 0; i < tape.getCells().size(); i++){
+            const TMTape2D& plane = *tape.getCells()[i];
+            for(unsigned int j = 0; j < plane.getCells().size(); j++){
+                const TMTape1D& row = *plane.getCells()[j];
+                for(unsigned int k = 0; k < row.getCells().size(); k++){
+                    const string& symbol = row.getCells()[k]->symbol;
+                    if(symbol != "B") symbols[{(int) i - tape.zeroAnchor, (int) j - plane.zeroAnchor, (int) k - row.zeroAnchor}] = symbol;
+                }
+            }
+        }
+        return symbols;
+    }
+    // the symbols of a tape without the blanks around them
+    static vector<string> tapeContents(const TMTape1D& tape){
+        vector<string> symbols;
+        for(const auto& cell : tape.getCells()) symbols.push_back(cell->symbol);
+        while(!symbols.empty() && symbols.back() == "B") symbols.pop_back();
+        symbols.erase(symbols.begin(), std::find_if(symbols.begin(), symbols.end(), [](const string& symbol){return symbol != "B";}));
+        return symbols;
+    }
     virtual void SetUp() {
 
     }
@@ -106,11 +161,664 @@ TEST_F(compilationTest, arrays)
 {
     EXPECT_TRUE(testWithinScript("tasm/arrays.tasm"));
 }
+TEST_F(compilationTest, division)
+{
+    EXPECT_TRUE(testWithinScript("tasm/division.tasm"));
+    EXPECT_TRUE(testWithinScript("tasm/division.tasm", true, true));
+}
 TEST_F(compilationTest, random)
 {
     const int confidence = 10;
     for(int i = 0; i < confidence; i++) EXPECT_TRUE(testWithinScript("tasm/random.tasm"));
 }
+TEST_F(compilationTest, optimizedFiniteControl)
+{
+    for(const auto& script : {"tasm/conditional.tasm", "tasm/variables-symbols.tasm", "tasm/variables-integers.tasm", "tasm/arrays.tasm"}){
+        EXPECT_TRUE(testWithinScript(script, true)) << script;
+    }
+    // the same script always gives the same smaller finite control
+    vector<string> descriptions[3];
+    for(unsigned int i = 0; i < 3; i++){
+        std::set<std::string> tapeAlphabet = {"B", "S"};
+        std::set<StatePointer> states;
+        map<TransitionDomain, TransitionImage> transitions;
+        generate("tasm/arrays.tasm", tapeAlphabet, states, transitions, i > 0, true, true);
+        descriptions[i] = describe(states, transitions);
+    }
+    EXPECT_LT(descriptions[1].size(), descriptions[0].size());
+    EXPECT_EQ(descriptions[1], descriptions[2]);
+}
+TEST_F(compilationTest, optimizedFiniteControlWorld)
+{
+    // fall-through.tasm never accepts, it halts after its last line because no transition applies
+    for(const auto& script : {"tasm/fall-through.tasm", "tasm/conditional.tasm", "tasm/arrays.tasm", "tasm/division.tasm"}){
+        map<std::array<int, 3>, string> worlds[2];
+        StateType results[2];
+        for(bool optimizeFiniteControl : {false, true}){
+            shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+            compile(script, tm, optimizeFiniteControl, true);
+            runToHalt(tm);
+            EXPECT_TRUE(tm->isHalted) << script;
+            worlds[optimizeFiniteControl] = tapeContents(*std::get<0>(tm->getTapes()));
+            results[optimizeFiniteControl] = tm->getFiniteControl().currentState->type;
+        }
+        EXPECT_EQ(results[false], results[true]) << script;
+        EXPECT_EQ(worlds[false], worlds[true]) << script;
+    }
+    shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+    compile("tasm/fall-through.tasm", tm, true);
+    runToHalt(tm);
+    EXPECT_EQ(tm->getFiniteControl().currentState->type, State_NonHalting);
+    EXPECT_EQ((map<std::array<int, 3>, string>{{{0, 0, 0}, "C"}}), tapeContents(*std::get<0>(tm->getTapes())));
+}
+TEST_F(compilationTest, optimizedFiniteControlTerrain)
+{
+    // the terrain is made of symbols outside of the tape alphabet, which no enumeration of the alphabet may match
+    VoxelSpace space;
+    utils::generateTerrain(space, 6, 6, 4);
+    unsigned int steps[2];
+    map<std::array<int, 3>, string> worlds[2];
+    StateType results[2];
+    for(bool optimizeFiniteControl : {false, true}){
+        shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+        compile("tasm/generalCA.tasm", tm, optimizeFiniteControl, true, true);
+        utils::voxelSpaceToTape(space, *std::get<0>(tm->getTapes()));
+        TMTapeProbabilisticDirection::seed(2023);
+        for(steps[optimizeFiniteControl] = 0; !tm->isHalted && steps[optimizeFiniteControl] < 264332; steps[optimizeFiniteControl]++){
+            tm->doTransition();
+        }
+        worlds[optimizeFiniteControl] = tapeContents(*std::get<0>(tm->getTapes()));
+        results[optimizeFiniteControl] = tm->getFiniteControl().currentState->type;
+    }
+    EXPECT_EQ(steps[false], steps[true]);
+    EXPECT_EQ(results[false], results[true]);
+    EXPECT_EQ(worlds[false], worlds[true]);
+}
+// run with --gtest_also_run_disabled_tests
+TEST_F(compilationTest, DISABLED_optimizedFiniteControlTime)
+{
+    // the largest script, minimising its finite control has to stay in the order of generating it
+    double seconds[2];
+    size_t stateCounts[2];
+    for(bool optimizeFiniteControl : {false, true}){
+        std::set<std::string> tapeAlphabet = {"B"};
+        std::set<StatePointer> states;
+        map<TransitionDomain, TransitionImage> transitions;
+        const auto start = std::chrono::steady_clock::now();
+        generate("tasm/terrain-generation.tasm", tapeAlphabet, states, transitions, optimizeFiniteControl, true, true);
+        seconds[optimizeFiniteControl] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stateCounts[optimizeFiniteControl] = states.size();
+    }
+    EXPECT_LT(stateCounts[true], stateCounts[false]);
+    EXPECT_LT(seconds[true], 20 * seconds[false] + 1);
+}
+TEST_F(compilationTest, variableSlots)
+{
+    for(const auto& script : {"tasm/conditional.tasm", "tasm/variables-symbols.tasm", "tasm/variables-integers.tasm", "tasm/arrays.tasm"}){
+        EXPECT_TRUE(testWithinScript(script, false, true)) << script;
+    }
+    EXPECT_TRUE(testWithinScript("tasm/random.tasm", true, true));
+}
+TEST_F(compilationTest, nativeArithmetic)
+{
+    for(const auto& script : {"tasm/arrays.tasm", "tasm/variables-integers.tasm", "tasm/random.tasm", "tasm/division.tasm"}){
+        for(bool allocateVariableSlots : {false, true}){
+            vector<vector<string>> finalTapes[2];
+            for(bool nativeArithmetic : {false, true}){
+                shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+                compile(script, tm, false, allocateVariableSlots, nativeArithmetic);
+                finalTapes[nativeArithmetic] = runToHalt(tm);
+                EXPECT_EQ(tm->getFiniteControl().currentState->type, State_Accepting) << script;
+            }
+            EXPECT_EQ(finalTapes[false], finalTapes[true]) << script;
+        }
+    }
+}
+TEST_F(compilationTest, syntaxTreeOptimizer)
+{
+    for(const auto& script : {"tasm/conditional.tasm", "tasm/variables-integers.tasm", "tasm/arrays.tasm", "tasm/division.tasm",
+                                "tasm/random.tasm", "tasm/neighbours.tasm", "tasm/boxes.tasm", "tasm/simplify.tasm"}){
+        for(bool allocateVariableSlots : {false, true}){
+            map<std::array<int, 3>, string> worlds[2];
+            StateType results[2];
+            for(bool optimizeSyntaxTree : {false, true}){
+                shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+                compile(script, tm, false, allocateVariableSlots, false, optimizeSyntaxTree);
+                runToHalt(tm);
+                worlds[optimizeSyntaxTree] = tapeContents(*std::get<0>(tm->getTapes()));
+                results[optimizeSyntaxTree] = tm->getFiniteControl().currentState->type;
+            }
+            EXPECT_EQ(results[true], State_Accepting) << script;
+            EXPECT_EQ(results[false], results[true]) << script;
+            EXPECT_EQ(worlds[false], worlds[true]) << script;
+        }
+    }
+    // the goto chains, the dead lines and the constants are gone
+    std::set<std::string> tapeAlphabet[2] = {{"B", "S"}, {"B", "S"}};
+    std::set<StatePointer> states[2];
+    map<TransitionDomain, TransitionImage> transitions[2];
+    for(bool optimizeSyntaxTree : {false, true}){
+        generate("tasm/simplify.tasm", tapeAlphabet[optimizeSyntaxTree], states[optimizeSyntaxTree], transitions[optimizeSyntaxTree],
+                 false, false, false, 1, optimizeSyntaxTree);
+    }
+    EXPECT_LT(states[true].size(), states[false].size());
+    EXPECT_LT(transitions[true].size(), transitions[false].size());
+    EXPECT_EQ(tapeAlphabet[true].count("X") + tapeAlphabet[true].count("Y") + tapeAlphabet[true].count("Z"), 0);
+    // a literal wider than 64 bits wraps around instead of throwing
+    TokenStream tokens("X = 340282366920938463463374607431768211457;\nif X == 1 goto 4;\nwrite 'A';\naccept;");
+    SyntaxTree tree = parser->parse(tokens);
+    EXPECT_NO_THROW(TasmOptimizer().optimize(tree));
+}
+TEST_F(compilationTest, sweepBox)
+{
+    for(bool allocateVariableSlots : {false, true}){
+        // slots lay the variable tape out differently
+        vector<vector<string>> reference;
+        map<std::array<int, 3>, string> referenceWorld, referenceHistory;
+        for(bool nativeArithmetic : {false, true}){
+            shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+            compile("tasm/CA.tasm", tm, false, allocateVariableSlots, nativeArithmetic);
+            const vector<vector<string>> finalTapes = runToHalt(tm);
+            const auto world = tapeContents(*std::get<0>(tm->getTapes()));
+            const auto history = tapeContents(*std::get<3>(tm->getTapes()));
+            if(!nativeArithmetic){
+                reference = finalTapes;
+                referenceWorld = world;
+                referenceHistory = history;
+            }
+            EXPECT_EQ(reference, finalTapes) << allocateVariableSlots << nativeArithmetic;
+            EXPECT_EQ(referenceWorld, world) << allocateVariableSlots << nativeArithmetic;
+            EXPECT_EQ(referenceHistory, history) << allocateVariableSlots << nativeArithmetic;
+        }
+    }
+}
+TEST_F(compilationTest, boxOperations)
+{
+    shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+    compile("tasm/boxes.tasm", tm);
+    runToHalt(tm);
+    EXPECT_EQ(tm->getFiniteControl().currentState->type, State_Accepting);
+    map<std::array<int, 3>, string> world, history;
+    for(int front = 0; front < 4; front++){
+        for(int up = 0; up < 2; up++){
+            world[{front, up, 0}] = "A";
+            for(int right = 1; right < 3; right++){
+                const string symbol = front < 2 && up == 0 && right == 1 ? "C" : "A";
+                world[{front, up + 2, right}] = symbol;
+                // the head of the history tape did not move right
+                history[{front, up, right - 1}] = symbol;
+            }
+        }
+    }
+    EXPECT_EQ(world, tapeContents(*std::get<0>(tm->getTapes())));
+    EXPECT_EQ(history, tapeContents(*std::get<3>(tm->getTapes())));
+}
+TEST_F(compilationTest, neighbourReads)
+{
+    const map<std::array<int, 3>, string> world{{{0, 0, 0}, "A"}, {{0, 0, 1}, "C"}, {{0, 0, 2}, "D"}};
+    for(bool allocateVariableSlots : {false, true}){
+        for(bool nativeArithmetic : {false, true}){
+            shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm;
+            compile("tasm/neighbours.tasm", tm, false, allocateVariableSlots, nativeArithmetic);
+            const vector<vector<string>> finalTapes = runToHalt(tm);
+            EXPECT_EQ(tm->getFiniteControl().currentState->type, State_Accepting);
+            EXPECT_EQ(world, tapeContents(*std::get<0>(tm->getTapes()))) << allocateVariableSlots << nativeArithmetic;
+            // the neighbours are read in place, so they are never stored on the variable tape
+            EXPECT_EQ(std::count(finalTapes[0].begin(), finalTapes[0].end(), "Left"), 0);
+        }
+    }
+}
+TEST_F(compilationTest, reservedSymbols)
+{
+    for(const string& symbol : {TapeReference::equalTo(1), TapeReference::unequalTo(1), NeighbourRead::at(1, 0, 0, "A")}){
+        std::set<std::string> tapeAlphabet = {"B", symbol};
+        std::set<StatePointer> states;
+        map<TransitionDomain, TransitionImage> transitions;
+        EXPECT_THROW(generate("tasm/conditional.tasm", tapeAlphabet, states, transitions), std::runtime_error) << symbol;
+    }
+}
+TEST_F(compilationTest, parallelGeneration)
+{
+    for(const auto& script : {"tasm/helloworld.tasm", "tasm/conditional.tasm", "tasm/arrays.tasm", "tasm/variables-symbols.tasm",
+                                "tasm/generalCA.tasm", "tasm/water-physics.tasm", "tasm/division.tasm", "tasm/neighbours.tasm"}){
+        for(bool allocateVariableSlots : {false, true}){
+            for(bool nativeArithmetic : {false, true}){
+                vector<string> descriptions[2];
+                for(unsigned int threads : {1, 4}){
+                    std::set<std::string> tapeAlphabet = {"B", "S"};
+                    std::set<StatePointer> states;
+                    map<TransitionDomain, TransitionImage> transitions;
+                    generate(script, tapeAlphabet, states, transitions, false, allocateVariableSlots, nativeArithmetic, threads);
+                    descriptions[threads > 1] = describe(states, transitions);
+                }
+                EXPECT_EQ(descriptions[0], descriptions[1]) << script;
+            }
+        }
+    }
+}
+TEST_F(compilationTest, compiledProgramCache)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "voxelfusion-test-cache";
+    std::filesystem::remove_all(directory);
+    const CompiledProgramCache cache(directory);
+    for(const auto& script : {"tasm/arrays.tasm", "tasm/random.tasm"}){
+        const uint64_t key = CompiledProgramCache::key(SourceFile(script).getContents(), false, true, true, true, false, 0);
+        std::set<std::string> tapeAlphabet = {"B", "S"};
+        std::set<StatePointer> states;
+        map<TransitionDomain, TransitionImage> transitions;
+        EXPECT_FALSE(cache.load(key, tapeAlphabet, states, transitions));
+        generate(script, tapeAlphabet, states, transitions, true, true, true);
+        cache.store(key, tapeAlphabet, states, transitions);
+
+        std::set<std::string> cachedTapeAlphabet = {"B", "S"};
+        std::set<StatePointer> cachedStates;
+        map<TransitionDomain, TransitionImage> cachedTransitions;
+        ASSERT_TRUE(cache.load(key, cachedTapeAlphabet, cachedStates, cachedTransitions)) << script;
+        EXPECT_EQ(tapeAlphabet, cachedTapeAlphabet);
+        EXPECT_EQ(states.size(), cachedStates.size());
+        EXPECT_EQ(transitions.size(), cachedTransitions.size());
+
+        shared_ptr<MTMDTuringMachine<TMTape3D, TMTape1D, TMTape1D, TMTape3D>> tm, cachedTm;
+        makeMachine(tapeAlphabet, states, transitions, tm);
+        makeMachine(cachedTapeAlphabet, cachedStates, cachedTransitions, cachedTm);
+        EXPECT_EQ(runToHalt(tm), runToHalt(cachedTm)) << script;
+        EXPECT_EQ(cachedTm->getFiniteControl().currentState->type, State_Accepting) << script;
+    }
+    // any change to the code or the options is a different program
+    const uint64_t key = CompiledProgramCache::key("accept;", false, true, true, true, false, 0);
+    EXPECT_NE(key, CompiledProgramCache::key("accept; ", false, true, true, true, false, 0));
+    EXPECT_NE(key, CompiledProgramCache::key("accept;", false, true, true, false, false, 0));
+    EXPECT_NE(key, CompiledProgramCache::key("accept;", false, true, true, true, true, 0));
+    EXPECT_NE(key, CompiledProgramCache::key("accept;", false, true, true, true, false, 1));
+    std::filesystem::remove_all(directory);
+}
+TEST_F(compilationTest, compileService)
+{
+    const vector<string> scripts = {"tasm/helloworld.tasm", "tasm/conditional.tasm", "tasm/arrays.tasm", "tasm/generalCA.tasm",
+                                    "tasm/water-physics.tasm", "tasm/division.tasm", "tasm/boxes.tasm", "tasm/neighbours.tasm"};
+    std::deque<SourceFile> files;
+    for(const string& script : scripts) files.emplace_back(script);
+    vector<std::string_view> codes;
+    for(const SourceFile& file : files) codes.push_back(file.getContents());
+    codes.emplace_back("goto ;");
+
+    const CompileService service(parser, {"B", "S"}, false, true, true, true, true, 4);
+    const vector<CompiledProgram> programs = service.compile(codes);
+    ASSERT_EQ(programs.size(), codes.size());
+    for(unsigned int i = 0; i < scripts.size(); i++){
+        ASSERT_FALSE(programs[i].exception) << scripts[i];
+        std::set<std::string> tapeAlphabet = {"B", "S"};
+        std::set<StatePointer> states;
+        map<TransitionDomain, TransitionImage> transitions;
+        generate(scripts[i], tapeAlphabet, states, transitions, true, true, true, 1, true);
+        EXPECT_EQ(programs[i].tapeAlphabet, tapeAlphabet) << scripts[i];
+        EXPECT_EQ(describe(programs[i].states, programs[i].transitions), describe(states, transitions)) << scripts[i];
+    }
+    // a script that does not parse does not stop the others
+    ASSERT_TRUE(programs.back().exception);
+    EXPECT_THROW(std::rethrow_exception(programs.back().exception), std::invalid_argument);
+    EXPECT_THROW((void) service.compile(codes.back()), std::invalid_argument);
+    // cached programs are keyed on the options and the parse table of the service
+    EXPECT_EQ(service.cacheKey(codes[0]), CompiledProgramCache::key(codes[0], false, true, true, true, true,
+                                                                    CompiledParseTable::tasm().hash()));
+    EXPECT_NE(service.cacheKey(codes[0]), CompileService(parser, {"B", "S"}, false, true, true, true, false).cacheKey(codes[0]));
+    const auto otherParser = make_shared<LR1Parser>(CompiledParseTable({"accept", ""}, {}, {0, 0}, {}, {}));
+    EXPECT_NE(service.cacheKey(codes[0]), CompileService(otherParser, {"B", "S"}, false, true, true, true, true).cacheKey(codes[0]));
+}
+static string describeTokens(const vector<Token>& tokens){
+    string description;
+    for(const Token& token : tokens) description += std::to_string(token.type) + ":" + token.lexeme + " ";
+    return description;
+}
+TEST(lexerTest, maximalMunch)
+{
+    const Lexer lexer("if X==10 goto 4;write 'A';\n Y+=0 ;Z=[2] ifx");
+    EXPECT_EQ(describeTokens(lexer.getTokenizedInput()), describeTokens({
+            {Token_Keyword, "if"}, {Token_Identifier, "X"}, {Token_Operator, "=="}, {Token_Integer, "10"},
+            {Token_Keyword, "goto"}, {Token_Integer, "4"}, {Token_Punctuator, ";"},
+            {Token_Keyword, "write"}, {Token_Punctuator, "'"}, {Token_Identifier, "A"}, {Token_Punctuator, "'"}, {Token_Punctuator, ";"},
+            {Token_Identifier, "Y"}, {Token_Operator, "+="}, {Token_Integer, "0"}, {Token_Punctuator, ";"},
+            {Token_Identifier, "Z"}, {Token_Operator, "="}, {Token_Punctuator, "["}, {Token_Integer, "2"}, {Token_Punctuator, "]"},
+            {Token_Identifier, "ifx"}, {Token_EOS, ""}}));
+    // "===" is "==" followed by "=", but integers do not start with 0 and "#" or a lone "+" start no token
+    EXPECT_EQ(describeTokens(Lexer("X===1 Y").getTokenizedInput()), describeTokens({
+            {Token_Identifier, "X"}, {Token_Operator, "=="}, {Token_Operator, "="}, {Token_Integer, "1"}, {Token_Identifier, "Y"},
+            {Token_EOS, ""}}));
+    for(const auto& [code, position] : vector<std::pair<string, string>>{{"X===01 #+ Y", "at line 1, column 5"},
+                                                                         {"X = 1;\n  Y = #A;", "at line 2, column 7"},
+                                                                         {"X = 1;\nY + 1;", "at line 2, column 3"}}){
+        try{
+            (void) Lexer(code);
+            FAIL() << code;
+        }
+        catch(const std::invalid_argument& exception){
+            EXPECT_NE(string(exception.what()).find(position), string::npos) << exception.what();
+        }
+    }
+}
+TEST(lexerTest, tokenStream)
+{
+    for(const auto& script : {"tasm/terrain-generation.tasm", "tasm/generalCA.tasm", "tasm/to-delete.tasm"}){
+        const SourceFile code(script);
+        const Lexer lexer{string(code.getContents())};
+        TokenStream tokens(code.getContents());
+        for(const Token& token : lexer.getTokenizedInput()){
+            const TokenView streamed = tokens.next();
+            ASSERT_EQ(streamed.type, token.type) << script;
+            EXPECT_EQ(streamed.lexeme, token.lexeme) << script;
+            // the lexemes point into the mapped file
+            if(token.type != Token_EOS){
+                EXPECT_TRUE(streamed.lexeme.data() >= code.getContents().data() &&
+                            streamed.lexeme.data() < code.getContents().data() + code.getContents().size());
+            }
+        }
+        EXPECT_EQ(tokens.next().type, Token_EOS);
+    }
+    EXPECT_THROW(SourceFile("tasm/missing.tasm"), std::runtime_error);
+
+    const string code = "goto 2;\n  accept;\n\nwrite ;";
+    TokenStream tokens(code);
+    for(const auto& [lexeme, line, column] : vector<std::tuple<string, unsigned int, unsigned int>>{
+            {"goto", 1, 1}, {"2", 1, 6}, {";", 1, 7}, {"accept", 2, 3}, {";", 2, 9}, {"write", 4, 1}, {";", 4, 7}}){
+        const TokenView token = tokens.next();
+        EXPECT_EQ(token.lexeme, lexeme);
+        EXPECT_EQ(token.line, line) << lexeme;
+        EXPECT_EQ(token.column, column) << lexeme;
+    }
+    // the parser reports where it got stuck
+    const LALR1Parser parser(CompiledParseTable::tasm());
+    TokenStream invalid(code);
+    try{
+        parser.parse(invalid);
+        FAIL();
+    }
+    catch(const std::invalid_argument& exception){
+        EXPECT_NE(string(exception.what()).find("at line 4, column 7"), string::npos) << exception.what();
+    }
+}
+// run with --gtest_also_run_disabled_tests
+TEST(lexerTest, DISABLED_throughput)
+{
+    string script;
+    for(const auto& path : {"tasm/terrain-generation.tasm", "tasm/division.tasm", "tasm/generalCA.tasm", "tasm/arrays.tasm"}){
+        ::ifstream input(path);
+        script += string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    const size_t tokensPerCopy = Lexer(script).getTokenizedInput().size() - 1;
+    string synthetic;
+    size_t copies = 0;
+    for(; synthetic.size() < 50 * 1000 * 1000; copies++) synthetic += script;
+
+    const auto start = std::chrono::steady_clock::now();
+    const Lexer lexer(synthetic);
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(lexer.getTokenizedInput().size(), copies * tokensPerCopy + 1);
+    std::cout << synthetic.size() / 1e6 << " MB lexed in " << seconds.count() << " s, "
+              << synthetic.size() / 1e6 / seconds.count() << " MB/s" << std::endl;
+
+    // streamed, without keeping the tokens
+    const auto streamStart = std::chrono::steady_clock::now();
+    TokenStream tokens(synthetic);
+    size_t tokenCount = 0;
+    while(tokens.next().type != Token_EOS) tokenCount++;
+    const std::chrono::duration<double> streamSeconds = std::chrono::steady_clock::now() - streamStart;
+    EXPECT_EQ(tokenCount, copies * tokensPerCopy);
+    std::cout << synthetic.size() / 1e6 << " MB streamed in " << streamSeconds.count() << " s, "
+              << synthetic.size() / 1e6 / streamSeconds.count() << " MB/s" << std::endl;
+}
+static string describeTree(SyntaxNode node){
+    const Token *token = node.getToken();
+    string description = node.getLabel() + (token ? ":" + std::to_string(token->line) + "," + std::to_string(token->column) : "");
+    if(node.hasChildren()){
+        description += "(";
+        for(SyntaxNode child : node.getChildren()) description += describeTree(child) + " ";
+        description += ")";
+    }
+    return description;
+}
+TEST(parserTest, builtInTable)
+{
+    LALR1Parser imported;
+    imported.importTable("parsingTable.json");
+    const LALR1Parser builtIn(CompiledParseTable::tasm());
+    for(const auto& script : {"tasm/terrain-generation.tasm", "tasm/generalCA.tasm", "tasm/arrays.tasm", "tasm/boxes.tasm",
+                                "tasm/division.tasm", "tasm/random.tasm", "tasm/neighbours.tasm"}){
+        const SourceFile code(script);
+        TokenStream importedTokens(code.getContents()), builtInTokens(code.getContents());
+        EXPECT_EQ(describeTree(imported.parse(importedTokens).getRoot()), describeTree(builtIn.parse(builtInTokens).getRoot())) << script;
+    }
+}
+TEST(parserTest, grammarTable)
+{
+    // the table built from the grammar has to be the one that was generated before
+    const LALR1Parser constructed("src/CFG/input/Tasm.json");
+    const LALR1Parser builtIn(CompiledParseTable::tasm());
+    for(const auto& script : {"tasm/terrain-generation.tasm", "tasm/generalCA.tasm", "tasm/arrays.tasm", "tasm/boxes.tasm"}){
+        const SourceFile code(script);
+        TokenStream constructedTokens(code.getContents()), builtInTokens(code.getContents());
+        EXPECT_EQ(describeTree(constructed.parse(constructedTokens).getRoot()), describeTree(builtIn.parse(builtInTokens).getRoot())) << script;
+    }
+    constructed.exportTable("constructedTable.json");
+    const SourceFile exported("constructedTable.json"), expected("parsingTable.json");
+    EXPECT_EQ(exported.getContents(), expected.getContents());
+    std::remove("constructedTable.json");
+}
+// run with --gtest_also_run_disabled_tests
+TEST(parserTest, DISABLED_tableConstruction)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const LALR1Parser parser("src/CFG/input/Tasm.json");
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    std::cout << "TASM parse table built in " << seconds.count() << " s" << std::endl;
+}
+// run with --gtest_also_run_disabled_tests
+TEST(parserTest, DISABLED_throughput)
+{
+    string script;
+    for(const auto& path : {"tasm/terrain-generation.tasm", "tasm/division.tasm", "tasm/generalCA.tasm", "tasm/arrays.tasm"}){
+        ::ifstream input(path);
+        script += string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    string synthetic;
+    while(synthetic.size() < 16 * 1000 * 1000) synthetic += script;
+    const Lexer lexer(synthetic);
+    const LALR1Parser parser(CompiledParseTable::tasm());
+
+    const auto start = std::chrono::steady_clock::now();
+    const SyntaxTree tree = parser.parse(lexer.getTokenizedInput());
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(tree.getRoot().getLabel(), "<StatementList>");
+    std::cout << lexer.getTokenizedInput().size() << " tokens parsed in " << seconds.count() << " s, "
+              << lexer.getTokenizedInput().size() / 1e6 / seconds.count() << " M tokens/s" << std::endl;
+}
+TEST(cfgTest, firstAndFollowSets)
+{
+    // B and C can be empty, so A and S can be too
+    const CFG cfg("src/CFG/input/input-ll1-2.json");
+    const std::map<std::string, std::set<std::string>> expectedFirst{
+            {"A", {"", "d", "g", "h"}}, {"B", {"", "g"}}, {"C", {"", "h"}}, {"S", {"", "a", "b", "d", "g", "h"}}};
+    EXPECT_EQ(cfg.computeFirstSets(), expectedFirst);
+    const std::map<std::string, std::set<std::string>> expectedFollow{
+            {"A", {EOS_MARKER, "g", "h"}}, {"B", {EOS_MARKER, "a", "g", "h"}}, {"C", {EOS_MARKER, "b", "g", "h"}}, {"S", {EOS_MARKER}}};
+    EXPECT_EQ(cfg.computeFollowSets(), expectedFollow);
+
+    // left recursive variables
+    const CFG tasm("src/CFG/input/Tasm.json");
+    EXPECT_EQ(tasm.computeFirstSet("<StatementList>"), tasm.computeFirstSet("<Statement>"));
+}
+TEST(finiteControlTest, tapeReferences)
+{
+    // copy the first tape onto the second until both tapes read the same symbol twice in a row
+    const StatePointer copy = std::make_shared<const State>("copy", true);
+    const StatePointer compare = std::make_shared<const State>("compare");
+    const StatePointer done = std::make_shared<const State>("done", false, State_Accepting);
+    FiniteControl control({copy, compare, done}, {
+            {
+                    TransitionDomain(copy, {SYMBOL_ANY, SYMBOL_ANY}),
+                    TransitionImage(compare, {SYMBOL_ANY, TapeReference::symbolOn(0)}, std::vector<TMTapeDirection>{Right, Stationary})
+            },
+            {
+                    TransitionDomain(compare, {SYMBOL_ANY, TapeReference::equalTo(0)}),
+                    TransitionImage(done, {SYMBOL_ANY, SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary, Stationary})
+            },
+            {
+                    TransitionDomain(compare, {SYMBOL_ANY, TapeReference::unequalTo(0)}),
+                    TransitionImage(copy, {SYMBOL_ANY, SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary, Right})
+            }
+    });
+    auto *input {new TMTape1D()};
+    auto *output {new TMTape1D()};
+    for(const auto &symbol : {"X", "Y", "Y"}) {
+        input->replaceCurrentSymbol(symbol);
+        input->moveTapeHead(Right);
+    }
+    input->currentIndex = 0;
+    MTMDTuringMachine<TMTape1D, TMTape1D> tm({}, {}, std::make_tuple(input, output), control);
+    tm.doTransitions();
+    EXPECT_EQ(tm.getFiniteControl().currentState, done);
+    EXPECT_EQ(output->at(0).symbol, "X");
+    EXPECT_EQ(output->at(1).symbol, "Y");
+    delete input;
+    delete output;
+
+    // a symbol on a tape that looks like a reference is compared as it is
+    const StatePointer check = std::make_shared<const State>("check", true);
+    const StatePointer equal = std::make_shared<const State>("equal", false, State_Accepting);
+    const StatePointer unequal = std::make_shared<const State>("unequal", false, State_Rejecting);
+    FiniteControl checkControl({check, equal, unequal}, {
+            {
+                    TransitionDomain(check, {"X", TapeReference::equalTo(0)}),
+                    TransitionImage(equal, {SYMBOL_ANY, SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary, Stationary})
+            },
+            {
+                    TransitionDomain(check, {SYMBOL_ANY, SYMBOL_ANY}),
+                    TransitionImage(unequal, {SYMBOL_ANY, SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary, Stationary})
+            }
+    });
+    auto *first {new TMTape1D()};
+    auto *second {new TMTape1D()};
+    first->replaceCurrentSymbol("X");
+    second->replaceCurrentSymbol(TapeReference::equalTo(0));
+    MTMDTuringMachine<TMTape1D, TMTape1D> checkTm({}, {}, std::make_tuple(first, second), checkControl);
+    checkTm.doTransitions();
+    EXPECT_EQ(checkTm.getFiniteControl().currentState, unequal);
+    delete first;
+    delete second;
+}
+
+TEST(finiteControlTest, neighbourReads)
+{
+    const StatePointer look = std::make_shared<const State>("look", true);
+    const StatePointer found = std::make_shared<const State>("found", false, State_Accepting);
+    const StatePointer missing = std::make_shared<const State>("missing", false, State_Rejecting);
+    FiniteControl control({look, found, missing}, {
+            {
+                    TransitionDomain(look, {NeighbourRead::at(1, 0, -1, "X")}),
+                    TransitionImage(found, {SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary})
+            },
+            {
+                    TransitionDomain(look, {SYMBOL_ANY}),
+                    TransitionImage(missing, {SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary})
+            }
+    });
+    auto *tape {new TMTape3D()};
+    tape->cellAt(1, 0, -1).symbol = "X";
+    EXPECT_EQ(tape->getSymbolAt(1, 0, -1), "X");
+    EXPECT_EQ(tape->getSymbolAt(0, 5, 0), "B");
+    MTMDTuringMachine<TMTape3D> tm({}, {}, std::make_tuple(tape), control);
+    tm.doTransitions();
+    EXPECT_EQ(tm.getFiniteControl().currentState, found);
+    EXPECT_EQ(tape->getCurrentSymbol(), "B");
+    delete tape;
+
+    // a symbol on the tape that looks like a neighbour read is not one
+    auto *lookalike {new TMTape3D()};
+    lookalike->replaceCurrentSymbol(NeighbourRead::at(1, 0, -1, "X"));
+    MTMDTuringMachine<TMTape3D> lookalikeTm({}, {}, std::make_tuple(lookalike), control);
+    lookalikeTm.doTransitions();
+    EXPECT_EQ(lookalikeTm.getFiniteControl().currentState, missing);
+    delete lookalike;
+}
+
+TEST(executionTest, stepPauseResumeCancel)
+{
+    // walk forwards over the A's on the world, then accept
+    const StatePointer walk = std::make_shared<const State>("walk", true);
+    const StatePointer done = std::make_shared<const State>("done", false, State_Accepting);
+    const set<StatePointer> states{walk, done};
+    const map<TransitionDomain, TransitionImage> transitions{
+            {
+                    TransitionDomain(walk, {"A", SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                    TransitionImage(walk, {"X", SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}, std::vector<TMTapeDirection>{Front, Stationary, Stationary, Stationary})
+            },
+            {
+                    TransitionDomain(walk, {"B", SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}),
+                    TransitionImage(done, {SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY, SYMBOL_ANY}, std::vector<TMTapeDirection>{Stationary, Stationary, Stationary, Stationary})
+            }
+    };
+    TMTape3D world;
+    for(int i = 0; i < 5; i++) world.cellAt(i, 0, 0).symbol = "A";
+    TMExecution execution({"A", "B", "X"}, states, transitions, world);
+    EXPECT_EQ(execution.step(2), 2);
+    EXPECT_EQ(world.getSymbolAt(-2, 0, 0), "X");
+    EXPECT_EQ(world.getCurrentSymbol(), "A");
+
+    // paused, it only moves when stepped
+    execution.pause();
+    EXPECT_EQ(execution.runFor(std::chrono::seconds(1)), 0);
+    EXPECT_EQ(execution.step(), 1);
+    EXPECT_EQ(execution.getStatus(), Execution_Paused);
+    execution.resume();
+    EXPECT_EQ(execution.runFor(std::chrono::seconds(10)), 3);
+    EXPECT_TRUE(execution.isHalted());
+    EXPECT_TRUE(execution.isAccepted());
+    EXPECT_EQ(execution.getStepCount(), 6);
+    EXPECT_EQ(execution.step(), 0);
+    execution.cancel();
+    EXPECT_EQ(execution.getStatus(), Execution_Halted);
+
+    TMTape3D otherWorld;
+    otherWorld.cellAt(0, 0, 0).symbol = "A";
+    TMExecution cancelled({"A", "B", "X"}, states, transitions, otherWorld);
+    cancelled.cancel();
+    EXPECT_EQ(cancelled.step(10), 0);
+    EXPECT_EQ(cancelled.getStatus(), Execution_Cancelled);
+    EXPECT_EQ(otherWorld.getCurrentSymbol(), "A");
+}
+
+TEST(executionTest, interleavedRunsAreDeterministic)
+{
+    const CompileService compiler(std::make_shared<LALR1Parser>(CompiledParseTable::tasm()), {"B"}, false, true, true, true, true, 1);
+    const CompiledProgram program = compiler.compile(SourceFile("tasm/CA.tasm").getContents());
+    const auto makeWorld = [](TMTape3D &world){
+        VoxelSpace space;
+        utils::generateTerrain(space, 8, 4, 8);
+        utils::voxelSpaceToTape(space, world);
+    };
+    TMTape3D whole, interleaved;
+    makeWorld(whole);
+    makeWorld(interleaved);
+    TMExecution wholeExecution(program.tapeAlphabet, program.states, program.transitions, whole);
+    wholeExecution.step(std::numeric_limits<uint64_t>::max());
+    ASSERT_TRUE(wholeExecution.isHalted());
+
+    // as a window would: a few steps at a time, paused and stepped in between
+    TMExecution interleavedExecution(program.tapeAlphabet, program.states, program.transitions, interleaved);
+    for(unsigned int frame = 0; !interleavedExecution.isFinished(); frame++){
+        if(frame % 3 == 0){
+            interleavedExecution.pause();
+            interleavedExecution.step(7);
+            interleavedExecution.resume();
+        }
+        else interleavedExecution.runFor(std::chrono::seconds(10), 5);
+    }
+    EXPECT_EQ(interleavedExecution.getStepCount(), wholeExecution.getStepCount());
+    EXPECT_EQ(interleavedExecution.isAccepted(), wholeExecution.isAccepted());
+    CompletedVoxelSpace wholeSpace, interleavedSpace;
+    utils::tapeToCompletedVoxelSpace(whole, wholeSpace);
+    utils::tapeToCompletedVoxelSpace(interleaved, interleavedSpace);
+    EXPECT_EQ(interleavedSpace, wholeSpace);
+}
 
 TEST_F(generateVoxelsTest, basicVoxelisation){
     const StatePointer startState = std::make_shared<const State>("q0", true);
@@ -144,6 +852,48 @@ TEST_F(generateVoxelsTest, basicTerrainGeneration){
     EXPECT_NO_FATAL_FAILURE(utils::voxelSpaceToTape(voxelSpace, *tape, "D"));
 }
 
+TEST(instrumentationTest, traceAndSummary)
+{
+    {
+        // nothing is recorded before recording starts
+        const ScopedTimer timer("ignored");
+        Instrumentation::addCounter("ignored", 1);
+    }
+    Instrumentation::start();
+    {
+        const ScopedTimer timer("outer");
+        std::thread worker([](){
+            const ScopedTimer timer("worker");
+            Instrumentation::addCounter("cells", 5);
+        });
+        worker.join();
+        Instrumentation::addCounter("cells", 3);
+    }
+    Instrumentation::stop();
+    Instrumentation::addCounter("cells", 100);
+
+    std::stringstream trace, summary;
+    Instrumentation::writeTrace(trace);
+    Instrumentation::writeSummary(summary);
+    const nlohmann::json traceJson = nlohmann::json::parse(trace.str());
+    std::map<string, int> threads;
+    for(const auto& event : traceJson["traceEvents"]){
+        EXPECT_NE(event["name"], "ignored");
+        if(event["ph"] == "X"){
+            EXPECT_GE(event["dur"].get<double>(), 0);
+            threads[event["name"]] = event["tid"];
+        }
+    }
+    ASSERT_EQ(threads.size(), 2);
+    EXPECT_NE(threads["outer"], threads["worker"]);
+    EXPECT_EQ(traceJson["traceEvents"].size(), 4);
+
+    const nlohmann::json summaryJson = nlohmann::json::parse(summary.str());
+    EXPECT_EQ(summaryJson["phases"]["outer"]["count"], 1);
+    EXPECT_EQ(summaryJson["counters"]["cells"]["last"], 3);
+    EXPECT_EQ(summaryJson["counters"]["cells"]["peak"], 5);
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
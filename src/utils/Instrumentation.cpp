@@ -0,0 +1,104 @@
+//
+
+#include "Instrumentation.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+    struct Event {
+        const char *name;
+        // 'X' for a phase, 'C' for a counter, as in the trace
+        char type;
+        Instrumentation::Clock::time_point start;
+        Instrumentation::Clock::duration duration;
+        double value;
+        unsigned int thread;
+    };
+    struct Recording {
+        std::mutex mutex;
+        std::vector<Event> events;
+        Instrumentation::Clock::time_point origin;
+    };
+    Recording& getRecording() {
+        static Recording recording;
+        return recording;
+    }
+    // numbered in the order the threads record something, which is easier to read in a trace than a system thread id
+    unsigned int threadNumber() {
+        static std::atomic<unsigned int> threadCount = 0;
+        thread_local const unsigned int number = threadCount++;
+        return number;
+    }
+    double microseconds(Instrumentation::Clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+}
+
+void Instrumentation::start() {
+    Recording &current = getRecording();
+    const std::lock_guard<std::mutex> lock(current.mutex);
+    current.events.clear();
+    current.origin = Clock::now();
+    recording = true;
+}
+
+void Instrumentation::addSpan(const char *name, Clock::time_point start, Clock::time_point end) {
+    if(!isRecording()) return;
+    Recording &current = getRecording();
+    const std::lock_guard<std::mutex> lock(current.mutex);
+    current.events.push_back({name, 'X', start, end - start, 0, threadNumber()});
+}
+
+void Instrumentation::addCounter(const char *name, double value) {
+    if(!isRecording()) return;
+    Recording &current = getRecording();
+    const Clock::time_point now = Clock::now();
+    const std::lock_guard<std::mutex> lock(current.mutex);
+    current.events.push_back({name, 'C', now, {}, value, threadNumber()});
+}
+
+void Instrumentation::writeTrace(std::ostream &output) {
+    Recording &current = getRecording();
+    const std::lock_guard<std::mutex> lock(current.mutex);
+    json events = json::array();
+    for(const Event &event : current.events) {
+        json traceEvent = {{"name", event.name}, {"ph", std::string(1, event.type)}, {"ts", microseconds(event.start - current.origin)},
+                           {"pid", 1}, {"tid", event.thread}};
+        if(event.type == 'X') traceEvent["dur"] = microseconds(event.duration);
+        else traceEvent["args"] = {{"value", event.value}};
+        events.push_back(traceEvent);
+    }
+    output << json{{"traceEvents", events}, {"displayTimeUnit", "ms"}}.dump() << std::endl;
+}
+
+void Instrumentation::writeSummary(std::ostream &output) {
+    Recording &current = getRecording();
+    const std::lock_guard<std::mutex> lock(current.mutex);
+    std::map<std::string, std::pair<unsigned int, Clock::duration>> phases;
+    std::map<std::string, std::pair<double, double>> counters;
+    for(const Event &event : current.events) {
+        if(event.type == 'X') {
+            auto &[count, duration] = phases[event.name];
+            count++;
+            duration += event.duration;
+        }
+        else {
+            const auto found = counters.find(event.name);
+            if(found == counters.end()) counters.insert({event.name, {event.value, event.value}});
+            else found->second = {event.value, std::max(found->second.second, event.value)};
+        }
+    }
+    json summary = {{"phases", json::object()}, {"counters", json::object()}};
+    for(const auto &[name, phase] : phases) {
+        summary["phases"][name] = {{"count", phase.first}, {"seconds", std::chrono::duration<double>(phase.second).count()}};
+    }
+    for(const auto &[name, counter] : counters) summary["counters"][name] = {{"last", counter.first}, {"peak", counter.second}};
+    output << summary.dump(4) << std::endl;
+}
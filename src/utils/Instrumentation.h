@@ -0,0 +1,67 @@
+//
+
+#ifndef VOXELFUSION_INSTRUMENTATION_H
+#define VOXELFUSION_INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+/**
+ * @brief Records how long the phases of the pipeline take and the values of counters, from any thread, while recording.
+ * The phases and counters inside the pipeline are marked with INSTRUMENT_SCOPE and INSTRUMENT_COUNTER,
+ * which are left out completely unless VOXELFUSION_INSTRUMENTATION is defined
+ */
+class Instrumentation {
+    inline static std::atomic<bool> recording = false;
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * @brief Forgets everything recorded so far and starts recording
+     */
+    static void start();
+    static void stop() {recording = false;}
+    static bool isRecording() {return recording.load(std::memory_order_relaxed);}
+
+    static void addSpan(const char *name, Clock::time_point start, Clock::time_point end);
+    static void addCounter(const char *name, double value);
+
+    /**
+     * @brief Writes everything recorded as Chrome trace events, which chrome://tracing and Perfetto show as a timeline
+     */
+    static void writeTrace(std::ostream &output);
+    /**
+     * @brief Writes a JSON object with the number of times every phase ran and its total duration in seconds,
+     * and the last and highest value of every counter
+     */
+    static void writeSummary(std::ostream &output);
+};
+
+/**
+ * @brief Records the time from its construction to its destruction as a phase, if recording when it is made
+ */
+class ScopedTimer {
+    const char *const name;
+    const Instrumentation::Clock::time_point start;
+public:
+    explicit ScopedTimer(const char *name)
+    : name(name), start(Instrumentation::isRecording() ? Instrumentation::Clock::now() : Instrumentation::Clock::time_point()) {}
+    ~ScopedTimer() {
+        if(start != Instrumentation::Clock::time_point()) Instrumentation::addSpan(name, start, Instrumentation::Clock::now());
+    }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer& operator=(const ScopedTimer &) = delete;
+};
+
+#ifdef VOXELFUSION_INSTRUMENTATION
+#define INSTRUMENT_CONCAT_(first, second) first##second
+#define INSTRUMENT_CONCAT(first, second) INSTRUMENT_CONCAT_(first, second)
+#define INSTRUMENT_SCOPE(name) const ScopedTimer INSTRUMENT_CONCAT(scopedTimer, __LINE__)(name)
+#define INSTRUMENT_COUNTER(name, value) do {if(Instrumentation::isRecording()) Instrumentation::addCounter(name, value);} while(false)
+#else
+#define INSTRUMENT_SCOPE(name)
+#define INSTRUMENT_COUNTER(name, value) do {} while(false)
+#endif
+
+#endif //VOXELFUSION_INSTRUMENTATION_H
@@ -16,6 +16,7 @@
 #include <string>
 #include "MTMDTuringMachine/TMTape.h"
 #include "PerlinNoise.h"
+#include "Instrumentation.h"
 #include "json.hpp"
 
 using json = nlohmann::json;
@@ -169,6 +170,7 @@ bool utils::voxelTriangleIntersection(const int& x, const int& y, const int& z,
     return true;
 }
 void utils::voxelise(const Mesh& mesh, VoxelSpace& voxelSpace, double voxelSize){
+    INSTRUMENT_SCOPE("voxelise");
     BoundingBox bbox = calculateBoundingBox(mesh); // The box won't be shifted!
 
     // Calculate the offset for each dimension
@@ -210,6 +212,7 @@ void utils::voxelise(const Mesh& mesh, VoxelSpace& voxelSpace, double voxelSize)
 }
 
 void utils::voxelSpaceToTape(const VoxelSpace& voxelSpace, TMTape3D& tape, const std::string& fillSymbol, bool edge){
+    INSTRUMENT_SCOPE("tape conversion");
     unsigned int counter = 0;
     if(!edge) { // Yes, the code is almost the same, but otherwise it would be a mess
         for (unsigned int x = 0; x < voxelSpace.size(); x++) {
@@ -294,8 +297,10 @@ void utils::voxelSpaceToTape(const VoxelSpace& voxelSpace, TMTape3D& tape, const
         // Bottom plane end
     }
     std::cout << "Filled blocks in voxelSpaceToTape: " << counter << std::endl;
+    INSTRUMENT_COUNTER("filled voxels", counter);
 }
 void utils::completedVoxelSpaceToTape(const CompletedVoxelSpace &voxelSpace, TMTape3D &tape){
+    INSTRUMENT_SCOPE("tape conversion");
     for (unsigned int x = 0; x < voxelSpace.size(); x++) {
         TMTape2D TMPlane;
         for (unsigned int y = 0; y < voxelSpace[x].size(); y++) {
@@ -507,6 +512,7 @@ std::string utils::getBoomScriptForTape(TMTape3D& tape, unsigned int numberOfSte
     return code;
 }
 void utils::tapeToCompletedVoxelSpace(const TMTape3D& tape, CompletedVoxelSpace& voxelSpace){
+    INSTRUMENT_SCOPE("tape conversion");
     CompletedVoxelSpace toReturn;
     for(auto& plane:tape.getCells()){
         std::vector<std::vector<std::string>> planeStrings;